@@ -4,6 +4,7 @@
  * See COPYRIGHT in top-level directory.
  */
 #include <ams/Admin.hpp>
+#include <ams/ServiceDirectory.hpp>
 #include <tclap/CmdLine.h>
 #include <iostream>
 #include <fstream>
@@ -27,22 +28,6 @@ static std::string g_log_level = "info";
 
 static void parse_command_line(int argc, char** argv);
 
-static std::string read_nth_line(const std::string& filename, int n)
-{
-   std::ifstream in(filename.c_str());
-
-   std::string s;
-   //for performance
-   s.reserve(200);
-
-   //skip N lines
-   for(int i = 0; i < n; ++i)
-       std::getline(in, s);
-
-   std::getline(in,s);
-   return s;
-}
-
 int main(int argc, char** argv) {
     parse_command_line(argc, argv);
     ofstream addr_file;
@@ -50,12 +35,12 @@ int main(int argc, char** argv) {
     tl::engine engine(g_protocol, THALLIUM_CLIENT_MODE);
     addr_file.open("nodes.mercury", ios::app);
 
+    // Initialize an Admin, which looks up each address once
+    ams::Admin admin(engine);
+
     for(int i = 0; i < n_ranks; i++) {
 	    try {
 
-        	// Initialize an Admin
-	        ams::Admin admin(engine);
-
 	        if(g_operation == "create") {
         	    auto id = admin.createNode(g_addresses[i], g_provider_id,
 	                g_type, g_config, g_token);
@@ -108,19 +93,9 @@ void parse_command_line(int argc, char** argv) {
         cmd.parse(argc, argv);
 
         g_address_file = addressArg.getValue();
-	std::string n_ranks_str = read_nth_line(g_address_file, 0);
-        std::stringstream s_(n_ranks_str);
-        s_ >> n_ranks;
-
-	for(int i = 0; i < n_ranks; i++) {
-		size_t pos = 0;
-		std::string delimiter = " ";
-		std::string l = read_nth_line(g_address_file, i+1);
-		pos = l.find(delimiter);
-		std::string server_rank_str = l.substr(0, pos);
-		l.erase(0, pos + delimiter.length());
-		g_addresses.push_back(l);
-	}
+	for(auto& member : ams::ServiceDirectory::load(g_address_file).members())
+		g_addresses.push_back(member.address);
+	n_ranks = (int)g_addresses.size();
 
         g_provider_id = providerArg.getValue();
         g_token = tokenArg.getValue();
@@ -133,5 +108,8 @@ void parse_command_line(int argc, char** argv) {
     } catch(TCLAP::ArgException &e) {
         std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
         exit(-1);
+    } catch(const ams::Exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        exit(-1);
     }
 }
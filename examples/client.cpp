@@ -4,6 +4,8 @@
  * See COPYRIGHT in top-level directory.
  */
 #include <ams/Client.hpp>
+#include <ams/RenderRouter.hpp>
+#include <ams/ServiceDirectory.hpp>
 #include <tclap/CmdLine.h>
 #include <iostream>
 #include <assert.h>
@@ -15,33 +17,18 @@
 
 namespace tl = thallium;
 using namespace conduit;
-int use_local = 0;
 
 static std::string g_address_file;
 static std::string g_address;
 static std::string g_protocol;
 static std::string g_node;
 static unsigned    g_provider_id;
+static unsigned    g_timesteps;
+static unsigned    g_max_in_flight;
 static std::string g_log_level = "info";
 
 static void parse_command_line(int argc, char** argv);
 
-static std::string read_nth_line(const std::string& filename, int n)
-{
-   std::ifstream in(filename.c_str());
-
-   std::string s;
-   //for performance
-   s.reserve(200);
-
-   //skip N lines
-   for(int i = 0; i < n; ++i)
-       std::getline(in, s);
-
-   std::getline(in,s);
-   return s;
-}
-
 int main(int argc, char** argv) {
     MPI_Init(&argc, &argv);
     parse_command_line(argc, argv);
@@ -69,11 +56,19 @@ int main(int argc, char** argv) {
 	n["runtime/type"] = "ascent";
 	//n["runtime/vtkm/backend"] = "openmp";
 
-	if(!use_local) {
-		node.ams_open(n);
-	} else {
-		a.open(n);
-	}
+	/* Timesteps are rendered in transit unless the server falls
+	 * behind, in which case they are rendered with a local Ascent.
+	 * The ranks decide together, since the local Ascent renders
+	 * on MPI_COMM_WORLD. */
+	ams::RenderRouterConfig router_config;
+	router_config.max_in_flight = g_max_in_flight;
+	ams::RenderRouter router(node,
+		[&a](const Node& open_opts, const Node& bp_mesh, const Node& actions) {
+			a.open(open_opts);
+			a.publish(bp_mesh);
+			a.execute(actions);
+			a.close();
+		}, router_config, MPI_COMM_WORLD);
 
 	MPI_Barrier(MPI_COMM_WORLD);
 
@@ -84,13 +79,6 @@ int main(int argc, char** argv) {
                         	                      32,
                                 	              mesh);
 
-
-	/*if(!use_local) {
-		node.ams_publish(mesh);
-	} else {
-		a.publish(mesh);
-	}*/
-
 	Node actions;
     	Node &add_act = actions.append();
 	add_act["action"] = "add_queries";
@@ -114,23 +102,18 @@ int main(int argc, char** argv) {
 
 	MPI_Barrier(MPI_COMM_WORLD);
 
-	/*if(!use_local) {
-		node.ams_execute(actions);
-	} else {
-		a.execute(actions);
-	}*/
-
-	if(!use_local) {
-		node.ams_publish_and_execute(mesh, actions);
+	for(unsigned ts = 0; ts < g_timesteps; ts++) {
+		router.submit(n, mesh, actions, ts);
 	}
+	router.flush();
 
 	MPI_Barrier(MPI_COMM_WORLD);
 
-	if(!use_local) {
-		node.ams_close();
-	} else {
-		a.close();
-	}
+	const ams::RenderRouterStats& stats = router.stats();
+	std::cout << "rank " << rank << ": " << stats.in_transit << " in transit ("
+	          << stats.probes << " probes, " << stats.in_transit_seconds << " s), "
+	          << stats.inline_renders << " inline (" << stats.inline_seconds << " s), "
+	          << stats.switches << " switches" << std::endl;
 
     } catch(const ams::Exception& ex) {
         std::cerr << ex.what() << std::endl;
@@ -153,32 +136,38 @@ void parse_command_line(int argc, char** argv) {
         TCLAP::ValueArg<unsigned>    providerArg("p", "provider", "Provider id to contact (default 0)", false, 0, "int");
         TCLAP::ValueArg<std::string> nodeArg("r","node","Node id", true, ams::UUID().to_string(),"string");
         TCLAP::ValueArg<std::string> logLevel("v","verbose", "Log level (trace, debug, info, warning, error, critical, off)", false, "info", "string");
+        TCLAP::ValueArg<unsigned>    timestepsArg("t","timesteps","Number of timesteps (default 1)", false, 1, "int");
+        TCLAP::ValueArg<unsigned>    windowArg("w","window","Maximum number of timesteps in flight (default 2)", false, 2, "int");
         cmd.add(addressArg);
         cmd.add(providerArg);
         cmd.add(nodeArg);
         cmd.add(logLevel);
+        cmd.add(timestepsArg);
+        cmd.add(windowArg);
         cmd.parse(argc, argv);
 
-	/* The logic below grabs the server address corresponding the client's MPI rank (MXM case) */
-	size_t pos = 0;
+	/* The server rank matching the client's MPI rank (MXM case). The
+	 * address and node files are read by rank 0 and broadcast. */
         g_address_file = addressArg.getValue();
-	std::string delimiter = " ";
-	std::string l = read_nth_line(g_address_file, rank+1);
-	pos = l.find(delimiter);
-	std::string server_rank_str = l.substr(0, pos);
-	std::stringstream s_(server_rank_str);
-	int server_rank;
-	s_ >> server_rank;
-	assert(server_rank == rank);
-	l.erase(0, pos + delimiter.length());
-	g_address = l;
+	ams::ServiceDirectory directory = ams::ServiceDirectory::load(
+		g_address_file, nodeArg.getValue(), MPI_COMM_WORLD);
+	if((size_t)rank >= directory.size())
+		throw ams::Exception("No server rank for client rank " + std::to_string(rank));
+	const ams::ServiceMember& server = directory[rank];
+	assert(server.instance_rank == rank);
+	g_address = server.address;
+	g_node = server.node_id.to_string();
 
         g_provider_id = providerArg.getValue();
-        g_node = read_nth_line(nodeArg.getValue(), rank);
         g_log_level = logLevel.getValue();
+        g_timesteps = timestepsArg.getValue();
+        g_max_in_flight = windowArg.getValue();
         g_protocol = g_address.substr(0, g_address.find(":"));
     } catch(TCLAP::ArgException &e) {
         std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
         exit(-1);
+    } catch(const ams::Exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        exit(-1);
     }
 }
@@ -0,0 +1,421 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <ams/Client.hpp>
+#include <tclap/CmdLine.h>
+#include <nlohmann/json.hpp>
+#include <conduit.hpp>
+#include <conduit_blueprint.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+/*
+ * Multi-tenant workload generator. Replays a recorded or synthetic
+ * arrival trace against a running set of providers, using one client
+ * engine per tenant, and reports per-tenant acknowledgement latency
+ * percentiles (until every rank has queued the timestep), the load of
+ * the server ranks over time (see NodeHandle::ams_get_load) and,
+ * optionally, per-tenant render latency (from arrival on a server rank
+ * to the end of its rendering, on the slowest rank) and server idle
+ * time computed from the <rank>_server_state.txt files written by the
+ * server.
+ *
+ * Like the simulations they stand for, tenants send every timestep to
+ * every rank of the instance: the number of ranks of a tenant must be
+ * the size of the instance.
+ *
+ * Trace format (JSON):
+ *
+ * {
+ *   "sample_interval_ms" : 100,
+ *   "tenants" : [
+ *     { "name" : "sim0", "ranks" : 4, "first_server_rank" : 0,
+ *       "cadence_ms" : 500, "jitter_ms" : 50, "start_ms" : 0,
+ *       "timesteps" : 100, "mesh_size" : 32, "actions" : "queries" },
+ *     { "name" : "sim1", "ranks" : 4, "mesh_size" : 64, "actions" : "render",
+ *       "arrivals_ms" : [ 0, 350, 900, 1200 ] }
+ *   ]
+ * }
+ *
+ * "actions" is either a preset ("none", "queries", "render") or an
+ * Ascent action list given inline as JSON. If "arrivals_ms" is present,
+ * it replaces the cadence/jitter/timesteps description of the tenant.
+ * "ranks" defaults to the instance size and may not differ from it;
+ * "first_server_rank" rotates the mapping of tenant ranks to server ranks.
+ */
+
+namespace tl = thallium;
+using json = nlohmann::json;
+using clock_type = std::chrono::steady_clock;
+
+static std::string g_address_file;
+static std::string g_node_file;
+static std::string g_trace_file;
+static std::string g_output_prefix;
+static std::string g_server_state_dir;
+static unsigned    g_provider_id;
+
+static void parse_command_line(int argc, char** argv);
+
+struct Tenant {
+    std::string           name;
+    int                   task_id;
+    int                   ranks;
+    int                   first_server_rank;
+    std::vector<double>   arrivals_ms;
+    int                   mesh_size;
+    conduit::Node         actions;
+
+    std::vector<double>   latencies;
+    unsigned              late = 0;
+    unsigned              failed = 0;
+};
+
+static std::vector<std::string> read_lines(const std::string& filename) {
+    std::vector<std::string> lines;
+    std::ifstream in(filename.c_str());
+    std::string s;
+    while(std::getline(in, s))
+        lines.push_back(s);
+    return lines;
+}
+
+static void make_actions(const json& desc, conduit::Node& actions) {
+    if(!desc.is_string()) {
+        actions.parse(desc.dump(), "json");
+        return;
+    }
+    std::string preset = desc.get<std::string>();
+    if(preset == "none") {
+        actions.set(conduit::DataType::list());
+    } else if(preset == "queries") {
+        conduit::Node &add_act = actions.append();
+        add_act["action"] = "add_queries";
+        conduit::Node &queries = add_act["queries"];
+        queries["q1/params/expression"] = "binning('radial','max', [axis('x',num_bins=20)])";
+        queries["q1/params/name"] = "1d_binning";
+        queries["q2/params/expression"] = "binning('radial','max', [axis('x',num_bins=20), axis('y',num_bins=20)])";
+        queries["q2/params/name"] = "2d_binning";
+    } else if(preset == "render") {
+        conduit::Node &add_act = actions.append();
+        add_act["action"] = "add_scenes";
+        conduit::Node &scenes = add_act["scenes"];
+        scenes["s1/plots/p1/type"] = "pseudocolor";
+        scenes["s1/plots/p1/field"] = "braid";
+        scenes["s1/image_prefix"] = "loadgen_%04d";
+    } else {
+        throw std::runtime_error("Unknown action preset " + preset);
+    }
+}
+
+static std::vector<double> make_arrivals(const json& desc, std::mt19937& rng) {
+    std::vector<double> arrivals;
+    double start = desc.value("start_ms", 0.0);
+    if(desc.count("arrivals_ms")) {
+        for(auto& a : desc["arrivals_ms"])
+            arrivals.push_back(start + a.get<double>());
+        return arrivals;
+    }
+    double cadence = desc.value("cadence_ms", 1000.0);
+    double jitter = desc.value("jitter_ms", 0.0);
+    int timesteps = desc.value("timesteps", 10);
+    std::uniform_real_distribution<double> noise(-jitter, jitter);
+    for(int i = 0; i < timesteps; i++) {
+        double t = start + i*cadence + (jitter > 0.0 ? noise(rng) : 0.0);
+        arrivals.push_back(std::max(t, 0.0));
+    }
+    std::sort(arrivals.begin(), arrivals.end());
+    return arrivals;
+}
+
+static double percentile(std::vector<double> v, double p) {
+    if(v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t i = (size_t)std::min((double)(v.size()-1), p*(double)(v.size()-1) + 0.5);
+    return v[i];
+}
+
+static void run_tenant(Tenant& tenant,
+                       const std::vector<std::string>& addresses,
+                       const std::vector<std::string>& node_ids,
+                       clock_type::time_point t0) {
+    std::string protocol = addresses[0].substr(0, addresses[0].find(":"));
+    tl::engine engine(protocol, THALLIUM_CLIENT_MODE, true);
+    {
+        ams::Client client(engine);
+        std::vector<ams::NodeHandle> nodes;
+        for(int r = 0; r < tenant.ranks; r++) {
+            int server_rank = (tenant.first_server_rank + r) % addresses.size();
+            nodes.push_back(client.makeNodeHandle(addresses[server_rank], g_provider_id,
+                            ams::UUID::from_string(node_ids[server_rank].c_str())));
+        }
+
+        conduit::Node mesh;
+        conduit::blueprint::mesh::examples::braid("hexs",
+                tenant.mesh_size, tenant.mesh_size, tenant.mesh_size, mesh);
+        size_t mesh_size = mesh.total_bytes_compact();
+
+        conduit::Node open_opts;
+        open_opts["runtime/type"] = "ascent";
+        open_opts["task_id"] = tenant.task_id;
+
+        for(unsigned ts = 0; ts < tenant.arrivals_ms.size(); ts++) {
+            auto arrival = t0 + std::chrono::duration_cast<clock_type::duration>(
+                    std::chrono::duration<double, std::milli>(tenant.arrivals_ms[ts]));
+            if(clock_type::now() > arrival)
+                tenant.late += 1;
+            else
+                std::this_thread::sleep_until(arrival);
+
+            mesh["state/cycle"] = ts;
+            auto start = clock_type::now();
+            std::vector<ams::AsyncRequest> requests(nodes.size());
+            for(size_t r = 0; r < nodes.size(); r++)
+                nodes[r].ams_open_publish_execute(open_opts, mesh, mesh_size, tenant.actions, ts, &requests[r]);
+            for(auto& request : requests) {
+                try {
+                    request.wait();
+                } catch(const ams::Exception&) {
+                    tenant.failed += 1;
+                }
+            }
+            tenant.latencies.push_back(
+                    std::chrono::duration<double>(clock_type::now() - start).count());
+        }
+    }
+    engine.finalize();
+}
+
+/* Records of the server state files appended since the load generator
+ * started, as "<code>,<time>,<task_id>,<ts>" (see DummyNode::enqueue) */
+struct StateRecord {
+    int      code;
+    double   time;
+    int      task_id;
+    unsigned ts;
+};
+
+static std::vector<std::vector<StateRecord>> read_state_records(const std::vector<size_t>& skip_lines) {
+    std::vector<std::vector<StateRecord>> records(skip_lines.size());
+    for(size_t rank = 0; rank < skip_lines.size(); rank++) {
+        auto lines = read_lines(g_server_state_dir + "/" + std::to_string(rank) + "_server_state.txt");
+        for(size_t i = skip_lines[rank]; i < lines.size(); i++) {
+            StateRecord r;
+            if(sscanf(lines[i].c_str(), "%d,%lf,%d,%u", &r.code, &r.time, &r.task_id, &r.ts) != 4) continue;
+            records[rank].push_back(r);
+        }
+    }
+    return records;
+}
+
+/* Busy time is the sum of [3,0] intervals (Ascent execution) */
+static void report_idle_time(const std::vector<std::vector<StateRecord>>& records) {
+    for(size_t rank = 0; rank < records.size(); rank++) {
+        double first = -1.0, last = -1.0, busy = 0.0, exec_start = -1.0;
+        for(auto& r : records[rank]) {
+            if(first < 0.0) first = r.time;
+            last = r.time;
+            if(r.code == 3) exec_start = r.time;
+            if(r.code == 0 && exec_start >= 0.0) {
+                busy += r.time - exec_start;
+                exec_start = -1.0;
+            }
+        }
+        if(first < 0.0) continue;
+        double span = last - first;
+        std::cout << "server rank " << rank << ": span " << span << " s, busy " << busy
+                  << " s, idle " << (span - busy) << " s ("
+                  << (span > 0.0 ? 100.0*(span - busy)/span : 0.0) << "%)" << std::endl;
+    }
+}
+
+/* Render latency of each timestep of a tenant: on each rank, from the
+ * arrival of the request to the end of its rendering ("1" to "0"
+ * records, both on the rank's clock), then the largest over the ranks.
+ * Timesteps that were not rendered on every rank are left out. */
+static std::vector<double> render_latencies(const std::vector<std::vector<StateRecord>>& records,
+                                            const Tenant& tenant) {
+    std::vector<double> latencies;
+    for(unsigned ts = 0; ts < tenant.arrivals_ms.size(); ts++) {
+        double latency = 0.0;
+        bool complete = true;
+        for(auto& rank_records : records) {
+            double arrival = -1.0, end = -1.0;
+            for(auto& r : rank_records) {
+                if(r.task_id != tenant.task_id || r.ts != ts) continue;
+                if(r.code == 1 && arrival < 0.0) arrival = r.time;
+                if(r.code == 0) end = r.time;
+            }
+            if(arrival < 0.0 || end < 0.0) {
+                complete = false;
+                break;
+            }
+            latency = std::max(latency, end - arrival);
+        }
+        if(complete) latencies.push_back(latency);
+    }
+    return latencies;
+}
+
+int main(int argc, char** argv) {
+    parse_command_line(argc, argv);
+
+    auto addr_lines = read_lines(g_address_file);
+    auto node_ids = read_lines(g_node_file);
+    std::vector<std::string> addresses;
+    for(size_t i = 1; i < addr_lines.size(); i++) {
+        auto& l = addr_lines[i];
+        addresses.push_back(l.substr(l.find(" ") + 1));
+    }
+    if(addresses.empty() || node_ids.size() < addresses.size()) {
+        std::cerr << "error: address file and node file are inconsistent" << std::endl;
+        exit(-1);
+    }
+
+    json trace;
+    std::ifstream trace_in(g_trace_file.c_str());
+    trace_in >> trace;
+    double sample_interval_ms = trace.value("sample_interval_ms", 100.0);
+
+    std::mt19937 rng(trace.value("seed", 1234u));
+    std::vector<std::unique_ptr<Tenant>> tenants;
+    for(auto& desc : trace["tenants"]) {
+        std::unique_ptr<Tenant> tenant(new Tenant);
+        tenant->task_id = tenants.size();
+        tenant->name = desc.value("name", "tenant" + std::to_string(tenant->task_id));
+        tenant->ranks = desc.value("ranks", (int)addresses.size());
+        if(tenant->ranks != (int)addresses.size()) {
+            /* The server ranks render each timestep together: ranks that
+             * get no request, or two, would stall the instance */
+            std::cerr << "error: tenant " << tenant->name << " has " << tenant->ranks
+                      << " ranks, the instance has " << addresses.size() << std::endl;
+            exit(-1);
+        }
+        tenant->first_server_rank = desc.value("first_server_rank", 0);
+        tenant->mesh_size = desc.value("mesh_size", 32);
+        tenant->arrivals_ms = make_arrivals(desc, rng);
+        make_actions(desc.count("actions") ? desc["actions"] : json("queries"), tenant->actions);
+        tenants.push_back(std::move(tenant));
+    }
+
+    std::vector<size_t> skip_lines;
+    if(!g_server_state_dir.empty()) {
+        for(size_t rank = 0; rank < addresses.size(); rank++)
+            skip_lines.push_back(read_lines(g_server_state_dir + "/" + std::to_string(rank) + "_server_state.txt").size());
+    }
+
+    auto t0 = clock_type::now() + std::chrono::milliseconds(100);
+    std::vector<std::thread> threads;
+    for(auto& tenant : tenants)
+        threads.emplace_back(run_tenant, std::ref(*tenant), std::cref(addresses), std::cref(node_ids), t0);
+
+    /* Sample the load of the server ranks until all tenants are done */
+    std::atomic<bool> done{false};
+    std::thread sampler([&]() {
+        std::string protocol = addresses[0].substr(0, addresses[0].find(":"));
+        tl::engine engine(protocol, THALLIUM_CLIENT_MODE, true);
+        {
+            ams::Client client(engine);
+            std::vector<ams::NodeHandle> nodes;
+            for(size_t rank = 0; rank < addresses.size(); rank++)
+                nodes.push_back(client.makeNodeHandle(addresses[rank], g_provider_id,
+                                ams::UUID::from_string(node_ids[rank].c_str()), false));
+            std::ofstream out((g_output_prefix + "_load.csv").c_str());
+            out << "time";
+            for(size_t rank = 0; rank < nodes.size(); rank++)
+                out << ",queued_" << rank << ",queued_bytes_" << rank
+                    << ",eta_" << rank << ",executing_" << rank;
+            out << "\n";
+            while(!done) {
+                out << std::chrono::duration<double>(clock_type::now() - t0).count();
+                for(auto& node : nodes) {
+                    ams::ServerLoad load;
+                    try {
+                        node.ams_get_load(&load);
+                        out << "," << load.queued_requests << "," << load.queued_bytes
+                            << "," << load.eta << "," << (load.executing ? 1 : 0);
+                    } catch(const ams::Exception&) {
+                        out << ",,,,";
+                    }
+                }
+                out << "\n";
+                std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(sample_interval_ms));
+            }
+        }
+        engine.finalize();
+    });
+
+    for(auto& th : threads) th.join();
+    double elapsed = std::chrono::duration<double>(clock_type::now() - t0).count();
+    done = true;
+    sampler.join();
+
+    std::vector<std::vector<StateRecord>> records;
+    if(!g_server_state_dir.empty())
+        records = read_state_records(skip_lines);
+
+    std::ofstream lat_out((g_output_prefix + "_latency.csv").c_str());
+    lat_out << "tenant,timestep,ack_latency\n";
+    std::cout << "tenant,requests,late,failed,ack_p50,ack_p90,ack_p99,ack_max";
+    if(!records.empty())
+        std::cout << ",rendered,render_p50,render_p90,render_p99,render_max";
+    std::cout << std::endl;
+    for(auto& tenant : tenants) {
+        auto& l = tenant->latencies;
+        for(size_t i = 0; i < l.size(); i++)
+            lat_out << tenant->name << "," << i << "," << l[i] << "\n";
+        std::cout << tenant->name << "," << l.size() << "," << tenant->late << "," << tenant->failed
+                  << "," << percentile(l, 0.5) << "," << percentile(l, 0.9)
+                  << "," << percentile(l, 0.99) << "," << percentile(l, 1.0);
+        if(!records.empty()) {
+            auto r = render_latencies(records, *tenant);
+            std::cout << "," << r.size() << "," << percentile(r, 0.5) << "," << percentile(r, 0.9)
+                      << "," << percentile(r, 0.99) << "," << percentile(r, 1.0);
+        }
+        std::cout << std::endl;
+    }
+    std::cout << "Total replay time: " << elapsed << " s" << std::endl;
+
+    if(!records.empty())
+        report_idle_time(records);
+
+    return 0;
+}
+
+void parse_command_line(int argc, char** argv) {
+    try {
+        TCLAP::CmdLine cmd("Ams multi-tenant load generator", ' ', "0.1");
+        TCLAP::ValueArg<std::string> addressArg("a","address","Server address file", true,"","string");
+        TCLAP::ValueArg<std::string> nodeArg("r","node","Node id file", true,"","string");
+        TCLAP::ValueArg<std::string> traceArg("w","workload","Workload trace (JSON)", true,"","string");
+        TCLAP::ValueArg<unsigned>    providerArg("p", "provider", "Provider id to contact (default 0)", false, 0, "int");
+        TCLAP::ValueArg<std::string> outputArg("o","output","Prefix for the output CSV files", false,"loadgen","string");
+        TCLAP::ValueArg<std::string> stateArg("s","server-state-dir","Directory containing the server state files", false,"","string");
+        cmd.add(addressArg);
+        cmd.add(nodeArg);
+        cmd.add(traceArg);
+        cmd.add(providerArg);
+        cmd.add(outputArg);
+        cmd.add(stateArg);
+        cmd.parse(argc, argv);
+        g_address_file = addressArg.getValue();
+        g_node_file = nodeArg.getValue();
+        g_trace_file = traceArg.getValue();
+        g_provider_id = providerArg.getValue();
+        g_output_prefix = outputArg.getValue();
+        g_server_state_dir = stateArg.getValue();
+    } catch(TCLAP::ArgException &e) {
+        std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+        exit(-1);
+    }
+}
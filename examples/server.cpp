@@ -4,7 +4,7 @@
  * See COPYRIGHT in top-level directory.
  */
 #include <ams/Provider.hpp>
-#include <ams/Admin.hpp>
+#include <ams/Exception.hpp>
 #include <iostream>
 #include <fstream>
 #include <vector>
@@ -20,41 +20,59 @@ static unsigned    g_num_providers = 1;
 static int         g_num_threads = 0;
 static std::string g_log_level = "info";
 static bool        g_use_progress_thread = false;
+static std::string g_backend = "dummy";
+static std::string g_node_config = "{\"path\" : \"mydb\" }";
+static std::string g_mpi_proxy = "primary";
 
 static void parse_command_line(int argc, char** argv);
 
-static void setup_admin_nodes(tl::engine engine, std::string server_addr, int rank, int size) {
-    ofstream addr_file;
-
-    // Initialize the thallium server
-    ams::Admin admin(engine);
-
-    for(int i = 0; i < size; i++) {
-        if(rank == i) {
-	    addr_file.open(getenv("AMS_NODE_ADDR_FILE"), ios::app);
-	    try {
-		    auto id = admin.createNode(server_addr, 0, "dummy", "{\"path\" : \"mydb\" }", "");
-		    // Any of the above functions may throw a ams::Exception
-		    addr_file << id.to_string() << "\n";
-	    } catch(const ams::Exception& ex) {
-	    	    std::cerr << ex.what() << std::endl;
-	            exit(-1);
-	    }
-	    addr_file.close();
-	}
-	MPI_Barrier(MPI_COMM_WORLD);
-    }
+/* Gathers one string per rank of comm on rank 0, in rank order */
+static std::vector<std::string> gather_strings(const std::string& str, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    int length = (int)str.size();
+    std::vector<int> lengths(rank == 0 ? size : 0);
+    MPI_Gather(&length, 1, MPI_INT, lengths.data(), 1, MPI_INT, 0, comm);
+    std::vector<int> offsets(lengths.size(), 0);
+    for(size_t i = 1; i < lengths.size(); i++)
+        offsets[i] = offsets[i-1] + lengths[i-1];
+    std::vector<char> all(rank == 0 ? offsets.back() + lengths.back() : 0);
+    MPI_Gatherv(str.data(), length, MPI_CHAR, all.data(), lengths.data(), offsets.data(),
+                MPI_CHAR, 0, comm);
+    std::vector<std::string> strings;
+    for(size_t i = 0; i < lengths.size(); i++)
+        strings.emplace_back(all.data() + offsets[i], lengths[i]);
+    return strings;
+}
 
+/* Writes one line per rank to a file, from rank 0, in a single open */
+static void write_lines(const char* filename, const std::vector<std::string>& lines,
+                        const std::string& header = "") {
+    ofstream file(filename, ios::app);
+    file << header;
+    for(auto& line : lines)
+        file << line << "\n";
 }
 
 int main(int argc, char** argv) {
-    MPI_Init(&argc, &argv);
-    ofstream addr_file;
     parse_command_line(argc, argv);
-    MPI_Barrier(MPI_COMM_WORLD);
+    /* Providers use MPI from the primary execution stream, from their
+     * own execution stream, or from any RPC handler (see MpiProxy.hpp).
+     * With the default primary proxy, renders run on the primary
+     * stream: use a progress thread (-p) to keep them off the network
+     * progress loop, or the xstream proxy if MPI is SERIALIZED. */
+    int required = MPI_THREAD_FUNNELED, provided;
+    if(g_mpi_proxy == "xstream")
+        required = MPI_THREAD_SERIALIZED;
+    else if(g_mpi_proxy == "none" && g_num_threads > 0)
+        required = MPI_THREAD_MULTIPLE;
+    MPI_Init_thread(&argc, &argv, required, &provided);
+    if(provided < required)
+        std::cerr << "Warning: MPI provides thread level " << provided
+                  << ", " << required << " requested" << std::endl;
     int rank, size;
     int key, color;
-    int new_rank, new_size;
 
     tl::engine engine(g_address, THALLIUM_SERVER_MODE, g_use_progress_thread, g_num_threads);
     std::vector<snt::Provider> providers;
@@ -64,47 +82,42 @@ int main(int argc, char** argv) {
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
-    if(rank == 0) {
-	    addr_file.open(getenv("AMS_SERVER_ADDR_FILE"), ios::app);
-	    addr_file << size << "\n";
-	    addr_file.close();
-    }
-
-   
     int num_instances = std::stoi(std::string(getenv("AMS_NUM_SERVER_INSTANCES")));
 
     if(num_instances == 1) {
-        for(int i = 0; i < size; i++) {
-	    if(rank == i) {
-		    addr_file.open(getenv("AMS_SERVER_ADDR_FILE"), ios::app);
-		    addr_file << rank << " " << (std::string)engine.self() << "\n";
-		    addr_file.close();
-	    }
-	    MPI_Barrier(MPI_COMM_WORLD);
-        }
         MPI_Comm_dup(MPI_COMM_WORLD, &new_comm);
     } else {
         key = rank;
         color = (int)(rank/(size/num_instances));
         MPI_Comm_split(MPI_COMM_WORLD, color, key, &new_comm);
-        MPI_Comm_rank(new_comm, &new_rank);
-
-        for(int i = 0; i < size; i++) {
-	    if(rank == i) {
-		    addr_file.open(getenv("AMS_SERVER_ADDR_FILE"), ios::app);
-		    addr_file << new_rank << " " << (std::string)engine.self() << "\n";
-		    addr_file.close();
-	    }
-	    MPI_Barrier(MPI_COMM_WORLD);
-        }
     }
-       
+
     for(unsigned i=0 ; i < g_num_providers; i++) {
-        providers.emplace_back(engine, i, new_comm);
+        providers.emplace_back(engine, i, new_comm,
+                               "{\"mpi_proxy\" : \"" + g_mpi_proxy + "\"}");
     }
 
-    MPI_Barrier(MPI_COMM_WORLD);
-    setup_admin_nodes(engine, (std::string)engine.self(), rank, size);
+    /* Each rank creates its node locally, then rank 0 writes the
+     * addresses and the node ids, in rank order. The node file is
+     * written last: once it is complete, every node can be used. */
+    std::string node_id;
+    try {
+        node_id = providers[0].createNode(g_backend, g_node_config).to_string();
+    } catch(const ams::Exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    /* Lets clients find the instance's nodes through any of its ranks */
+    for(auto& provider : providers)
+        provider.publishMembership();
+    int new_rank;
+    MPI_Comm_rank(new_comm, &new_rank);
+    auto addresses = gather_strings(std::to_string(new_rank) + " " + (std::string)engine.self(), MPI_COMM_WORLD);
+    auto node_ids = gather_strings(node_id, MPI_COMM_WORLD);
+    if(rank == 0) {
+        write_lines(getenv("AMS_SERVER_ADDR_FILE"), addresses, std::to_string(size) + "\n");
+        write_lines(getenv("AMS_NODE_ADDR_FILE"), node_ids);
+    }
 
     engine.wait_for_finalize();
     MPI_Finalize();
@@ -119,16 +132,25 @@ void parse_command_line(int argc, char** argv) {
         TCLAP::SwitchArg progressThreadArg("p","use-progress-thread","Use a Mercury progress thread", cmd, false);
         TCLAP::ValueArg<int> numThreads("t","num-threads", "Number of threads for RPC handlers", false, 0, "int");
         TCLAP::ValueArg<std::string> logLevel("v","verbose", "Log level (trace, debug, info, warning, error, critical, off)", false, "info", "string");
+        TCLAP::ValueArg<std::string> backendArg("b","backend", "Node type (dummy, null, costmodel)", false, "dummy", "string");
+        TCLAP::ValueArg<std::string> configArg("c","config", "Node configuration", false, g_node_config, "string");
+        TCLAP::ValueArg<std::string> mpiProxyArg("m","mpi-proxy", "Execution stream using MPI (primary, xstream, none)", false, "primary", "string");
         cmd.add(addressArg);
         cmd.add(providersArg);
         cmd.add(numThreads);
         cmd.add(logLevel);
+        cmd.add(backendArg);
+        cmd.add(configArg);
+        cmd.add(mpiProxyArg);
         cmd.parse(argc, argv);
         g_address = addressArg.getValue();
         g_num_providers = providersArg.getValue();
         g_num_threads = numThreads.getValue();
         g_use_progress_thread = progressThreadArg.getValue();
         g_log_level = logLevel.getValue();
+        g_backend = backendArg.getValue();
+        g_node_config = configArg.getValue();
+        g_mpi_proxy = mpiProxyArg.getValue();
     } catch(TCLAP::ArgException &e) {
         std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
         exit(-1);
@@ -0,0 +1,317 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <ams/Scheduler.hpp>
+#include <tclap/CmdLine.h>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <queue>
+#include <vector>
+
+/*
+ * Offline discrete-event simulator of an AMS server instance. Given
+ * per-request arrival times and costs, it replays the way a provider
+ * handles ams_open_publish_execute (handler ULT waits in the Argobots
+ * pool, ingests the mesh, enqueues it and possibly executes the head of
+ * the queue) using the same ams::Scheduler as the DummyNode backend,
+ * and reports idle time, cost and latency for each server mode and
+ * queue policy.
+ *
+ * Handlers ingest meshes concurrently on up to --num-threads execution
+ * streams, but executions are serialized, as they are on the node's
+ * execute lock: a handler that decides to execute waits for the previous
+ * execution to end, and keeps its execution stream until its own ends.
+ *
+ * Trace format (JSON), times in seconds:
+ *
+ * { "requests" : [
+ *     { "tenant" : "sim0", "arrival" : 0.0, "ts" : 0, "cost" : 1.2,
+ *       "ingest" : 0.05, "bytes" : 1048576 },
+ *     ...
+ * ] }
+ *
+ * Alternatively, a <rank>_server_state.txt file produced by the server
+ * can be used as trace: arrivals come from "1" records, ingestion times
+ * from "1"->"2" and execution costs from "3"->"0" intervals.
+ */
+
+using json = nlohmann::json;
+
+static std::string g_trace_file;
+static std::string g_state_file;
+static std::string g_modes;
+static std::string g_policies;
+static unsigned    g_num_xstreams;
+static unsigned    g_num_nodes;
+static unsigned    g_threshold;
+static bool        g_per_tenant;
+
+static void parse_command_line(int argc, char** argv);
+
+struct SimRequest {
+    std::string tenant;
+    double      arrival;
+    unsigned    ts;
+    double      cost;
+    double      ingest;
+    size_t      bytes;
+};
+
+struct SimResult {
+    double              span      = 0.0;
+    double              exec_busy = 0.0;
+    double              busy      = 0.0;
+    std::vector<double> latency;
+};
+
+static std::vector<SimRequest> load_json_trace(const std::string& filename) {
+    json trace;
+    std::ifstream in(filename.c_str());
+    in >> trace;
+    std::vector<SimRequest> requests;
+    for(auto& r : trace["requests"]) {
+        SimRequest req;
+        req.tenant  = r.value("tenant", "default");
+        req.arrival = r.value("arrival", 0.0);
+        req.ts      = r.value("ts", (unsigned)requests.size());
+        req.cost    = r.value("cost", 0.0);
+        req.ingest  = r.value("ingest", 0.0);
+        req.bytes   = r.value("bytes", (size_t)0);
+        requests.push_back(req);
+    }
+    return requests;
+}
+
+static std::vector<SimRequest> load_state_trace(const std::string& filename) {
+    std::vector<SimRequest> requests;
+    std::vector<double> costs;
+    std::ifstream in(filename.c_str());
+    std::string line;
+    double exec_start = -1.0;
+    while(std::getline(in, line)) {
+        int code;
+        double t;
+        if(sscanf(line.c_str(), "%d,%lf", &code, &t) != 2) continue;
+        if(code == 1) {
+            SimRequest req;
+            req.tenant  = "default";
+            req.arrival = t;
+            req.ts      = requests.size();
+            req.cost    = 0.0;
+            req.ingest  = 0.0;
+            req.bytes   = 0;
+            requests.push_back(req);
+        } else if(code == 2 && !requests.empty()) {
+            requests.back().ingest = t - requests.back().arrival;
+        } else if(code == 3) {
+            exec_start = t;
+        } else if(code == 0 && exec_start >= 0.0) {
+            costs.push_back(t - exec_start);
+            exec_start = -1.0;
+        }
+    }
+    /* Executions are not tied to the request that triggered them, so
+     * costs are assigned in order and the mean fills in the rest */
+    double mean = 0.0;
+    for(auto c : costs) mean += c;
+    if(!costs.empty()) mean /= costs.size();
+    for(size_t i = 0; i < requests.size(); i++)
+        requests[i].cost = i < costs.size() ? costs[i] : mean;
+    if(!requests.empty()) {
+        double t0 = requests.front().arrival;
+        for(auto& r : requests) r.arrival -= t0;
+    }
+    return requests;
+}
+
+static SimResult simulate(const std::vector<SimRequest>& requests, const ams::SchedulerConfig& config) {
+
+    enum EventType { ARRIVAL = 0, INGESTED = 1, XSTREAM_FREE = 2 };
+    struct Event {
+        double    time;
+        EventType type;
+        size_t    id; /* request index for ARRIVAL/INGESTED */
+        bool operator<(const Event& other) const {
+            if(time != other.time) return time > other.time;
+            return type > other.type;
+        }
+    };
+
+    SimResult result;
+    result.latency.resize(requests.size(), 0.0);
+
+    std::priority_queue<Event> events;
+    std::deque<size_t> handler_pool; /* handlers waiting for an execution stream */
+    ams::Scheduler<size_t> scheduler(config);
+    unsigned free_xstreams = g_num_xstreams;
+    double now = 0.0;
+    double exec_free = 0.0; /* end of the last execution */
+
+    for(size_t i = 0; i < requests.size(); i++)
+        events.push(Event{requests[i].arrival, ARRIVAL, i});
+
+    auto execute = [&](double t) {
+        size_t r = scheduler.pop();
+        exec_free = std::max(t, exec_free) + requests[r].cost;
+        result.exec_busy += requests[r].cost;
+        result.busy += requests[r].cost;
+        result.latency[r] = exec_free - requests[r].arrival;
+        return exec_free;
+    };
+
+    while(!events.empty()) {
+        Event e = events.top();
+        events.pop();
+        now = e.time;
+        switch(e.type) {
+        case ARRIVAL:
+            handler_pool.push_back(e.id);
+            break;
+        case INGESTED:
+            scheduler.push(e.id, requests[e.id].ts, requests[e.id].bytes);
+            if(scheduler.shouldExecute(handler_pool.size()))
+                events.push(Event{execute(now), XSTREAM_FREE, 0});
+            else
+                events.push(Event{now, XSTREAM_FREE, 0});
+            break;
+        case XSTREAM_FREE:
+            free_xstreams += 1;
+            break;
+        }
+        while(free_xstreams > 0 && !handler_pool.empty()) {
+            size_t id = handler_pool.front();
+            handler_pool.pop_front();
+            free_xstreams -= 1;
+            result.busy += requests[id].ingest;
+            events.push(Event{now + requests[id].ingest, INGESTED, id});
+        }
+    }
+
+    /* The clients call ams_execute_pending_requests once they are done */
+    while(!scheduler.empty())
+        now = execute(now);
+
+    double first = requests.empty() ? 0.0 : requests.front().arrival;
+    for(auto& r : requests) first = std::min(first, r.arrival);
+    result.span = now - first;
+    return result;
+}
+
+static double percentile(std::vector<double> v, double p) {
+    if(v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t i = (size_t)std::min((double)(v.size()-1), p*(double)(v.size()-1) + 0.5);
+    return v[i];
+}
+
+static std::vector<std::string> split(const std::string& s) {
+    std::vector<std::string> result;
+    size_t start = 0, pos;
+    while((pos = s.find(",", start)) != std::string::npos) {
+        result.push_back(s.substr(start, pos - start));
+        start = pos + 1;
+    }
+    result.push_back(s.substr(start));
+    return result;
+}
+
+int main(int argc, char** argv) {
+    parse_command_line(argc, argv);
+
+    std::vector<SimRequest> requests;
+    try {
+        requests = g_state_file.empty() ? load_json_trace(g_trace_file)
+                                        : load_state_trace(g_state_file);
+    } catch(const std::exception& ex) {
+        std::cerr << "error: could not load trace: " << ex.what() << std::endl;
+        exit(-1);
+    }
+
+    std::cout << "mode,policy,requests,span,exec_busy,exec_idle,exec_idle_pct,"
+              << "xstream_idle_pct,node_seconds,lat_mean,lat_p50,lat_p99,lat_max" << std::endl;
+
+    for(auto& mode_name : split(g_modes)) {
+        for(auto& policy_name : split(g_policies)) {
+            ams::SchedulerConfig config;
+            try {
+                config.mode   = ams::parse_server_mode(mode_name);
+                config.policy = ams::parse_queue_policy(policy_name);
+            } catch(const std::exception& ex) {
+                std::cerr << "error: " << ex.what() << std::endl;
+                exit(-1);
+            }
+            config.lazyish_threshold = g_threshold;
+
+            SimResult r = simulate(requests, config);
+
+            double mean = 0.0;
+            for(auto l : r.latency) mean += l;
+            if(!r.latency.empty()) mean /= r.latency.size();
+            double exec_idle = r.span - r.exec_busy;
+            double capacity = r.span * g_num_xstreams;
+
+            std::cout << ams::to_string(config.mode) << "," << ams::to_string(config.policy)
+                      << "," << requests.size() << "," << r.span << "," << r.exec_busy
+                      << "," << exec_idle << "," << (r.span > 0.0 ? 100.0*exec_idle/r.span : 0.0)
+                      << "," << (capacity > 0.0 ? 100.0*(capacity - r.busy)/capacity : 0.0)
+                      << "," << r.span * g_num_nodes
+                      << "," << mean << "," << percentile(r.latency, 0.5)
+                      << "," << percentile(r.latency, 0.99) << "," << percentile(r.latency, 1.0)
+                      << std::endl;
+
+            if(g_per_tenant) {
+                std::map<std::string, std::vector<double>> per_tenant;
+                for(size_t i = 0; i < requests.size(); i++)
+                    per_tenant[requests[i].tenant].push_back(r.latency[i]);
+                for(auto& p : per_tenant) {
+                    std::cout << "  " << p.first << ": p50 " << percentile(p.second, 0.5)
+                              << " p99 " << percentile(p.second, 0.99)
+                              << " max " << percentile(p.second, 1.0) << std::endl;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+void parse_command_line(int argc, char** argv) {
+    try {
+        TCLAP::CmdLine cmd("Ams scheduling simulator", ' ', "0.1");
+        TCLAP::ValueArg<std::string> traceArg("w","workload","Request trace (JSON)", false,"","string");
+        TCLAP::ValueArg<std::string> stateArg("s","server-state","Server state file to use as trace", false,"","string");
+        TCLAP::ValueArg<std::string> modesArg("m","modes","Comma-separated server modes", false,"eager,lazy,lazyish","string");
+        TCLAP::ValueArg<std::string> policiesArg("q","policies","Comma-separated queue policies", false,"timestep,fifo,smallest","string");
+        TCLAP::ValueArg<unsigned>    xstreamsArg("t","num-threads","Number of RPC handler execution streams", false, 1, "int");
+        TCLAP::ValueArg<unsigned>    nodesArg("n","num-nodes","Number of nodes of the instance (for cost)", false, 1, "int");
+        TCLAP::ValueArg<unsigned>    thresholdArg("l","lazyish-threshold","Pending handlers under which LAZYISH executes", false, 5, "int");
+        TCLAP::SwitchArg perTenantArg("T","per-tenant","Report latency percentiles per tenant", cmd, false);
+        cmd.add(traceArg);
+        cmd.add(stateArg);
+        cmd.add(modesArg);
+        cmd.add(policiesArg);
+        cmd.add(xstreamsArg);
+        cmd.add(nodesArg);
+        cmd.add(thresholdArg);
+        cmd.parse(argc, argv);
+        g_trace_file = traceArg.getValue();
+        g_state_file = stateArg.getValue();
+        g_modes = modesArg.getValue();
+        g_policies = policiesArg.getValue();
+        g_num_xstreams = std::max(1u, xstreamsArg.getValue());
+        g_num_nodes = nodesArg.getValue();
+        g_threshold = thresholdArg.getValue();
+        g_per_tenant = perTenantArg.getValue();
+        if(g_trace_file.empty() == g_state_file.empty())
+            throw TCLAP::ArgException("exactly one of --workload and --server-state is required", "workload");
+    } catch(TCLAP::ArgException &e) {
+        std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+        exit(-1);
+    }
+}
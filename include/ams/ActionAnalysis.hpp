@@ -0,0 +1,60 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __AMS_ACTION_ANALYSIS_HPP
+#define __AMS_ACTION_ANALYSIS_HPP
+
+#include <conduit/conduit.hpp>
+#include <set>
+#include <string>
+
+namespace ams {
+
+/**
+ * @brief Parts of a Blueprint mesh that a set of Ascent actions may use.
+ * Names are candidates: they may include words of expressions that are
+ * not fields, which only makes the selection larger.
+ */
+struct FieldSelection {
+    bool                  all = false; /* the analysis could not decide */
+    std::set<std::string> fields;
+    std::set<std::string> topologies;
+};
+
+/**
+ * @brief Collects the fields and topologies referenced by a set of
+ * Ascent actions: pipeline filter parameters, scene plots, extracts,
+ * query and trigger expressions. Whenever the actions may use data
+ * that cannot be determined statically (unknown actions or filters,
+ * extracts of whole meshes, actions read from files), the selection
+ * is marked as "all".
+ *
+ * @param actions Ascent actions.
+ *
+ * @return the selection.
+ */
+FieldSelection analyze_actions(const conduit::Node& actions);
+
+/**
+ * @brief Builds a view of a Blueprint mesh (single or multi-domain)
+ * restricted to a selection: the selected fields, the topologies they
+ * and the selection use, the coordsets of those topologies, and the
+ * sets attached to them. State is always kept. The view references the
+ * mesh's data without copying it.
+ *
+ * @param bp_mesh Blueprint mesh.
+ * @param selection Selection computed by analyze_actions.
+ * @param view Resulting view.
+ *
+ * @return false if nothing could be left out, in which case the view
+ * is not built and bp_mesh should be used as is.
+ */
+bool select_fields(const conduit::Node& bp_mesh,
+                   const FieldSelection& selection,
+                   conduit::Node& view);
+
+}
+
+#endif
@@ -191,6 +191,25 @@ class Admin {
                          const UUID& node_id,
                          const std::string& token="") const;
 
+    /**
+     * @brief Updates the configuration of the target provider without
+     * restarting it. The config string is a JSON merge patch (RFC 7396)
+     * applied to the provider's current configuration, e.g.
+     * { "scheduler": { "mode": "lazy" } }. Only the "scheduler" and
+     * "receive_buffers" settings can change at runtime. Each provider
+     * of an instance must be updated.
+     *
+     * @param address Address of the target provider.
+     * @param provider_id Provider id.
+     * @param config JSON settings to change.
+     *
+     * @return the new configuration of the provider.
+     */
+    std::string updateConfig(const std::string& address,
+                             uint16_t provider_id,
+                             const std::string& config,
+                             const std::string& token="") const;
+
     /**
      * @brief Shuts down the target server. The Thallium engine
      * used by the server must have remote shutdown enabled.
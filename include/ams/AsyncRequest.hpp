@@ -8,6 +8,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace ams {
 
@@ -64,6 +65,37 @@ class AsyncRequest {
      */
     bool completed() const;
 
+    /**
+     * @brief Test if the request has completed, without blocking.
+     * If it has, the request is also waited on, so that its results
+     * are available and errors are reported (by throwing an Exception).
+     *
+     * @return true if the request has completed.
+     */
+    bool test() const;
+
+    /**
+     * @brief Waits for all the valid requests in the vector. If some
+     * of them fail, all the requests are still waited on and the
+     * first error is then rethrown.
+     *
+     * @param requests Requests to wait on.
+     */
+    static void wait_all(const std::vector<AsyncRequest>& requests);
+
+    /**
+     * @brief Waits for any of the valid, not yet completed requests
+     * in the vector to complete, and waits on it. If none has completed
+     * yet, blocks on the first of them, which is therefore not
+     * necessarily the first to complete.
+     *
+     * @param requests Requests to wait on.
+     *
+     * @return the index of the completed request, or requests.size()
+     * if there was no request left to wait on.
+     */
+    static size_t wait_any(const std::vector<AsyncRequest>& requests);
+
     /**
      * @brief Checks if the Collection object is valid.
      */
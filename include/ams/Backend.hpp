@@ -7,9 +7,12 @@
 #define __AMS_BACKEND_HPP
 
 #include <ams/RequestResult.hpp>
+#include <ams/ServerLoad.hpp>
 #include <unordered_set>
 #include <unordered_map>
 #include <functional>
+#include <memory>
+#include <string>
 #include <nlohmann/json.hpp>
 #include <thallium.hpp>
 #include <mpi.h>
@@ -26,6 +29,32 @@ class __AmsBackendRegistration;
 
 namespace ams {
 
+/**
+ * @brief A mesh received by a provider: either serialized
+ * (conduit_base64_json), or laid out according to a compact schema
+ * (conduit JSON schema) in a buffer that the backend keeps a reference
+ * to for as long as it uses the mesh.
+ *
+ * A late-bound mesh (m_pull set) is still on the client: m_pull pulls
+ * it into a buffer, which the backend should do when it is about to
+ * render it. The client is not answered until the backend calls
+ * m_respond, and must not reuse its arrays until then; if the
+ * MeshData is dropped without calling m_respond, the client is told
+ * that the request was dropped.
+ *
+ * If the provider could not receive the mesh, m_error is set instead:
+ * the backend still sees the request, so that every rank of the
+ * instance handles the same requests, and fails it.
+ */
+struct MeshData {
+    std::string                                     m_serialized;
+    std::string                                     m_schema;
+    std::shared_ptr<void>                           m_buffer;
+    std::function<std::shared_ptr<void>()>          m_pull;
+    std::function<void(const RequestResult<bool>&)> m_respond;
+    std::string                                     m_error; // set if the mesh could not be received
+};
+
 /**
  * @brief Interface for node backends. To build a new backend,
  * implement a class MyBackend that inherits from Backend, and put
@@ -72,6 +101,24 @@ class Backend {
      */
     virtual ~Backend() = default;
 
+    /**
+     * @brief Communicator given to the node's calls: a duplicate of
+     * the provider's, made when the node is created or opened, so that
+     * the collectives of different nodes, which yield while waiting
+     * (see Collectives.hpp), are never paired with each other.
+     */
+    MPI_Comm comm() const {
+        return m_comm;
+    }
+
+    /**
+     * @brief Sets the communicator returned by comm(), which the
+     * provider owns. Called by the provider once, before any request.
+     */
+    void setComm(MPI_Comm comm) {
+        m_comm = comm;
+    }
+
     /**
      * @brief Prints Hello World.
      */
@@ -108,9 +155,96 @@ class Backend {
     virtual void ams_execute_pending_requests(thallium::engine& engine, size_t pool_size, MPI_Comm comm) = 0;
 
     /**
-     * @brief Publishes and Executes a set of actions in Ascent.
+     * @brief Parses and queues a mesh along with the options and
+     * actions to render it. The request is executed by ams_schedule
+     * or ams_execute_pending_requests. The provider calls ams_schedule
+     * after every call, so a request failing on one rank must still
+     * take its place in the queue for the ranks to stay in step.
+     */
+    virtual ams::RequestResult<bool> ams_open_publish_execute(std::string open_opts, MeshData bp_mesh, size_t mesh_size, std::string actions, unsigned int ts, size_t pool_size) = 0;
+
+    /**
+     * @brief Executes the request at the head of the queue, depending
+     * on the server mode. Called by the provider after responding to
+     * a request that queued something, so that errors reach the client
+     * before the rendering starts.
+     */
+    virtual void ams_schedule(size_t pool_size, MPI_Comm comm) = 0;
+
+    /**
+     * @brief Applies the scheduling settings of the provider's
+     * configuration ("mode", "policy", "lazyish_threshold" and
+     * optionally "memory_limit", see SchedulerConfig), which override
+     * the node's own. Called when the node is created or opened and
+     * whenever the provider's configuration is updated, possibly while
+     * requests are being handled, and on each rank independently:
+     * backends whose ranks execute together must apply the settings at
+     * a point the ranks agree on. Backends without a scheduler ignore it.
+     */
+    virtual void configureScheduler(const nlohmann::json& /*settings*/) {}
+
+    /**
+     * @brief Current load of the node. Called by control RPCs while
+     * requests are being handled, so it must neither block nor take
+     * the locks that requests hold.
+     */
+    virtual ServerLoad load() const { return ServerLoad(); }
+
+    /**
+     * @brief Keeps a mesh in server memory so that several sets of
+     * actions can be executed on it without resending it.
+     *
+     * @param bp_mesh Received mesh.
+     * @param mesh_size Size of the mesh in bytes.
+     *
+     * @return a RequestResult containing the id of the mesh.
+     */
+    virtual ams::RequestResult<uint64_t> ams_create_mesh(MeshData bp_mesh, size_t mesh_size) = 0;
+
+    /**
+     * @brief Queues the execution of a set of actions on a resident mesh,
+     * in the same way as ams_open_publish_execute.
+     */
+    virtual ams::RequestResult<bool> ams_execute_on_mesh(uint64_t mesh_id, std::string open_opts, std::string actions, unsigned int ts, size_t pool_size) = 0;
+
+    /**
+     * @brief Releases a mesh created by ams_create_mesh. Its memory is
+     * freed once the queued executions that use it have completed.
+     */
+    virtual ams::RequestResult<bool> ams_release_mesh(uint64_t mesh_id) = 0;
+
+    /**
+     * @brief Drops the coordsets and topologies cached for a client
+     * (see SubtreeRefs), whose NodeHandle was destroyed. Backends
+     * without such a cache ignore it.
      */
-    virtual ams::RequestResult<bool> ams_open_publish_execute(std::string open_opts, std::string bp_mesh, size_t mesh_size, std::string actions, unsigned int ts, size_t pool_size, MPI_Comm comm) = 0;
+    virtual void ams_release_subtrees(const std::string& /*client_id*/) {}
+
+    /**
+     * @brief Opens a session, keeping the parsed open options.
+     *
+     * @return a RequestResult containing the id of the session.
+     */
+    virtual ams::RequestResult<uint64_t> ams_open_session(std::string open_opts) = 0;
+
+    /**
+     * @brief Registers a named set of actions in a session, keeping
+     * it parsed.
+     *
+     * @return a RequestResult containing the id of the pipeline.
+     */
+    virtual ams::RequestResult<uint64_t> ams_register_pipeline(uint64_t session_id, std::string name, std::string actions) = 0;
+
+    /**
+     * @brief Same as ams_open_publish_execute, with the open options
+     * and actions registered in a session.
+     */
+    virtual ams::RequestResult<bool> ams_session_publish(uint64_t session_id, uint64_t pipeline_id, MeshData bp_mesh, size_t mesh_size, unsigned int ts, size_t pool_size) = 0;
+
+    /**
+     * @brief Closes a session.
+     */
+    virtual ams::RequestResult<bool> ams_close_session(uint64_t session_id) = 0;
 
     /**
      * @brief Compute the sum of two integers.
@@ -130,6 +264,9 @@ class Backend {
      */
     virtual RequestResult<bool> destroy() = 0;
 
+    private:
+
+    MPI_Comm m_comm = MPI_COMM_NULL;
 };
 
 /**
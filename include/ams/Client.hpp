@@ -7,6 +7,7 @@
 #define __AMS_CLIENT_HPP
 
 #include <ams/NodeHandle.hpp>
+#include <ams/ServiceDirectory.hpp>
 #include <ams/UUID.hpp>
 #include <thallium.hpp>
 #include <memory>
@@ -92,6 +93,22 @@ class Client {
                                       const UUID& node_id,
                                       bool check = true) const;
 
+    /**
+     * @brief Asks a provider for the ranks of its instance, with the
+     * current nodes (the first node of each rank) and load of each,
+     * and for the load of the whole instance. The provider asks every
+     * rank, so that fails if one of them cannot be reached.
+     * Together with TenantPlacement, this replaces the node file: the
+     * address of any rank of each instance is enough.
+     *
+     * @param address Address of a rank of the instance.
+     * @param provider_id Provider id.
+     *
+     * @return the instance.
+     */
+    InstanceInfo getInstance(const std::string& address,
+                             uint16_t provider_id) const;
+
     /**
      * @brief Checks that the Client instance is valid.
      */
@@ -104,6 +121,31 @@ class Client {
      */
     std::string getConfig() const;
 
+    /**
+     * @brief Sets how many bytes of arrays sent by bulk transfer stay
+     * registered (0 by default: arrays are registered for each
+     * request). Arrays that persist across timesteps are then exposed
+     * once rather than at every publish. An application enabling the
+     * cache must call invalidateRegistrations before freeing such an
+     * array, or the server may read stale data from a new array
+     * allocated at the same address.
+     *
+     * @param bytes capacity of the registration cache.
+     */
+    void setRegistrationCacheSize(size_t bytes) const;
+
+    /**
+     * @brief Releases the registrations of the arrays overlapping a
+     * range of memory. Must be called before freeing an array that was
+     * sent by bulk transfer if a new array of the same size may be
+     * allocated at the same address; arrays reallocated with a
+     * different address or size are detected automatically.
+     *
+     * @param ptr start of the range.
+     * @param size size of the range in bytes.
+     */
+    void invalidateRegistrations(const void* ptr, size_t size) const;
+
     private:
 
     Client(const std::shared_ptr<ClientImpl>& impl);
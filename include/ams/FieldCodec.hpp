@@ -0,0 +1,133 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __AMS_FIELD_CODEC_HPP
+#define __AMS_FIELD_CODEC_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ams {
+
+/**
+ * @brief How the values of a field are sent to the server.
+ * - to_float32: float64 values are converted to float32 (lossy).
+ * - compress: numerical values are compressed with the built-in
+ *   lossless codec (see compress_words) and decoded by the server
+ *   before the mesh is published.
+ * - adaptive: each transformation is skipped when, given the measured
+ *   link bandwidth, it costs more time than the transfer it saves.
+ */
+struct FieldTransferOptions {
+    bool to_float32 = false;
+    bool compress   = false;
+    bool adaptive   = true;
+};
+
+/**
+ * @brief Name of the built-in codec, as found in encoded fields.
+ */
+static const char* const word_codec_name = "xor-shuffle-rle";
+
+/* PackBits-style run-length encoding: a control byte c < 128 is
+ * followed by c+1 literal bytes; c >= 128 repeats the next byte
+ * c-126 times (2 to 129). */
+inline void rle_encode(const uint8_t* in, size_t size, std::vector<uint8_t>& out) {
+    size_t i = 0;
+    while(i < size) {
+        size_t run = 1;
+        while(i + run < size && run < 129 && in[i + run] == in[i]) run++;
+        if(run >= 2) {
+            out.push_back((uint8_t)(run + 126));
+            out.push_back(in[i]);
+            i += run;
+            continue;
+        }
+        size_t start = i;
+        while(i < size && i - start < 128) {
+            if(i + 1 < size && in[i + 1] == in[i]) break;
+            i++;
+        }
+        out.push_back((uint8_t)(i - start - 1));
+        out.insert(out.end(), in + start, in + i);
+    }
+}
+
+inline void rle_decode(const uint8_t* in, size_t size, uint8_t* out, size_t out_size) {
+    size_t i = 0, o = 0;
+    while(i < size) {
+        uint8_t c = in[i++];
+        if(c < 128) {
+            size_t n = (size_t)c + 1;
+            if(i + n > size || o + n > out_size)
+                throw std::runtime_error("Corrupted field encoding");
+            std::memcpy(out + o, in + i, n);
+            i += n;
+            o += n;
+        } else {
+            size_t n = (size_t)c - 126;
+            if(i >= size || o + n > out_size)
+                throw std::runtime_error("Corrupted field encoding");
+            std::memset(out + o, in[i++], n);
+            o += n;
+        }
+    }
+    if(o != out_size)
+        throw std::runtime_error("Corrupted field encoding");
+}
+
+/**
+ * @brief Lossless compression of an array of count words of word_size
+ * bytes (1 to 8). Each word is XORed with the previous one, which zeroes
+ * the sign, exponent and leading mantissa bits shared by neighbouring
+ * values of smooth fields; the bytes are then grouped by significance
+ * and run-length encoded.
+ */
+inline std::vector<uint8_t> compress_words(const void* data, size_t count, size_t word_size) {
+    if(word_size == 0 || word_size > 8)
+        throw std::invalid_argument("Unsupported word size " + std::to_string(word_size));
+    const uint8_t* in = static_cast<const uint8_t*>(data);
+    std::vector<uint8_t> planes(count * word_size);
+    uint64_t previous = 0;
+    for(size_t i = 0; i < count; i++) {
+        uint64_t word = 0;
+        std::memcpy(&word, in + i*word_size, word_size);
+        uint64_t delta = word ^ previous;
+        previous = word;
+        for(size_t b = 0; b < word_size; b++)
+            planes[b*count + i] = (uint8_t)(delta >> (8*b));
+    }
+    std::vector<uint8_t> out;
+    out.reserve(planes.size() / 2);
+    rle_encode(planes.data(), planes.size(), out);
+    return out;
+}
+
+/**
+ * @brief Inverse of compress_words. Throws std::runtime_error if the
+ * input does not decode to exactly count words.
+ */
+inline void decompress_words(const uint8_t* in, size_t size, void* data, size_t count, size_t word_size) {
+    if(word_size == 0 || word_size > 8)
+        throw std::invalid_argument("Unsupported word size " + std::to_string(word_size));
+    std::vector<uint8_t> planes(count * word_size);
+    rle_decode(in, size, planes.data(), planes.size());
+    uint8_t* out = static_cast<uint8_t*>(data);
+    uint64_t previous = 0;
+    for(size_t i = 0; i < count; i++) {
+        uint64_t delta = 0;
+        for(size_t b = 0; b < word_size; b++)
+            delta |= (uint64_t)planes[b*count + i] << (8*b);
+        previous ^= delta;
+        std::memcpy(out + i*word_size, &previous, word_size);
+    }
+}
+
+}
+
+#endif
@@ -7,13 +7,17 @@
 #define __AMS_NODE_HANDLE_HPP
 
 #include <thallium.hpp>
+#include <functional>
 #include <memory>
 #include <unordered_set>
 #include <nlohmann/json.hpp>
 #include <ams/Client.hpp>
 #include <ams/Exception.hpp>
 #include <ams/AsyncRequest.hpp>
+#include <ams/FieldCodec.hpp>
+#include <ams/ServerLoad.hpp>
 #include <conduit/conduit.hpp>
+#include <mpi.h>
 
 namespace tl = thallium;
 namespace ams {
@@ -21,6 +25,43 @@ namespace ams {
 class Client;
 class NodeHandleImpl;
 
+/**
+ * @brief What NodeHandle::ams_submit does when the in-flight
+ * window of the NodeHandle is full.
+ * - BLOCK: wait for the oldest in-flight request to complete.
+ * - DROP: skip the timestep.
+ * - FALLBACK: hand the timestep to the fallback function
+ *   (e.g. to render it inline).
+ * When a tenant has several ranks, the DROP and FALLBACK decisions
+ * are collective over the communicator given to setInFlightWindow:
+ * if the window of any rank is full, all of them drop the timestep
+ * or hand it to the fallback function, so that the server never
+ * receives part of a timestep and a fallback rendering on that
+ * communicator is entered by all ranks.
+ */
+enum class WindowPolicy {
+    BLOCK,
+    DROP,
+    FALLBACK
+};
+
+/**
+ * @brief Outcome of NodeHandle::ams_submit.
+ */
+enum class SubmitStatus {
+    SENT,
+    DROPPED,
+    FALLBACK
+};
+
+/**
+ * @brief Function called by NodeHandle::ams_submit for timesteps
+ * that are not sent to the server with the FALLBACK policy.
+ */
+using FallbackFunction = std::function<void(const conduit::Node& open_opts,
+                                            const conduit::Node& bp_mesh,
+                                            const conduit::Node& actions)>;
+
 /**
  * @brief A NodeHandle object is a handle for a remote node
  * on a server. It enables invoking the node's functionalities.
@@ -74,8 +115,10 @@ class NodeHandle {
 
     /**
      * @brief Sends an RPC to the node to make it print a hello message.
+     *
+     * @param[out] req request for a non-blocking operation
      */
-    void sayHello() const;
+    void sayHello(AsyncRequest* req = nullptr) const;
 
     /**
      * @brief Requests the target node to compute the sum of two numbers.
@@ -92,33 +135,45 @@ class NodeHandle {
                     int32_t* result = nullptr,
                     AsyncRequest* req = nullptr) const;
 
+    /*
+     * All the Ascent operations below follow the same convention as
+     * computeSum: if req is null the call blocks and throws an Exception
+     * on failure, otherwise it returns as soon as the request is sent
+     * (the conduit nodes may then be modified) and errors are reported
+     * when waiting on req.
+     */
+
     /**
      * @brief Requests the opening of an ascent operation with a
      * given set of options.
      *
      * @param[in] opts ascent options represented as a conduit::Node
+     * @param[out] req request for a non-blocking operation
      */
-    void ams_open(conduit::Node opts) const;
+    void ams_open(const conduit::Node& opts, AsyncRequest* req = nullptr) const;
 
     /**
      * @brief Requests the publishing of an mesh represented as a conduit Node
      *
      * @param[in] bp_mesh conduit::Node
+     * @param[out] req request for a non-blocking operation
      */
-    void ams_publish(conduit::Node bp_mesh) const;
+    void ams_publish(const conduit::Node& bp_mesh, AsyncRequest* req = nullptr) const;
 
     /**
      * @brief Executes pending requests
      *
+     * @param[out] req request for a non-blocking operation
      */
-    void ams_execute_pending_requests() const;
+    void ams_execute_pending_requests(AsyncRequest* req = nullptr) const;
 
     /**
      * @brief Requests the execution of a set of actions represented as a conduit Node
      *
      * @param[in] actions conduit::Node
+     * @param[out] req request for a non-blocking operation
      */
-    void ams_execute(conduit::Node actions) const;
+    void ams_execute(const conduit::Node& actions, AsyncRequest* req = nullptr) const;
 
     /**
      * @brief Requests the publishing of a mesh and the execution of a set of actions represented as a conduit Node
@@ -126,31 +181,303 @@ class NodeHandle {
      *
      * @param[in] bp_mesh conduit::Node
      * @param[in] actions conduit::Node
+     * @param[out] req request for a non-blocking operation
      */
-    void ams_publish_and_execute(conduit::Node bp_mesh, conduit::Node actions) const;
+    void ams_publish_and_execute(const conduit::Node& bp_mesh, const conduit::Node& actions,
+                                 AsyncRequest* req = nullptr) const;
 
     /**
      * @brief Requests the publishing of a mesh and the execution of a set of actions represented as a conduit Node
-     * as an atomic operation.
+     * as an atomic operation. The server queues the request and responds before executing it.
      *
      * @param[in] open_opts conduit::Node
      * @param[in] bp_mesh conduit::Node
+     * @param[in] mesh_size size of the mesh in bytes (recomputed if fields are pruned)
+     * @param[in] actions conduit::Node
+     * @param[in] ts      timestamp
+     * @param[out] req request for a non-blocking operation
+     */
+    void ams_open_publish_execute(const conduit::Node& open_opts,
+                                  const conduit::Node& bp_mesh,
+                                  size_t mesh_size,
+                                  const conduit::Node& actions,
+                                  unsigned int ts,
+                                  AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Publishes a mesh into the memory of the server, so that
+     * several sets of actions can be executed on it with
+     * ams_execute_on_mesh without sending it again. The mesh counts
+     * towards the server's memory limit until ams_release_mesh is called
+     * and the executions queued on it have completed.
+     *
+     * @param[in] bp_mesh conduit::Node
+     * @param[out] mesh_id id of the resident mesh
+     * @param[out] req request for a non-blocking operation
+     */
+    void ams_create_mesh(const conduit::Node& bp_mesh,
+                         uint64_t* mesh_id,
+                         AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Requests the execution of a set of actions on a mesh
+     * published with ams_create_mesh. The request is queued and
+     * scheduled like those of ams_open_publish_execute, and refused
+     * if the server's memory limit is reached.
+     *
+     * @param[in] mesh_id id of the resident mesh
+     * @param[in] open_opts conduit::Node
      * @param[in] actions conduit::Node
      * @param[in] ts      timestamp
-     * @param[in/out] actions async request
+     * @param[out] req request for a non-blocking operation
+     */
+    void ams_execute_on_mesh(uint64_t mesh_id,
+                             const conduit::Node& open_opts,
+                             const conduit::Node& actions,
+                             unsigned int ts,
+                             AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Releases a mesh published with ams_create_mesh. Queued
+     * executions on the mesh still complete.
+     *
+     * @param[in] mesh_id id of the resident mesh
+     * @param[out] req request for a non-blocking operation
+     */
+    void ams_release_mesh(uint64_t mesh_id, AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Opens a session on the server with a set of Ascent open
+     * options. The server parses the options once and keeps them, along
+     * with the pipelines registered with ams_register_pipeline, until
+     * ams_close_session is called.
+     *
+     * @param[in] open_opts conduit::Node
+     * @param[out] session_id id of the session
+     * @param[out] req request for a non-blocking operation
      */
-    thallium::async_response ams_open_publish_execute(conduit::Node open_opts, 
-		    conduit::Node bp_mesh, 
-		    size_t mesh_size,
-		    conduit::Node actions,
-		    unsigned int ts) const;
+    void ams_open_session(const conduit::Node& open_opts,
+                          uint64_t* session_id,
+                          AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Registers a named set of actions in a session. Registering
+     * a name again replaces its actions and keeps its id.
+     *
+     * @param[in] session_id id of the session
+     * @param[in] name name of the pipeline
+     * @param[in] actions conduit::Node
+     * @param[out] pipeline_id id of the pipeline within the session
+     * @param[out] req request for a non-blocking operation
+     */
+    void ams_register_pipeline(uint64_t session_id,
+                               const std::string& name,
+                               const conduit::Node& actions,
+                               uint64_t* pipeline_id,
+                               AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Same as ams_open_publish_execute, with the open options of
+     * a session and the actions of one of its pipelines.
+     *
+     * @param[in] session_id id of the session
+     * @param[in] pipeline_id id of the pipeline
+     * @param[in] bp_mesh conduit::Node
+     * @param[in] ts      timestamp
+     * @param[out] req request for a non-blocking operation
+     */
+    void ams_session_publish(uint64_t session_id,
+                             uint64_t pipeline_id,
+                             const conduit::Node& bp_mesh,
+                             unsigned int ts,
+                             AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Closes a session. Queued requests of the session still complete.
+     *
+     * @param[in] session_id id of the session
+     * @param[out] req request for a non-blocking operation
+     */
+    void ams_close_session(uint64_t session_id, AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Enables or disables field pruning (enabled by default).
+     * When enabled, the operations that send a mesh along with actions
+     * (ams_publish_and_execute, ams_open_publish_execute, ams_submit
+     * and ams_session_publish) analyze the actions and only send the
+     * fields and topologies they use, unless the analysis cannot decide
+     * (see ams/ActionAnalysis.hpp).
+     *
+     * @param enable whether to prune meshes.
+     */
+    void setFieldPruning(bool enable) const;
+
+    /**
+     * @brief Sets the size from which meshes are sent by bulk transfer
+     * (1 MiB by default): instead of serializing the mesh in the RPC,
+     * the client exposes the mesh's arrays and the server pulls them
+     * into a pooled receive buffer. The arrays must not be modified
+     * until the request completes (ams_submit sends copies). Arrays
+     * are registered for each request, unless the registration cache
+     * is enabled with Client::setRegistrationCacheSize, in which case
+     * arrays of 64 KiB or more stay registered across requests. Use
+     * SIZE_MAX to always serialize meshes.
+     *
+     * @param bytes minimum size of the meshes sent by bulk transfer.
+     */
+    void setBulkThreshold(size_t bytes) const;
+
+    /**
+     * @brief Enables or disables late binding (disabled by default).
+     * When enabled, the meshes that asynchronous ams_open_publish_execute,
+     * ams_session_publish and ams_submit requests send by bulk transfer
+     * are not pulled when the request arrives: the server only queues
+     * their description, and pulls them when it is about to render them.
+     * The requests complete once the server has pulled the mesh, so the
+     * client's arrays (or ams_submit slots) stay in use until then, and
+     * the server does not buffer the queued meshes.
+     *
+     * @param enable whether to enable late binding.
+     */
+    void setLateBinding(bool enable) const;
+
+    /**
+     * @brief Enables or disables the caching of coordsets and
+     * topologies on the server (enabled by default). When enabled,
+     * ams_open_publish_execute, ams_submit and ams_session_publish
+     * send the coordsets and topologies that did not change since the
+     * previous request only once; the following requests refer to the
+     * copy kept by the server, which only drops the copies the client
+     * no longer refers to, and all of them once the last copy of the
+     * NodeHandle is destroyed. A request referring to a copy the server
+     * no longer holds (e.g. after a restart, or when the server keeps
+     * the copies of too many clients) fails with an error, like any
+     * failing request; the next requests send every subtree again.
+     *
+     * @param enable whether to cache coordsets and topologies.
+     * @param min_bytes subtrees smaller than this are always sent.
+     */
+    void setSubtreeCaching(bool enable, size_t min_bytes = 4096) const;
+
+    /**
+     * @brief Sets how the values of a field are sent by
+     * ams_open_publish_execute, ams_submit and ams_session_publish
+     * (see ams/FieldCodec.hpp). The field name "*" applies to the
+     * fields without options of their own. Options that neither
+     * convert nor compress remove the field's options.
+     *
+     * @param field name of the field, or "*".
+     * @param options transfer options.
+     */
+    void setFieldTransfer(const std::string& field,
+                          const FieldTransferOptions& options) const;
+
+    /**
+     * @brief Link bandwidth (in bytes per second) measured on the
+     * requests that send a mesh, from the serialized or exposed mesh
+     * being ready to the response, or 0 if not measured yet.
+     * Asynchronous requests are only measured when waited on before
+     * their response arrives (e.g. ams_submit blocking on a full
+     * window), and late-bound requests are not measured. Adaptive field transfer
+     * options are applied until it is measured.
+     */
+    double linkBandwidth() const;
 
     /**
      * @brief Requests the closing of ascent operation
      *
+     * @param[out] req request for a non-blocking operation
+     */
+    void ams_close(AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Configures the window of outstanding ams_submit requests.
+     * The window defaults to 2 requests with the BLOCK policy. Must
+     * not be called while requests are in flight.
+     *
+     * @param max_in_flight Maximum number of requests in flight (at least 1).
+     * @param policy What to do when the window is full.
+     * @param fallback Function to call with the FALLBACK policy.
+     * @param comm Communicator of the tenant's ranks, which must all
+     * call ams_submit for every timestep. With the DROP and FALLBACK
+     * policies, ams_submit is collective over it.
+     */
+    void setInFlightWindow(size_t max_in_flight,
+                           WindowPolicy policy = WindowPolicy::BLOCK,
+                           FallbackFunction fallback = FallbackFunction(),
+                           MPI_Comm comm = MPI_COMM_SELF) const;
+
+    /**
+     * @brief Submits a timestep for asynchronous visualization through
+     * ams_open_publish_execute, within the in-flight window. The caller
+     * may modify its arrays as soon as this function returns: meshes
+     * below the bulk threshold are serialized before it returns, and
+     * larger ones are copied into one of the window's buffers (reused
+     * across timesteps when the mesh layout does not change) for the
+     * server to pull. Errors of previously submitted requests are
+     * reported (by throwing) when they are reaped, and the timestep is
+     * then not sent. With the DROP and FALLBACK policies, all the ranks
+     * throw if a request failed on any of them.
+     *
+     * @param[in] open_opts conduit::Node
      * @param[in] bp_mesh conduit::Node
+     * @param[in] actions conduit::Node
+     * @param[in] ts      timestamp
+     *
+     * @return whether the timestep was sent, dropped or handed to the fallback.
+     */
+    SubmitStatus ams_submit(const conduit::Node& open_opts,
+                            const conduit::Node& bp_mesh,
+                            const conduit::Node& actions,
+                            unsigned int ts) const;
+
+    /**
+     * @brief Waits for all the requests submitted with ams_submit to complete.
+     */
+    void ams_flush() const;
+
+    /**
+     * @brief Requests the load of the node: queued requests and bytes,
+     * estimated time to drain the queue and whether a request is being
+     * rendered. The server answers without waiting for the rendering
+     * in progress, so this can be polled to decide where to send the
+     * next timestep.
+     *
+     * @param[out] load load of the node
+     * @param[out] req request for a non-blocking operation
+     */
+    void ams_get_load(ServerLoad* load, AsyncRequest* req = nullptr) const;
+
+    /**
+     * @brief Latest load hint the server attached to a response. Hints
+     * are shared by the NodeHandles of a Client targeting the same
+     * server, and refreshed by every answered request at no extra cost.
+     *
+     * @param[out] hint load hint
+     * @param[out] age seconds since the hint was received
+     *
+     * @return false if no hint has been received yet.
+     */
+    bool loadHint(LoadHint& hint, double* age = nullptr) const;
+
+    /**
+     * @brief Number of ams_submit requests currently in flight.
+     * Completed requests are released first, so errors of previously
+     * submitted requests may be reported by throwing.
+     */
+    size_t inFlight() const;
+
+    /**
+     * @brief Maximum number of ams_submit requests in flight.
+     */
+    size_t inFlightWindow() const;
+
+    /**
+     * @brief Smoothed time (in seconds) between the submission of a
+     * request by ams_submit and the moment its completion was observed,
+     * or 0 if no request has completed yet.
      */
-    void ams_close() const;
+    double submitLatency() const;
 
     private:
 
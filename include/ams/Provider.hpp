@@ -6,6 +6,7 @@
 #ifndef __AMS_PROVIDER_HPP
 #define __AMS_PROVIDER_HPP
 
+#include <ams/UUID.hpp>
 #include <thallium.hpp>
 #include <memory>
 #include <mpi.h>
@@ -30,7 +31,8 @@ class Provider {
      * @param engine Thallium engine to use to receive RPCs.
      * @param provider_id Provider id.
      * @param config JSON-formatted configuration.
-     * @param pool Argobots pool to use to handle RPCs.
+     * @param pool Argobots pool to use to handle RPCs, unless the
+     * "pools" entry of the configuration assigns them to other pools.
      */
     Provider(const tl::engine& engine,
              uint16_t provider_id = 0,
@@ -43,7 +45,8 @@ class Provider {
      * @param mid Margo instance id to use to receive RPCs.
      * @param provider_id Provider id.
      * @param config JSON-formatted configuration.
-     * @param pool Argobots pool to use to handle RPCs.
+     * @param pool Argobots pool to use to handle RPCs, unless the
+     * "pools" entry of the configuration assigns them to other pools.
      */
     Provider(margo_instance_id mid,
              uint16_t provider_id = 0,
@@ -55,8 +58,11 @@ class Provider {
      * @param engine Thallium engine to use to receive RPCs.
      * @param provider_id Provider id.
      * @param config JSON-formatted configuration.
-     * @param pool Argobots pool to use to handle RPCs.
-     * @param comm MPI_COMMUNICATOR that this provider uses.
+     * @param pool Argobots pool to use to handle RPCs, unless the
+     * "pools" entry of the configuration assigns them to other pools.
+     * @param comm MPI_COMMUNICATOR that this provider uses. Each node
+     * gets a duplicate of it when it is created or opened, which is
+     * collective: the ranks must create their nodes in the same order.
      */
     Provider(const tl::engine& engine,
              uint16_t provider_id = 0,
@@ -98,7 +104,30 @@ class Provider {
     void setSecurityToken(const std::string& token);
 
     /**
-     * @brief Return a JSON-formatted configuration of the provider.
+     * @brief Creates a node on this provider, as Admin::createNode
+     * would but without an RPC. Throws an ams::Exception on failure.
+     *
+     * @param type Type of the node to create.
+     * @param config JSON configuration for the node.
+     *
+     * @return the UUID of the new node.
+     */
+    UUID createNode(const std::string& type, const std::string& config);
+
+    /**
+     * @brief Makes the provider list every rank of its instance, with
+     * their current nodes and loads, when asked for the service
+     * directory (see Client::getInstance). Collective over the
+     * provider's communicator; only the addresses are gathered, so
+     * nodes added or removed later are listed without calling it
+     * again.
+     */
+    void publishMembership();
+
+    /**
+     * @brief Return a JSON-formatted configuration of the provider,
+     * including the default values of the settings not given to the
+     * constructor and the updates made with Admin::updateConfig.
      *
      * @return JSON formatted string.
      */
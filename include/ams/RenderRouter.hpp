@@ -0,0 +1,206 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __AMS_RENDER_ROUTER_HPP
+#define __AMS_RENDER_ROUTER_HPP
+
+#include <ams/NodeHandle.hpp>
+#include <conduit/conduit.hpp>
+#include <functional>
+#include <mpi.h>
+
+namespace ams {
+
+/**
+ * @brief Path taken by a timestep submitted to a RenderRouter.
+ */
+enum class RenderPath {
+    IN_TRANSIT,
+    INLINE
+};
+
+/**
+ * @brief Function rendering a timestep in the simulation's
+ * own processes (typically with a local ascent::Ascent instance).
+ */
+using InlineFunction = std::function<void(const conduit::Node& open_opts,
+                                          const conduit::Node& bp_mesh,
+                                          const conduit::Node& actions)>;
+
+/**
+ * @brief Tunable parameters of a RenderRouter.
+ */
+struct RenderRouterConfig {
+    size_t   max_in_flight  = 2;    /* in-flight window of the NodeHandle */
+    double   hysteresis     = 0.2;  /* relative cost margin required to switch path */
+    unsigned min_dwell      = 4;    /* timesteps to stay on a path before switching */
+    unsigned probe_interval = 8;    /* inline timesteps between in-transit probes (0: never) */
+    double   smoothing      = 0.25; /* weight of new samples in the cost estimates */
+    double   max_load_age   = 5.0;  /* seconds after which reported server load is ignored */
+    double   load_poll_interval = 0.0; /* seconds between ams_get_load polls (0: never) */
+};
+
+/**
+ * @brief Accounting of the paths taken by a RenderRouter.
+ * Times are the seconds the simulation spent blocked in submit().
+ */
+struct RenderRouterStats {
+    size_t in_transit         = 0; /* timesteps sent to the server (including probes) */
+    size_t inline_renders     = 0; /* timesteps rendered inline */
+    size_t probes             = 0; /* in-transit timesteps sent while on the inline path */
+    size_t switches           = 0; /* number of path changes */
+    double in_transit_seconds = 0.0;
+    double inline_seconds     = 0.0;
+};
+
+/**
+ * @brief A RenderRouter decides, for each timestep, whether to render
+ * it in transit (through NodeHandle::ams_submit) or inline (through a
+ * user-provided function), so that the time the simulation loses to
+ * visualization stays bounded when the shared server instance is
+ * saturated.
+ *
+ * The cost of the in-transit path is the submission overhead plus the
+ * stall the in-flight window is expected to cause, i.e. the predicted
+ * request latency minus the simulation time the window covers. The
+ * predicted latency is the larger of the observed latency of recent
+ * requests and the queue ETA last reported by the server. The cost of
+ * the inline path is the measured inline render time. The router only
+ * changes path when the other one is cheaper by the hysteresis margin
+ * and it has stayed min_dwell timesteps on the current one; while
+ * rendering inline it periodically sends a timestep in transit to
+ * refresh its latency estimate. The server load is taken from the
+ * hints attached to the responses of the server (see
+ * NodeHandle::loadHint) and, with a load_poll_interval, from polls of
+ * its load (see NodeHandle::ams_get_load); the poll is non-blocking
+ * and its answer is used by a later submit().
+ *
+ * When a tenant has several ranks, each with its own RenderRouter, the
+ * routers decide together over the tenant's communicator: the costs
+ * are the largest over the ranks, and a probe is only sent when every
+ * window has room, so that all ranks take the same path for every
+ * timestep. An inline function rendering on that communicator is then
+ * entered by all ranks, and the server receives whole timesteps.
+ */
+class RenderRouter {
+
+    public:
+
+    /**
+     * @brief Constructor. Configures the in-flight window of the
+     * NodeHandle, which must not have requests in flight.
+     *
+     * @param node Remote node to send in-transit timesteps to.
+     * @param inline_fn Function rendering a timestep inline.
+     * @param config Configuration.
+     * @param comm Communicator of the tenant's ranks, which must all
+     * call submit() for every timestep; submit() is collective over it.
+     */
+    RenderRouter(const NodeHandle& node,
+                 InlineFunction inline_fn,
+                 const RenderRouterConfig& config = RenderRouterConfig(),
+                 MPI_Comm comm = MPI_COMM_SELF);
+
+    /**
+     * @brief Copy constructor is deleted.
+     */
+    RenderRouter(const RenderRouter&) = delete;
+
+    /**
+     * @brief Copy-assignment operator is deleted.
+     */
+    RenderRouter& operator=(const RenderRouter&) = delete;
+
+    /**
+     * @brief Destructor. Waits for in-flight requests.
+     */
+    ~RenderRouter();
+
+    /**
+     * @brief Renders a timestep in transit or inline. If an earlier
+     * in-transit request failed on any rank, every rank throws and the
+     * timestep is not rendered.
+     *
+     * @param[in] open_opts conduit::Node
+     * @param[in] bp_mesh conduit::Node
+     * @param[in] actions conduit::Node
+     * @param[in] ts      timestamp
+     *
+     * @return the path taken.
+     */
+    RenderPath submit(const conduit::Node& open_opts,
+                      const conduit::Node& bp_mesh,
+                      const conduit::Node& actions,
+                      unsigned int ts);
+
+    /**
+     * @brief Waits for all in-transit timesteps to complete.
+     */
+    void flush();
+
+    /**
+     * @brief Feeds the router with the load reported by the server.
+     *
+     * @param queue_depth Number of requests queued on the server.
+     * @param eta Estimated time (in seconds) for the server to drain its queue.
+     */
+    void reportServerLoad(size_t queue_depth, double eta);
+
+    /**
+     * @brief Path the next timestep will take, unless costs change.
+     */
+    RenderPath currentPath() const {
+        return m_path;
+    }
+
+    /**
+     * @brief Estimated cost (in seconds) of rendering a timestep in transit.
+     */
+    double inTransitCost() const;
+
+    /**
+     * @brief Estimated cost (in seconds) of rendering a timestep
+     * inline, or 0 if no timestep was rendered inline yet.
+     */
+    double inlineCost() const {
+        return m_inline_cost;
+    }
+
+    /**
+     * @brief Accounting of the paths taken so far.
+     */
+    const RenderRouterStats& stats() const {
+        return m_stats;
+    }
+
+    private:
+
+    RenderPath choosePath(double remote, double local, bool measured) const;
+    void smooth(double& estimate, double sample) const;
+    void pollServerLoad(double now);
+
+    NodeHandle         m_node;
+    InlineFunction     m_inline_fn;
+    RenderRouterConfig m_config;
+    MPI_Comm           m_comm;
+    int                m_comm_size      = 1;
+    RenderRouterStats  m_stats;
+    RenderPath         m_path           = RenderPath::IN_TRANSIT;
+    unsigned           m_steps_on_path  = 0;
+    double             m_submit_cost    = 0.0; /* ams_submit time when the window has room */
+    double             m_inline_cost    = 0.0;
+    double             m_step_interval  = 0.0; /* simulation time between submissions */
+    double             m_last_return    = 0.0;
+    double             m_server_eta     = 0.0;
+    size_t             m_server_queue   = 0;
+    double             m_server_load_at = 0.0;
+    AsyncRequest       m_load_request;         /* pending ams_get_load poll */
+    ServerLoad         m_polled_load;
+    double             m_last_poll      = 0.0;
+};
+
+}
+
+#endif
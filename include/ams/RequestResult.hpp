@@ -6,6 +6,7 @@
 #ifndef __AMS_REQUEST_RESULT_HPP
 #define __AMS_REQUEST_RESULT_HPP
 
+#include <ams/ServerLoad.hpp>
 #include <string>
 
 namespace ams {
@@ -24,6 +25,9 @@ namespace ams {
  * both the value and the error fields will be managed by the same
  * underlying variable.
  *
+ * Servers may also attach a LoadHint, their load when answering,
+ * which is only serialized when present.
+ *
  * @tparam T Type of the result.
  */
 template<typename T>
@@ -79,6 +83,28 @@ class RequestResult {
         return m_value;
     }
 
+    /**
+     * @brief Whether the server attached its load.
+     */
+    bool hasLoadHint() const {
+        return m_has_hint;
+    }
+
+    /**
+     * @brief Load attached by the server, if hasLoadHint().
+     */
+    const LoadHint& loadHint() const {
+        return m_hint;
+    }
+
+    /**
+     * @brief Attaches the load of the server.
+     */
+    void setLoadHint(const LoadHint& hint) {
+        m_hint = hint;
+        m_has_hint = true;
+    }
+
     /**
      * @brief Serialization function for Thallium.
      *
@@ -90,6 +116,8 @@ class RequestResult {
         a & m_success;
         a & m_error;
         a & m_value;
+        a & m_has_hint;
+        if(m_has_hint) a & m_hint;
     }
 
     private:
@@ -97,6 +125,8 @@ class RequestResult {
     bool        m_success = true;
     std::string m_error   = "";
     T           m_value;
+    bool        m_has_hint = false;
+    LoadHint    m_hint;
 };
 
 template<>
@@ -134,16 +164,33 @@ class RequestResult<std::string> {
         return m_content;
     }
 
+    bool hasLoadHint() const {
+        return m_has_hint;
+    }
+
+    const LoadHint& loadHint() const {
+        return m_hint;
+    }
+
+    void setLoadHint(const LoadHint& hint) {
+        m_hint = hint;
+        m_has_hint = true;
+    }
+
     template<typename Archive>
     void serialize(Archive& a) {
         a & m_success;
         a & m_content;
+        a & m_has_hint;
+        if(m_has_hint) a & m_hint;
     }
 
     private:
 
     bool        m_success = true;
     std::string m_content = "";
+    bool        m_has_hint = false;
+    LoadHint    m_hint;
 };
 
 template<>
@@ -181,16 +228,33 @@ class RequestResult<bool> {
         return m_success;
     }
 
+    bool hasLoadHint() const {
+        return m_has_hint;
+    }
+
+    const LoadHint& loadHint() const {
+        return m_hint;
+    }
+
+    void setLoadHint(const LoadHint& hint) {
+        m_hint = hint;
+        m_has_hint = true;
+    }
+
     template<typename Archive>
     void serialize(Archive& a) {
         a & m_success;
         a & m_error;
+        a & m_has_hint;
+        if(m_has_hint) a & m_hint;
     }
 
     private:
 
     bool        m_success = true;
     std::string m_error   = "";
+    bool        m_has_hint = false;
+    LoadHint    m_hint;
 };
 
 }
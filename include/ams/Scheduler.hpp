@@ -0,0 +1,273 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __AMS_SCHEDULER_HPP
+#define __AMS_SCHEDULER_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ams {
+
+/**
+ * @brief When a handler that has just enqueued a request
+ * should run the request at the head of the queue.
+ * - EAGER: always.
+ * - LAZY: never; requests are executed by ams_execute_pending_requests.
+ * - LAZYISH: only if few other handlers are waiting to run.
+ */
+enum class ServerMode : int {
+    EAGER   = 0,
+    LAZY    = 1,
+    LAZYISH = 2
+};
+
+/**
+ * @brief Order in which queued requests are executed.
+ * - TIMESTEP: lowest client timestep first (ties in arrival order).
+ * - FIFO: arrival order.
+ * - SMALLEST: smallest mesh first (ties in arrival order).
+ */
+enum class QueuePolicy : int {
+    TIMESTEP = 0,
+    FIFO     = 1,
+    SMALLEST = 2
+};
+
+/**
+ * @brief Tunable parameters of the Scheduler.
+ */
+struct SchedulerConfig {
+    ServerMode  mode              = ServerMode::EAGER;
+    QueuePolicy policy            = QueuePolicy::TIMESTEP;
+    size_t      lazyish_threshold = 5; /* LAZYISH executes if fewer handlers are pending */
+    size_t      memory_limit      = 0; /* bytes of queued and resident data (0: unlimited) */
+};
+
+/**
+ * @brief Parses a server mode, either by name ("eager", "lazy",
+ * "lazyish") or by its legacy numerical value ("0", "1", "2").
+ */
+inline ServerMode parse_server_mode(const std::string& s) {
+    if(s == "eager"   || s == "0") return ServerMode::EAGER;
+    if(s == "lazy"    || s == "1") return ServerMode::LAZY;
+    if(s == "lazyish" || s == "2") return ServerMode::LAZYISH;
+    throw std::invalid_argument("Unknown server mode " + s);
+}
+
+inline std::string to_string(ServerMode mode) {
+    switch(mode) {
+        case ServerMode::EAGER:   return "eager";
+        case ServerMode::LAZY:    return "lazy";
+        case ServerMode::LAZYISH: return "lazyish";
+    }
+    return "";
+}
+
+/**
+ * @brief Parses a queue policy ("timestep", "fifo", "smallest").
+ */
+inline QueuePolicy parse_queue_policy(const std::string& s) {
+    if(s == "timestep") return QueuePolicy::TIMESTEP;
+    if(s == "fifo")     return QueuePolicy::FIFO;
+    if(s == "smallest") return QueuePolicy::SMALLEST;
+    throw std::invalid_argument("Unknown queue policy " + s);
+}
+
+inline std::string to_string(QueuePolicy policy) {
+    switch(policy) {
+        case QueuePolicy::TIMESTEP: return "timestep";
+        case QueuePolicy::FIFO:     return "fifo";
+        case QueuePolicy::SMALLEST: return "smallest";
+    }
+    return "";
+}
+
+/**
+ * @brief The Scheduler holds the queue of pending visualization
+ * requests of a backend and decides when and in which order they
+ * are executed. It does not depend on MPI, Argobots or Ascent so that
+ * the same code can be driven by the offline simulator; callers are
+ * responsible for synchronization and for agreeing on decisions
+ * across the ranks of an instance.
+ *
+ * @tparam Request Type of the queued requests.
+ */
+template<typename Request>
+class Scheduler {
+
+    struct Entry {
+        Request  m_request;
+        unsigned m_ts;
+        size_t   m_bytes;
+        uint64_t m_seq;
+        bool     m_held;
+    };
+
+    /* "Less than" in the std heap sense: a < b if b runs first */
+    struct Compare {
+        QueuePolicy m_policy;
+        bool operator()(const Entry& a, const Entry& b) const {
+            switch(m_policy) {
+                case QueuePolicy::TIMESTEP:
+                    if(a.m_ts != b.m_ts) return a.m_ts > b.m_ts;
+                    break;
+                case QueuePolicy::SMALLEST:
+                    if(a.m_bytes != b.m_bytes) return a.m_bytes > b.m_bytes;
+                    break;
+                case QueuePolicy::FIFO:
+                    break;
+            }
+            return a.m_seq > b.m_seq;
+        }
+    };
+
+    SchedulerConfig    m_config;
+    std::vector<Entry> m_heap;
+    uint64_t           m_next_seq       = 0;
+    size_t             m_bytes          = 0;
+    size_t             m_resident_bytes = 0;
+
+    public:
+
+    /**
+     * @brief Constructor.
+     */
+    Scheduler(const SchedulerConfig& config = SchedulerConfig())
+    : m_config(config) {}
+
+    /**
+     * @brief Returns the current configuration.
+     */
+    const SchedulerConfig& config() const {
+        return m_config;
+    }
+
+    /**
+     * @brief Changes the configuration. Pending requests are
+     * reordered if the queue policy changed.
+     */
+    void setConfig(const SchedulerConfig& config) {
+        bool reorder = config.policy != m_config.policy;
+        m_config = config;
+        if(reorder)
+            std::make_heap(m_heap.begin(), m_heap.end(), Compare{m_config.policy});
+    }
+
+    /**
+     * @brief Enqueues a request.
+     *
+     * @param request Request.
+     * @param ts Client timestep of the request.
+     * @param bytes Size of the request's data.
+     * @param held Whether the data is in server memory (false if it is
+     * fetched when the request runs), only held data counts in bytes().
+     */
+    void push(Request request, unsigned ts, size_t bytes, bool held = true) {
+        m_heap.push_back(Entry{std::move(request), ts, bytes, m_next_seq++, held});
+        std::push_heap(m_heap.begin(), m_heap.end(), Compare{m_config.policy});
+        if(held) m_bytes += bytes;
+    }
+
+    /**
+     * @brief Returns the request that should run next.
+     * The queue must not be empty.
+     */
+    const Request& top() const {
+        return m_heap.front().m_request;
+    }
+
+    /**
+     * @brief Removes and returns the request that should run next.
+     * The queue must not be empty.
+     */
+    Request pop() {
+        std::pop_heap(m_heap.begin(), m_heap.end(), Compare{m_config.policy});
+        Entry e = std::move(m_heap.back());
+        m_heap.pop_back();
+        if(e.m_held) m_bytes -= e.m_bytes;
+        return std::move(e.m_request);
+    }
+
+    /**
+     * @brief Number of queued requests.
+     */
+    size_t size() const {
+        return m_heap.size();
+    }
+
+    /**
+     * @brief Whether the queue is empty.
+     */
+    bool empty() const {
+        return m_heap.empty();
+    }
+
+    /**
+     * @brief Total size of the data held by queued requests.
+     */
+    size_t bytes() const {
+        return m_bytes;
+    }
+
+    /**
+     * @brief Accounts for data kept in server memory outside of the
+     * queue (e.g. meshes published once and executed many times).
+     */
+    void retain(size_t bytes) {
+        m_resident_bytes += bytes;
+    }
+
+    /**
+     * @brief Stops accounting for data previously passed to retain().
+     */
+    void release(size_t bytes) {
+        m_resident_bytes -= std::min(bytes, m_resident_bytes);
+    }
+
+    /**
+     * @brief Total size of the data accounted with retain().
+     */
+    size_t residentBytes() const {
+        return m_resident_bytes;
+    }
+
+    /**
+     * @brief Total size of the queued and resident data.
+     */
+    size_t totalBytes() const {
+        return m_bytes + m_resident_bytes;
+    }
+
+    /**
+     * @brief Whether bytes more data fit within the memory limit.
+     */
+    bool admits(size_t bytes) const {
+        return m_config.memory_limit == 0
+            || totalBytes() + bytes <= m_config.memory_limit;
+    }
+
+    /**
+     * @brief Decides whether a handler that has just enqueued a request
+     * should execute the request at the head of the queue.
+     *
+     * @param pending_handlers Number of RPC handlers waiting to run.
+     */
+    bool shouldExecute(size_t pending_handlers) const {
+        switch(m_config.mode) {
+            case ServerMode::EAGER:   return true;
+            case ServerMode::LAZY:    return false;
+            case ServerMode::LAZYISH: return pending_handlers < m_config.lazyish_threshold;
+        }
+        return true;
+    }
+};
+
+}
+
+#endif
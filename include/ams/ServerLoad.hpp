@@ -0,0 +1,70 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __AMS_SERVER_LOAD_HPP
+#define __AMS_SERVER_LOAD_HPP
+
+#include <cstdint>
+
+namespace ams {
+
+/**
+ * @brief Load of a server rank: the requests queued on its nodes,
+ * waiting to be rendered, and an estimate of the time needed to
+ * render them based on the recent rendering times.
+ */
+struct ServerLoad {
+    uint64_t queued_requests = 0;
+    uint64_t queued_bytes    = 0;     /* held in server memory */
+    double   eta             = 0.0;   /* seconds until the queue is drained */
+    bool     executing       = false; /* a request is being rendered */
+    bool     memory_pressure = false; /* queued bytes close to the memory limit */
+
+    ServerLoad& operator+=(const ServerLoad& other) {
+        queued_requests += other.queued_requests;
+        queued_bytes    += other.queued_bytes;
+        eta             += other.eta; /* nodes of a rank render one at a time */
+        executing        = executing || other.executing;
+        memory_pressure  = memory_pressure || other.memory_pressure;
+        return *this;
+    }
+
+    template<typename Archive>
+    void serialize(Archive& ar) {
+        ar & queued_requests;
+        ar & queued_bytes;
+        ar & eta;
+        ar & executing;
+        ar & memory_pressure;
+    }
+};
+
+/**
+ * @brief Compact form of a ServerLoad, attached by servers to the
+ * responses of node requests (see RequestResult::loadHint).
+ */
+struct LoadHint {
+    uint32_t queue_depth     = 0;
+    float    wait            = 0.0f;  /* estimated seconds before a new request is rendered */
+    bool     memory_pressure = false;
+
+    LoadHint() = default;
+
+    LoadHint(const ServerLoad& load)
+    : queue_depth(load.queued_requests > UINT32_MAX ? UINT32_MAX : (uint32_t)load.queued_requests)
+    , wait((float)load.eta)
+    , memory_pressure(load.memory_pressure) {}
+
+    template<typename Archive>
+    void serialize(Archive& ar) {
+        ar & queue_depth;
+        ar & wait;
+        ar & memory_pressure;
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,106 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __AMS_SERVICE_DIRECTORY_HPP
+#define __AMS_SERVICE_DIRECTORY_HPP
+
+#include <ams/ServerLoad.hpp>
+#include <ams/UUID.hpp>
+#include <mpi.h>
+#include <string>
+#include <vector>
+
+namespace ams {
+
+/**
+ * @brief A server rank of the service.
+ */
+struct ServiceMember {
+    int         instance_rank = 0; /* rank within its server instance */
+    std::string address;
+    UUID        node_id;           /* null if no node file was given */
+    ServerLoad  load;              /* as reported by Client::getInstance */
+};
+
+/**
+ * @brief A server instance: its ranks, in instance rank order, and
+ * its load as last reported (see Client::getInstance): the requests
+ * and bytes queued on all its ranks, and the eta of the busiest one.
+ */
+struct InstanceInfo {
+    std::vector<ServiceMember> members;
+    ServerLoad                 load;
+};
+
+/**
+ * @brief Addresses and node ids of the ranks of the service, as
+ * published by the servers (see examples/server.cpp): an address
+ * file made of the number of ranks followed by one
+ * "<instance rank> <address>" line per rank, and a node file with one
+ * node id per line, both in server rank order.
+ *
+ * The collective load reads the files once, on one rank, and
+ * broadcasts their contents, rather than having every client rank
+ * read them from the shared file system.
+ */
+class ServiceDirectory {
+
+    public:
+
+    /**
+     * @brief Parses the contents of an address file and of an
+     * optional node file. Throws an ams::Exception if they are
+     * malformed or do not have the same number of ranks.
+     */
+    static ServiceDirectory parse(const std::string& addresses,
+                                  const std::string& nodes = "");
+
+    /**
+     * @brief Reads an address file and an optional node file.
+     */
+    static ServiceDirectory load(const std::string& address_file,
+                                 const std::string& node_file = "");
+
+    /**
+     * @brief Reads an address file and an optional node file on the
+     * root rank of comm and broadcasts their contents. Collective;
+     * every rank throws if the root could not read the files.
+     */
+    static ServiceDirectory load(const std::string& address_file,
+                                 const std::string& node_file,
+                                 MPI_Comm comm, int root = 0);
+
+    /**
+     * @brief Number of server ranks.
+     */
+    size_t size() const {
+        return m_members.size();
+    }
+
+    /**
+     * @brief Member of a given server rank.
+     */
+    const ServiceMember& operator[](size_t server_rank) const {
+        return m_members[server_rank];
+    }
+
+    const std::vector<ServiceMember>& members() const {
+        return m_members;
+    }
+
+    /**
+     * @brief Groups the ranks into instances, each starting at a rank
+     * of instance rank 0. Loads are unknown (zero).
+     */
+    std::vector<InstanceInfo> instances() const;
+
+    private:
+
+    std::vector<ServiceMember> m_members;
+};
+
+}
+
+#endif
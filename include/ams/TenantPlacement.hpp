@@ -0,0 +1,102 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __AMS_TENANT_PLACEMENT_HPP
+#define __AMS_TENANT_PLACEMENT_HPP
+
+#include <ams/ServiceDirectory.hpp>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ams {
+
+/**
+ * @brief Tunable parameters of a TenantPlacement.
+ */
+struct PlacementConfig {
+    unsigned virtual_nodes = 64;   /* points of each instance on the ring */
+    unsigned choices       = 2;    /* instances considered for a new tenant */
+    double   load_bound    = 1.25; /* maximum load relative to the average */
+};
+
+/**
+ * @brief Maps tenants (simulations) to server instances, and their
+ * ranks to the ranks of the instance.
+ *
+ * Instances are placed on a consistent-hash ring, so that adding or
+ * removing an instance only moves the tenants that hashed to it. A
+ * new tenant goes to the least loaded of the first "choices" distinct
+ * instances found on the ring from the tenant's hash, skipping the
+ * instances whose load would exceed load_bound times the average.
+ * The load of an instance is its reported queue length plus the
+ * tenants this placement sent to it. A tenant keeps its instance for
+ * as long as the placement lives.
+ *
+ * The choice depends on the loads, which the ranks of a tenant may
+ * have fetched at different times: the collective overloads make it
+ * on one rank and broadcast it, so that all the ranks of a tenant
+ * send their data to the same instance.
+ */
+class TenantPlacement {
+
+    public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param instances Instances, with their load (see Client::getInstance).
+     * @param config Parameters.
+     */
+    TenantPlacement(std::vector<InstanceInfo> instances,
+                    const PlacementConfig& config = PlacementConfig());
+
+    /**
+     * @brief Returns the index of the instance of a tenant, placing
+     * it if it is new.
+     */
+    size_t place(const std::string& tenant);
+
+    /**
+     * @brief Places a tenant on the root rank of comm and broadcasts
+     * the chosen instance, which the other ranks find in their own
+     * instances by the address of its first rank. Collective; throws
+     * an ams::Exception on the ranks that do not know that instance.
+     */
+    size_t place(const std::string& tenant, MPI_Comm comm, int root = 0);
+
+    /**
+     * @brief Returns the server rank that a rank of a tenant should
+     * send its data to: the rank of the same number in its instance.
+     * Throws an ams::Exception if the tenant does not have as many
+     * ranks as the instance. A tenant not placed yet is placed by this
+     * rank alone: call place(tenant, comm) first.
+     *
+     * @param tenant Tenant.
+     * @param rank Rank of the tenant.
+     * @param ranks Number of ranks of the tenant.
+     */
+    const ServiceMember& member(const std::string& tenant, int rank, int ranks);
+
+    const std::vector<InstanceInfo>& instances() const {
+        return m_instances;
+    }
+
+    private:
+
+    std::vector<InstanceInfo>                    m_instances;
+    PlacementConfig                              m_config;
+    std::vector<std::pair<uint64_t, size_t>>     m_ring;     // sorted points
+    std::vector<uint64_t>                        m_assigned; // tenants per instance
+    std::unordered_map<std::string, size_t>      m_tenants;
+
+    uint64_t load(size_t instance) const;
+};
+
+}
+
+#endif
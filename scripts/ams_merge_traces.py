@@ -0,0 +1,37 @@
+#!/usr/bin/env python3
+# (C) 2020 The University of Chicago
+# See COPYRIGHT in top-level directory.
+"""Merges the per-rank Chrome trace files written by AMS servers
+(<prefix>.<rank>.json) into a single trace that can be loaded into
+chrome://tracing or https://ui.perfetto.dev.
+
+usage: ams_merge_traces.py output.json trace.0.json trace.1.json ...
+"""
+import json
+import sys
+
+
+def load_events(filename):
+    # Files are written in the JSON array format and left open
+    with open(filename) as f:
+        content = f.read().strip()
+    if content.endswith(']'):
+        content = content[:-1].rstrip()
+    if content.endswith(','):
+        content = content[:-1]
+    return json.loads(content + ']')
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.stderr.write(__doc__)
+        sys.exit(1)
+    events = []
+    for filename in sys.argv[2:]:
+        events.extend(load_events(filename))
+    with open(sys.argv[1], 'w') as f:
+        json.dump({'traceEvents': events, 'displayTimeUnit': 'ms'}, f)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,292 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "ams/ActionAnalysis.hpp"
+#include <cctype>
+
+namespace ams {
+
+/* Adds the quoted strings and identifiers of an expression */
+static void scan_expression(const std::string& expr, std::set<std::string>& names) {
+    size_t i = 0;
+    while(i < expr.size()) {
+        char c = expr[i];
+        if(c == '\'' || c == '"') {
+            size_t end = expr.find(c, i+1);
+            if(end == std::string::npos) end = expr.size();
+            names.insert(expr.substr(i+1, end-i-1));
+            i = end + 1;
+        } else if(std::isalpha((unsigned char)c) || c == '_') {
+            size_t start = i;
+            while(i < expr.size() && (std::isalnum((unsigned char)expr[i]) || expr[i] == '_'))
+                i++;
+            names.insert(expr.substr(start, i-start));
+        } else {
+            i++;
+        }
+    }
+}
+
+/* Adds all the string leaves under a node */
+static void collect_strings(const conduit::Node& n, std::set<std::string>& names) {
+    if(n.dtype().is_string()) {
+        names.insert(n.as_string());
+    } else {
+        for(conduit::index_t i = 0; i < n.number_of_children(); i++)
+            collect_strings(n.child(i), names);
+    }
+}
+
+/* Walks filter, plot or extract parameters. Strings under keys that
+ * name fields or topologies are taken as such, expressions are scanned,
+ * other strings are ignored (file names, color tables, ...). */
+static void scan_params(const conduit::Node& params, FieldSelection& selection) {
+    for(conduit::index_t i = 0; i < params.number_of_children(); i++) {
+        const conduit::Node& child = params.child(i);
+        const std::string name = child.name();
+        if(name == "field" || name == "fields" || name == "field1" || name == "field2"
+        || name == "field3" || name == "var" || name == "vars" || name == "variable") {
+            collect_strings(child, selection.fields);
+        } else if(name == "topology") {
+            collect_strings(child, selection.topologies);
+        } else if(name == "expression" || name == "condition") {
+            if(child.dtype().is_string())
+                scan_expression(child.as_string(), selection.fields);
+        } else if(child.dtype().is_object() || child.dtype().is_list()) {
+            scan_params(child, selection);
+        }
+    }
+}
+
+/* Filters that produce new data from the fields named in their
+ * parameters, or that only restrict the mesh. Others may read fields
+ * that are not named (e.g. python scripts), so they select everything. */
+static bool is_known_filter(const std::string& type) {
+    static const std::set<std::string> known = {
+        "contour", "threshold", "slice", "3slice", "clip", "clip_with_field",
+        "iso_volume", "vector_magnitude", "vector_component", "composite_vector",
+        "gradient", "vorticity", "qcriterion", "divergence", "recenter",
+        "histsampling", "histogram", "statistics", "particle_advection",
+        "streamline", "lagrangian", "project_2d", "triangulate", "exaslice",
+        "mesh_metric", "log", "log10", "log2", "exp", "pow", "scale",
+        "add_mesh_blanking_field", "cell_average", "vertex_average",
+        "expression", "dray_pseudocolor"
+    };
+    return known.count(type) != 0;
+}
+
+static void analyze_pipelines(const conduit::Node& pipelines, FieldSelection& selection) {
+    for(conduit::index_t p = 0; p < pipelines.number_of_children(); p++) {
+        const conduit::Node& pipeline = pipelines.child(p);
+        for(conduit::index_t f = 0; f < pipeline.number_of_children(); f++) {
+            const conduit::Node& filter = pipeline.child(f);
+            if(not filter.dtype().is_object()) continue; // e.g. "pipeline" input name
+            if(not filter.has_child("type") || not is_known_filter(filter["type"].as_string())) {
+                selection.all = true;
+                return;
+            }
+            if(filter.has_child("params"))
+                scan_params(filter["params"], selection);
+        }
+    }
+}
+
+static void analyze_scenes(const conduit::Node& scenes, FieldSelection& selection) {
+    for(conduit::index_t s = 0; s < scenes.number_of_children(); s++) {
+        const conduit::Node& scene = scenes.child(s);
+        if(not scene.has_child("plots")) continue;
+        const conduit::Node& plots = scene["plots"];
+        for(conduit::index_t p = 0; p < plots.number_of_children(); p++)
+            scan_params(plots.child(p), selection);
+    }
+}
+
+static void analyze_extracts(const conduit::Node& extracts, FieldSelection& selection) {
+    for(conduit::index_t e = 0; e < extracts.number_of_children(); e++) {
+        const conduit::Node& extract = extracts.child(e);
+        /* Scripts may read anything; mesh extracts write every
+         * field unless a subset is given */
+        std::string type = extract.has_child("type") ? extract["type"].as_string() : "";
+        if(type == "python" || type == "jupyter" || type == "flow"
+        || not extract.has_path("params/fields")) {
+            selection.all = true;
+            return;
+        }
+        scan_params(extract["params"], selection);
+    }
+}
+
+static void analyze_action_list(const conduit::Node& actions, FieldSelection& selection);
+
+static void analyze_triggers(const conduit::Node& triggers, FieldSelection& selection) {
+    for(conduit::index_t t = 0; t < triggers.number_of_children(); t++) {
+        const conduit::Node& trigger = triggers.child(t);
+        if(not trigger.has_child("params")) continue;
+        const conduit::Node& params = trigger["params"];
+        if(params.has_child("condition") && params["condition"].dtype().is_string())
+            scan_expression(params["condition"].as_string(), selection.fields);
+        if(params.has_child("actions"))
+            analyze_action_list(params["actions"], selection);
+        else if(params.has_child("actions_file"))
+            selection.all = true;
+    }
+}
+
+static void analyze_action_list(const conduit::Node& actions, FieldSelection& selection) {
+    for(conduit::index_t i = 0; i < actions.number_of_children() && not selection.all; i++) {
+        const conduit::Node& action = actions.child(i);
+        if(not action.has_child("action")) {
+            selection.all = true;
+            return;
+        }
+        const std::string type = action["action"].as_string();
+        if(type == "add_pipelines") {
+            if(action.has_child("pipelines"))
+                analyze_pipelines(action["pipelines"], selection);
+        } else if(type == "add_scenes") {
+            if(action.has_child("scenes"))
+                analyze_scenes(action["scenes"], selection);
+        } else if(type == "add_extracts") {
+            if(action.has_child("extracts"))
+                analyze_extracts(action["extracts"], selection);
+        } else if(type == "add_queries") {
+            if(action.has_child("queries")) {
+                const conduit::Node& queries = action["queries"];
+                for(conduit::index_t q = 0; q < queries.number_of_children(); q++) {
+                    if(queries.child(q).has_child("params"))
+                        scan_params(queries.child(q)["params"], selection);
+                }
+            }
+        } else if(type == "add_triggers") {
+            if(action.has_child("triggers"))
+                analyze_triggers(action["triggers"], selection);
+        } else if(type == "execute" || type == "reset" || type == "save_info") {
+            // no data used
+        } else {
+            selection.all = true;
+        }
+    }
+}
+
+FieldSelection analyze_actions(const conduit::Node& actions) {
+    FieldSelection selection;
+    try {
+        analyze_action_list(actions, selection);
+    } catch(const conduit::Error&) {
+        /* Unexpected layout (e.g. a non-string "action") */
+        selection.all = true;
+    }
+    return selection;
+}
+
+/* Makes dst refer to src's data. Views are only read (serialized),
+ * which makes dropping the constness of src safe. */
+static void reference(conduit::Node& dst, const conduit::Node& src) {
+    dst.set_external(const_cast<conduit::Node&>(src));
+}
+
+/* Builds the view of a single domain, returns whether something was left out */
+static bool select_domain(const conduit::Node& domain,
+                          const FieldSelection& selection,
+                          conduit::Node& view) {
+    bool pruned = false;
+
+    std::set<std::string> topologies = selection.topologies;
+    if(domain.has_child("fields")) {
+        const conduit::Node& fields = domain["fields"];
+        for(conduit::index_t i = 0; i < fields.number_of_children(); i++) {
+            const conduit::Node& field = fields.child(i);
+            if(selection.fields.count(field.name()) == 0) continue;
+            if(field.has_child("topology"))
+                topologies.insert(field["topology"].as_string());
+        }
+    }
+    /* Nothing names a topology: keep them all, Ascent picks a default */
+    bool all_topologies = true;
+    if(domain.has_child("topologies")) {
+        const conduit::Node& topos = domain["topologies"];
+        for(conduit::index_t i = 0; i < topos.number_of_children(); i++)
+            if(topologies.count(topos.child(i).name())) all_topologies = false;
+    }
+
+    std::set<std::string> coordsets;
+    for(conduit::index_t i = 0; i < domain.number_of_children(); i++) {
+        const conduit::Node& group = domain.child(i);
+        const std::string group_name = group.name();
+        if(group_name == "topologies") {
+            for(conduit::index_t t = 0; t < group.number_of_children(); t++) {
+                const conduit::Node& topo = group.child(t);
+                if(all_topologies || topologies.count(topo.name())) {
+                    reference(view["topologies"][topo.name()], topo);
+                    if(topo.has_child("coordset"))
+                        coordsets.insert(topo["coordset"].as_string());
+                } else {
+                    pruned = true;
+                }
+            }
+        } else if(group_name == "fields") {
+            for(conduit::index_t f = 0; f < group.number_of_children(); f++) {
+                const conduit::Node& field = group.child(f);
+                if(selection.fields.count(field.name()))
+                    reference(view["fields"][field.name()], field);
+                else
+                    pruned = true;
+            }
+        } else if(group_name == "matsets" || group_name == "specsets"
+               || group_name == "adjsets" || group_name == "nestsets") {
+            for(conduit::index_t s = 0; s < group.number_of_children(); s++) {
+                const conduit::Node& set = group.child(s);
+                bool keep = all_topologies || not set.has_child("topology")
+                         || topologies.count(set["topology"].as_string());
+                if(keep)
+                    reference(view[group_name][set.name()], set);
+                else
+                    pruned = true;
+            }
+        } else if(group_name != "coordsets") {
+            reference(view[group_name], group);
+        }
+    }
+
+    if(domain.has_child("coordsets")) {
+        const conduit::Node& group = domain["coordsets"];
+        for(conduit::index_t c = 0; c < group.number_of_children(); c++) {
+            const conduit::Node& coordset = group.child(c);
+            if(all_topologies || coordsets.count(coordset.name()))
+                reference(view["coordsets"][coordset.name()], coordset);
+            else
+                pruned = true;
+        }
+    }
+    return pruned;
+}
+
+bool select_fields(const conduit::Node& bp_mesh,
+                   const FieldSelection& selection,
+                   conduit::Node& view) {
+    if(selection.all) return false;
+    view.reset();
+    bool pruned = false;
+    try {
+        if(bp_mesh.has_child("coordsets")) {
+            pruned = select_domain(bp_mesh, selection, view);
+        } else if(bp_mesh.dtype().is_list()) {
+            for(conduit::index_t d = 0; d < bp_mesh.number_of_children(); d++)
+                pruned |= select_domain(bp_mesh.child(d), selection, view.append());
+        } else if(bp_mesh.dtype().is_object()) {
+            for(conduit::index_t d = 0; d < bp_mesh.number_of_children(); d++) {
+                const conduit::Node& domain = bp_mesh.child(d);
+                pruned |= select_domain(domain, selection, view[domain.name()]);
+            }
+        }
+    } catch(const conduit::Error&) {
+        /* Not a layout we understand */
+        pruned = false;
+    }
+    if(not pruned) view.reset();
+    return pruned;
+}
+
+}
@@ -43,7 +43,7 @@ UUID Admin::createNode(const std::string& address,
                            const std::string& node_type,
                            const std::string& node_config,
                            const std::string& token) const {
-    auto endpoint  = self->m_engine.lookup(address);
+    auto endpoint  = self->m_endpoints.lookup(self->m_engine, address);
     auto ph        = tl::provider_handle(endpoint, provider_id);
     RequestResult<UUID> result = self->m_create_node.on(ph)(token, node_type, node_config);
     if(not result.success()) {
@@ -57,7 +57,7 @@ UUID Admin::openNode(const std::string& address,
                          const std::string& node_type,
                          const std::string& node_config,
                          const std::string& token) const {
-    auto endpoint  = self->m_engine.lookup(address);
+    auto endpoint  = self->m_endpoints.lookup(self->m_engine, address);
     auto ph        = tl::provider_handle(endpoint, provider_id);
     RequestResult<UUID> result = self->m_open_node.on(ph)(token, node_type, node_config);
     if(not result.success()) {
@@ -70,7 +70,7 @@ void Admin::closeNode(const std::string& address,
                            uint16_t provider_id,
                            const UUID& node_id,
                            const std::string& token) const {
-    auto endpoint  = self->m_engine.lookup(address);
+    auto endpoint  = self->m_endpoints.lookup(self->m_engine, address);
     auto ph        = tl::provider_handle(endpoint, provider_id);
     RequestResult<bool> result = self->m_close_node.on(ph)(token, node_id);
     if(not result.success()) {
@@ -82,7 +82,7 @@ void Admin::destroyNode(const std::string& address,
                             uint16_t provider_id,
                             const UUID& node_id,
                             const std::string& token) const {
-    auto endpoint  = self->m_engine.lookup(address);
+    auto endpoint  = self->m_endpoints.lookup(self->m_engine, address);
     auto ph        = tl::provider_handle(endpoint, provider_id);
     RequestResult<bool> result = self->m_destroy_node.on(ph)(token, node_id);
     if(not result.success()) {
@@ -90,8 +90,21 @@ void Admin::destroyNode(const std::string& address,
     }
 }
 
+std::string Admin::updateConfig(const std::string& address,
+                                uint16_t provider_id,
+                                const std::string& config,
+                                const std::string& token) const {
+    auto endpoint  = self->m_endpoints.lookup(self->m_engine, address);
+    auto ph        = tl::provider_handle(endpoint, provider_id);
+    RequestResult<std::string> result = self->m_update_config.on(ph)(token, config);
+    if(not result.success()) {
+        throw Exception(result.error());
+    }
+    return result.value();
+}
+
 void Admin::shutdownServer(const std::string& address) const {
-    auto ep = self->m_engine.lookup(address);
+    auto ep = self->m_endpoints.lookup(self->m_engine, address);
     self->m_engine.shutdown_remote_engine(ep);
 }
 
@@ -7,6 +7,7 @@
 #define __AMS_ADMIN_IMPL_H
 
 #include <thallium.hpp>
+#include "EndpointCache.hpp"
 
 namespace ams {
 
@@ -21,6 +22,8 @@ class AdminImpl {
     tl::remote_procedure m_open_node;
     tl::remote_procedure m_close_node;
     tl::remote_procedure m_destroy_node;
+    tl::remote_procedure m_update_config;
+    EndpointCache        m_endpoints;
 
     AdminImpl(const tl::engine& engine)
     : m_engine(engine)
@@ -28,6 +31,7 @@ class AdminImpl {
     , m_open_node(m_engine.define("ams_open_node"))
     , m_close_node(m_engine.define("ams_close_node"))
     , m_destroy_node(m_engine.define("ams_destroy_node"))
+    , m_update_config(m_engine.define("ams_update_config"))
     {}
 
     AdminImpl(margo_instance_id mid)
@@ -7,6 +7,8 @@
 #include "ams/AsyncRequest.hpp"
 #include "AsyncRequestImpl.hpp"
 
+#include <exception>
+
 namespace ams {
 
 AsyncRequest::AsyncRequest() = default;
@@ -49,8 +51,9 @@ AsyncRequest& AsyncRequest::operator=(AsyncRequest&& other) {
 void AsyncRequest::wait() const {
     if(not self) throw Exception("Invalid ams::AsyncRequest object");
     if(self->m_waited) return;
-    self->m_wait_callback(*self);
+    /* mark first so that a failed request is not waited on twice */
     self->m_waited = true;
+    self->m_wait_callback(*self);
 }
 
 bool AsyncRequest::completed() const {
@@ -58,4 +61,43 @@ bool AsyncRequest::completed() const {
     return self->m_async_response.received();
 }
 
+bool AsyncRequest::test() const {
+    if(not self) throw Exception("Invalid ams::AsyncRequest object");
+    if(self->m_waited) return true;
+    if(not self->m_async_response.received()) return false;
+    wait();
+    return true;
+}
+
+void AsyncRequest::wait_all(const std::vector<AsyncRequest>& requests) {
+    std::exception_ptr error;
+    for(auto& request : requests) {
+        if(not request) continue;
+        try {
+            request.wait();
+        } catch(...) {
+            if(not error) error = std::current_exception();
+        }
+    }
+    if(error) std::rethrow_exception(error);
+}
+
+size_t AsyncRequest::wait_any(const std::vector<AsyncRequest>& requests) {
+    size_t first = requests.size();
+    for(size_t i = 0; i < requests.size(); i++) {
+        auto& request = requests[i];
+        if(not request || request.self->m_waited) continue;
+        if(request.self->m_async_response.received()) {
+            request.wait();
+            return i;
+        }
+        if(first == requests.size()) first = i;
+    }
+    /* None has completed yet: block on the first one rather than
+     * keep the execution stream busy polling */
+    if(first != requests.size())
+        requests[first].wait();
+    return first;
+}
+
 }
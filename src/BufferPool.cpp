@@ -0,0 +1,122 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "BufferPool.hpp"
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <sys/mman.h>
+
+namespace ams {
+
+static const size_t MIN_BUFFER_SIZE = 64 * 1024;
+static const size_t HUGE_PAGE_SIZE  = 2 * 1024 * 1024;
+
+BufferPool::~BufferPool() {
+    for(auto& c : m_free)
+        for(auto buffer : c.second)
+            free_buffer(buffer);
+}
+
+void BufferPool::configure(size_t max_cached_bytes, bool hugepages) {
+    std::lock_guard<tl::mutex> lock(m_mtx);
+    m_max_cached_bytes = max_cached_bytes;
+    m_hugepages        = hugepages;
+}
+
+size_t BufferPool::size_class(size_t size) {
+    if(size <= MIN_BUFFER_SIZE) return MIN_BUFFER_SIZE;
+    size_t unit = 1;
+    while((size + unit - 1) / unit > 7) unit <<= 1;
+    size_t n = (size + unit - 1) / unit;
+    return (n < 4 ? 4 : n) * unit;
+}
+
+BufferPool::Buffer* BufferPool::allocate(size_t capacity) {
+    auto buffer = new Buffer;
+    buffer->m_capacity = capacity;
+    void* data = MAP_FAILED;
+    if(m_hugepages) {
+        size_t rounded = (capacity + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+#ifdef MAP_HUGETLB
+        data = mmap(nullptr, rounded, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+        if(data == MAP_FAILED) {
+            /* No reserved huge pages: ask for transparent ones */
+            data = mmap(nullptr, rounded, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+            if(data != MAP_FAILED) madvise(data, rounded, MADV_HUGEPAGE);
+#endif
+        }
+        if(data != MAP_FAILED) {
+            buffer->m_mapped   = true;
+            buffer->m_capacity = rounded;
+        }
+    }
+    if(data == MAP_FAILED) {
+        data = std::malloc(capacity);
+        if(data == nullptr) {
+            delete buffer;
+            throw std::bad_alloc();
+        }
+    }
+    buffer->m_data = static_cast<char*>(data);
+    std::vector<std::pair<void*, size_t>> segments = {{ data, buffer->m_capacity }};
+    buffer->m_bulk = m_engine.expose(segments, tl::bulk_mode::write_only);
+    return buffer;
+}
+
+void BufferPool::free_buffer(Buffer* buffer) {
+    buffer->m_bulk = tl::bulk();
+    if(buffer->m_mapped)
+        munmap(buffer->m_data, buffer->m_capacity);
+    else
+        std::free(buffer->m_data);
+    delete buffer;
+}
+
+std::shared_ptr<BufferPool::Buffer> BufferPool::acquire(size_t size) {
+    size_t capacity = size_class(size);
+    Buffer* buffer = nullptr;
+    {
+        std::lock_guard<tl::mutex> lock(m_mtx);
+        /* Any cached buffer large enough, within the next size class */
+        auto it = m_free.lower_bound(capacity);
+        if(it != m_free.end() && it->first <= size_class(capacity + 1)) {
+            buffer = it->second.back();
+            it->second.pop_back();
+            if(it->second.empty()) m_free.erase(it);
+            m_cached_bytes -= buffer->m_capacity;
+            m_reuses += 1;
+        } else {
+            m_allocations += 1;
+        }
+    }
+    if(buffer == nullptr)
+        buffer = allocate(capacity);
+    std::weak_ptr<BufferPool> weak_pool = shared_from_this();
+    return std::shared_ptr<Buffer>(buffer, [weak_pool](Buffer* b) {
+        if(auto pool = weak_pool.lock())
+            pool->release(b);
+        else
+            free_buffer(b);
+    });
+}
+
+void BufferPool::release(Buffer* buffer) {
+    {
+        std::lock_guard<tl::mutex> lock(m_mtx);
+        if(m_cached_bytes + buffer->m_capacity <= m_max_cached_bytes) {
+            m_free[buffer->m_capacity].push_back(buffer);
+            m_cached_bytes += buffer->m_capacity;
+            return;
+        }
+    }
+    free_buffer(buffer);
+}
+
+}
@@ -0,0 +1,107 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __AMS_BUFFER_POOL_H
+#define __AMS_BUFFER_POOL_H
+
+#include <thallium.hpp>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace ams {
+
+namespace tl = thallium;
+
+/**
+ * @brief Pool of receive buffers that bulk transfers land in.
+ *
+ * Buffers are allocated in size classes (4, 5, 6 or 7 times a power
+ * of two, so that at most a quarter of a buffer is wasted), exposed
+ * for RDMA once, and returned to the pool when the last reference to
+ * them goes away, typically when the request using them has been
+ * executed. Returned buffers are kept up to a number of bytes, so that
+ * a steady stream of similar meshes no longer allocates or registers
+ * memory.
+ */
+class BufferPool : public std::enable_shared_from_this<BufferPool> {
+
+    public:
+
+    struct Buffer {
+        char*    m_data     = nullptr;
+        size_t   m_capacity = 0;
+        bool     m_mapped   = false; /* allocated with mmap */
+        tl::bulk m_bulk;
+    };
+
+    /**
+     * @brief Constructor.
+     *
+     * @param engine Engine used to expose the buffers.
+     */
+    BufferPool(const tl::engine& engine)
+    : m_engine(engine) {}
+
+    ~BufferPool();
+
+    /**
+     * @brief Sets how many bytes of returned buffers are kept, and
+     * whether new buffers are backed by huge pages (when the system
+     * provides them; regular pages are used otherwise).
+     */
+    void configure(size_t max_cached_bytes, bool hugepages);
+
+    size_t maxCachedBytes() const {
+        return m_max_cached_bytes;
+    }
+
+    bool hugepages() const {
+        return m_hugepages;
+    }
+
+    /**
+     * @brief Returns a buffer of at least size bytes.
+     */
+    std::shared_ptr<Buffer> acquire(size_t size);
+
+    /**
+     * @brief Number of buffers allocated, and reused, so far.
+     */
+    size_t allocations() const {
+        return m_allocations;
+    }
+
+    size_t reuses() const {
+        return m_reuses;
+    }
+
+    /**
+     * @brief Total size of the buffers held by the pool.
+     */
+    size_t cachedBytes() const {
+        return m_cached_bytes;
+    }
+
+    private:
+
+    static size_t size_class(size_t size);
+    Buffer* allocate(size_t capacity);
+    static void free_buffer(Buffer* buffer);
+    void release(Buffer* buffer);
+
+    tl::engine m_engine;
+    tl::mutex  m_mtx;
+    size_t     m_max_cached_bytes = 1024UL * 1024 * 1024;
+    bool       m_hugepages        = false;
+    size_t     m_cached_bytes     = 0;
+    size_t     m_allocations      = 0;
+    size_t     m_reuses           = 0;
+    std::map<size_t, std::vector<Buffer*>> m_free; // by capacity
+};
+
+}
+
+#endif
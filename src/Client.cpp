@@ -52,7 +52,7 @@ NodeHandle Client::makeNodeHandle(
         uint16_t provider_id,
         const UUID& node_id,
         bool check) const {
-    auto endpoint  = self->m_engine.lookup(address);
+    auto endpoint  = self->m_endpoints.lookup(self->m_engine, address);
     auto ph        = tl::provider_handle(endpoint, provider_id);
     RequestResult<bool> result;
     result.success() = true;
@@ -60,7 +60,8 @@ NodeHandle Client::makeNodeHandle(
         result = self->m_check_node.on(ph)(node_id);
     }
     if(result.success()) {
-        auto node_impl = std::make_shared<NodeHandleImpl>(self, std::move(ph), node_id);
+        auto node_impl = std::make_shared<NodeHandleImpl>(self, std::move(ph), node_id,
+                                                          self->m_load_hints.get(address, provider_id));
         return NodeHandle(node_impl);
     } else {
         throw Exception(result.error());
@@ -68,8 +69,53 @@ NodeHandle Client::makeNodeHandle(
     }
 }
 
+InstanceInfo Client::getInstance(const std::string& address,
+                                 uint16_t provider_id) const {
+    auto endpoint  = self->m_endpoints.lookup(self->m_engine, address);
+    auto ph        = tl::provider_handle(endpoint, provider_id);
+    RequestResult<std::string> result = self->m_get_directory.on(ph)();
+    if(not result.success())
+        throw Exception(result.error());
+    InstanceInfo instance;
+    try {
+        auto directory = nlohmann::json::parse(result.value());
+        auto parse_load = [](const nlohmann::json& j) {
+            ServerLoad load;
+            load.queued_requests = j.at("queued_requests").get<uint64_t>();
+            load.queued_bytes = j.at("queued_bytes").get<uint64_t>();
+            load.eta = j.value("eta", 0.0);
+            load.executing = j.value("executing", false);
+            load.memory_pressure = j.value("memory_pressure", false);
+            return load;
+        };
+        for(auto& m : directory.at("members")) {
+            ServiceMember member;
+            member.instance_rank = (int)instance.members.size();
+            member.address = m.at("address").get<std::string>();
+            if(not m.at("nodes").empty())
+                member.node_id = UUID::from_string(m["nodes"][0].get<std::string>().c_str());
+            member.load = parse_load(m.at("load"));
+            instance.members.push_back(std::move(member));
+        }
+        instance.load = parse_load(directory.at("load"));
+    } catch(const std::exception& ex) {
+        throw Exception("Malformed directory from " + address + ": " + ex.what());
+    }
+    return instance;
+}
+
 std::string Client::getConfig() const {
     return "{}";
 }
 
+void Client::setRegistrationCacheSize(size_t bytes) const {
+    if(not self) throw Exception("Invalid ams::Client object");
+    self->m_registrations.setCapacity(bytes);
+}
+
+void Client::invalidateRegistrations(const void* ptr, size_t size) const {
+    if(not self) throw Exception("Invalid ams::Client object");
+    self->m_registrations.invalidate(ptr, size);
+}
+
 }
@@ -11,6 +11,9 @@
 #include <thallium/serialization/stl/unordered_map.hpp>
 #include <thallium/serialization/stl/string.hpp>
 #include <ascent.hpp>
+#include "EndpointCache.hpp"
+#include "LoadHintCache.hpp"
+#include "RegistrationCache.hpp"
 
 namespace ams {
 
@@ -32,6 +35,21 @@ class ClientImpl {
     tl::remote_procedure m_ams_publish_and_execute;
     tl::remote_procedure m_ams_open_publish_execute;
     tl::remote_procedure m_ams_execute_pending_requests;
+    tl::remote_procedure m_ams_create_mesh;
+    tl::remote_procedure m_ams_execute_on_mesh;
+    tl::remote_procedure m_ams_release_mesh;
+    tl::remote_procedure m_ams_release_subtrees;
+    tl::remote_procedure m_ams_open_session;
+    tl::remote_procedure m_ams_register_pipeline;
+    tl::remote_procedure m_ams_session_publish;
+    tl::remote_procedure m_ams_close_session;
+    tl::remote_procedure m_get_directory;
+    tl::remote_procedure m_get_load;
+    /* Bulk handles of the arrays of meshes sent by bulk transfer */
+    RegistrationCache    m_registrations;
+    EndpointCache        m_endpoints;
+    /* Load hints attached by servers to their responses */
+    LoadHintCache        m_load_hints;
 
     ClientImpl(const tl::engine& engine)
     : m_engine(engine)
@@ -45,6 +63,17 @@ class ClientImpl {
     , m_ams_publish_and_execute(m_engine.define("ams_publish_and_execute"))
     , m_ams_open_publish_execute(m_engine.define("ams_open_publish_execute"))
     , m_ams_execute_pending_requests(m_engine.define("ams_execute_pending_requests").disable_response())
+    , m_ams_create_mesh(m_engine.define("ams_create_mesh"))
+    , m_ams_execute_on_mesh(m_engine.define("ams_execute_on_mesh"))
+    , m_ams_release_mesh(m_engine.define("ams_release_mesh"))
+    , m_ams_release_subtrees(m_engine.define("ams_release_subtrees").disable_response())
+    , m_ams_open_session(m_engine.define("ams_open_session"))
+    , m_ams_register_pipeline(m_engine.define("ams_register_pipeline"))
+    , m_ams_session_publish(m_engine.define("ams_session_publish"))
+    , m_ams_close_session(m_engine.define("ams_close_session"))
+    , m_get_directory(m_engine.define("ams_get_directory"))
+    , m_get_load(m_engine.define("ams_get_load"))
+    , m_registrations(m_engine)
     {}
 
     ClientImpl(margo_instance_id mid)
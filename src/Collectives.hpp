@@ -0,0 +1,66 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __AMS_COLLECTIVES_HPP
+#define __AMS_COLLECTIVES_HPP
+
+#include <abt.h>
+#include <mpi.h>
+
+namespace ams {
+
+/*
+ * Collectives issued by RPC handlers to coordinate the ranks of an
+ * instance. They use the non-blocking MPI collectives and poll them with
+ * MPI_Test, yielding in between, so that other handlers and the network
+ * progress loop keep running on the execution stream while slower ranks
+ * catch up. As with blocking collectives, every rank must issue the same
+ * collectives in the same order on a communicator: handlers that may
+ * run concurrently must serialize their collectives (e.g. with a
+ * thallium::mutex, which yields rather than blocking the stream), and
+ * independent objects must not share a communicator: a collective
+ * waiting here lets those of another object start in a different order
+ * on each rank. Each node has its own duplicate (see Backend::comm).
+ */
+
+/**
+ * @brief Waits for a non-blocking MPI operation, yielding to other
+ * ULTs until it completes.
+ */
+inline int wait_yielding(MPI_Request& request) {
+    int done = 0;
+    int ret = MPI_Test(&request, &done, MPI_STATUS_IGNORE);
+    while(ret == MPI_SUCCESS && not done) {
+        ABT_thread_yield();
+        ret = MPI_Test(&request, &done, MPI_STATUS_IGNORE);
+    }
+    return ret;
+}
+
+/**
+ * @brief MPI_Allreduce that yields while waiting for the other ranks.
+ */
+inline int allreduce_yielding(const void* sendbuf, void* recvbuf, int count,
+                              MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
+    MPI_Request request;
+    int ret = MPI_Iallreduce(sendbuf, recvbuf, count, datatype, op, comm, &request);
+    if(ret != MPI_SUCCESS) return ret;
+    return wait_yielding(request);
+}
+
+/**
+ * @brief MPI_Bcast that yields while waiting for the root.
+ */
+inline int bcast_yielding(void* buffer, int count, MPI_Datatype datatype,
+                          int root, MPI_Comm comm) {
+    MPI_Request request;
+    int ret = MPI_Ibcast(buffer, count, datatype, root, comm, &request);
+    if(ret != MPI_SUCCESS) return ret;
+    return wait_yielding(request);
+}
+
+}
+
+#endif
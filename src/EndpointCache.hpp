@@ -0,0 +1,48 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __AMS_ENDPOINT_CACHE_H
+#define __AMS_ENDPOINT_CACHE_H
+
+#include <thallium.hpp>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace ams {
+
+namespace tl = thallium;
+
+/**
+ * @brief Endpoints of the addresses looked up by a Client or an
+ * Admin, so that each address is resolved once rather than for
+ * every NodeHandle or node operation.
+ */
+class EndpointCache {
+
+    public:
+
+    tl::endpoint lookup(const tl::engine& engine, const std::string& address) {
+        {
+            std::lock_guard<std::mutex> lock(m_mtx);
+            auto it = m_endpoints.find(address);
+            if(it != m_endpoints.end())
+                return it->second;
+        }
+        /* Not holding the lock: the lookup may block */
+        tl::endpoint endpoint = engine.lookup(address);
+        std::lock_guard<std::mutex> lock(m_mtx);
+        return m_endpoints.emplace(address, endpoint).first->second;
+    }
+
+    private:
+
+    std::unordered_map<std::string, tl::endpoint> m_endpoints;
+    std::mutex                                    m_mtx;
+};
+
+}
+
+#endif
@@ -0,0 +1,156 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "FieldTransfer.hpp"
+#include "WallTime.hpp"
+#include <vector>
+
+namespace ams {
+
+static void smooth(double& estimate, double sample) {
+    estimate = estimate == 0.0 ? sample : 0.75*estimate + 0.25*sample;
+}
+
+/* Views are only read (serialized), see ActionAnalysis.cpp */
+static void reference(conduit::Node& dst, const conduit::Node& src) {
+    dst.set_external(const_cast<conduit::Node&>(src));
+}
+
+const FieldTransferOptions* FieldTransfer::options_of(const std::string& field) const {
+    auto it = m_options.find(field);
+    if(it == m_options.end()) it = m_options.find("*");
+    return it == m_options.end() ? nullptr : &it->second;
+}
+
+/* Unmeasured costs are taken as worth paying, so that they get measured */
+bool FieldTransfer::worth(bool adaptive, double saved_bytes, double cost_seconds) const {
+    if(not adaptive || m_bandwidth == 0.0) return true;
+    return saved_bytes / m_bandwidth > cost_seconds;
+}
+
+bool FieldTransfer::encode_values(const std::string& field, const FieldTransferOptions& options,
+                                  const conduit::Node& values, conduit::Node& view) {
+    const conduit::DataType& dt = values.dtype();
+    if(dt.is_object() || dt.is_list()) { // multi-component values
+        bool changed = false;
+        for(conduit::index_t i = 0; i < values.number_of_children(); i++) {
+            const conduit::Node& component = values.child(i);
+            conduit::Node& dst = dt.is_object() ? view[component.name()] : view.append();
+            changed |= encode_values(field, options, component, dst);
+        }
+        return changed;
+    }
+    if(not dt.is_number()) {
+        reference(view, values);
+        return false;
+    }
+
+    const conduit::Node* leaf = &values;
+    conduit::Node converted;
+    double bytes = (double)dt.bytes_compact();
+    if(options.to_float32 && dt.is_float64()
+    && worth(options.adaptive, bytes/2, m_convert_rate == 0.0 ? 0.0 : bytes/m_convert_rate)) {
+        double start = wall_time();
+        values.to_float32_array(converted);
+        double elapsed = wall_time() - start;
+        if(elapsed > 0.0) smooth(m_convert_rate, bytes/elapsed);
+        leaf = &converted;
+        bytes /= 2;
+    }
+
+    double ratio = m_ratios.count(field) ? m_ratios[field] : 0.0;
+    if(options.compress
+    && worth(options.adaptive, bytes*(1.0 - ratio), m_compress_rate == 0.0 ? 0.0 : 2*bytes/m_compress_rate)) {
+        const conduit::DataType& leaf_dt = leaf->dtype();
+        size_t count = (size_t)leaf_dt.number_of_elements();
+        size_t word_size = (size_t)leaf_dt.element_bytes();
+        double start = wall_time();
+        std::vector<uint8_t> compact;
+        const void* data = leaf->element_ptr(0);
+        if(not leaf_dt.is_compact()) {
+            compact.resize(count * word_size);
+            leaf->compact_elements_to(compact.data());
+            data = compact.data();
+        }
+        std::vector<uint8_t> encoded = compress_words(data, count, word_size);
+        double elapsed = wall_time() - start;
+        if(elapsed > 0.0) smooth(m_compress_rate, bytes/elapsed);
+        if(bytes > 0) smooth(m_ratios[field], encoded.size()/bytes);
+        if(encoded.size() < bytes) {
+            view["ams_codec"] = word_codec_name;
+            view["dtype"] = conduit::DataType::id_to_name(leaf_dt.id());
+            view["count"] = (conduit::int64)count;
+            view["data"].set_uint8_ptr(encoded.data(), (conduit::index_t)encoded.size());
+            return true;
+        }
+    }
+
+    if(leaf == &converted) {
+        view.set(converted);
+        return true;
+    }
+    reference(view, values);
+    return false;
+}
+
+bool FieldTransfer::encode_domain(const conduit::Node& domain, conduit::Node& view) {
+    bool changed = false;
+    for(conduit::index_t i = 0; i < domain.number_of_children(); i++) {
+        const conduit::Node& group = domain.child(i);
+        const std::string group_name = group.name();
+        if(group_name != "fields") {
+            reference(view[group_name], group);
+            continue;
+        }
+        for(conduit::index_t f = 0; f < group.number_of_children(); f++) {
+            const conduit::Node& field = group.child(f);
+            conduit::Node& dst = view["fields"][field.name()];
+            const FieldTransferOptions* options = options_of(field.name());
+            if(options == nullptr || not field.has_child("values")
+            || not (options->to_float32 || options->compress)) {
+                reference(dst, field);
+                continue;
+            }
+            for(conduit::index_t c = 0; c < field.number_of_children(); c++) {
+                const conduit::Node& child = field.child(c);
+                if(child.name() == "values")
+                    changed |= encode_values(field.name(), *options, child, dst["values"]);
+                else
+                    reference(dst[child.name()], child);
+            }
+        }
+    }
+    return changed;
+}
+
+bool FieldTransfer::encode(const conduit::Node& mesh, conduit::Node& view) {
+    if(m_options.empty()) return false;
+    view.reset();
+    bool changed = false;
+    try {
+        if(mesh.has_child("coordsets")) {
+            changed = encode_domain(mesh, view);
+        } else if(mesh.dtype().is_list()) {
+            for(conduit::index_t d = 0; d < mesh.number_of_children(); d++)
+                changed |= encode_domain(mesh.child(d), view.append());
+        } else if(mesh.dtype().is_object()) {
+            for(conduit::index_t d = 0; d < mesh.number_of_children(); d++) {
+                const conduit::Node& domain = mesh.child(d);
+                changed |= encode_domain(domain, view[domain.name()]);
+            }
+        }
+    } catch(const conduit::Error&) {
+        changed = false;
+    }
+    if(not changed) view.reset();
+    return changed;
+}
+
+void FieldTransfer::recordTransfer(size_t bytes, double seconds) {
+    if(seconds > 0.0 && bytes > 0)
+        smooth(m_bandwidth, bytes/seconds);
+}
+
+}
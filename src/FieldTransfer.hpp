@@ -0,0 +1,95 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __AMS_FIELD_TRANSFER_H
+#define __AMS_FIELD_TRANSFER_H
+
+#include <ams/FieldCodec.hpp>
+#include <conduit.hpp>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace ams {
+
+/**
+ * @brief Client side of the per-field transfer options.
+ *
+ * Values converted to float32 are sent as regular float32 arrays.
+ * Compressed values are replaced by an "ams_codec" node (codec name,
+ * dtype, number of elements and encoded bytes) that the server decodes
+ * when it ingests the mesh.
+ *
+ * The costs used by adaptive options are smoothed measurements: the
+ * link bandwidth (bytes sent per second of the requests sending a
+ * mesh, from the payload being ready to the response, which includes
+ * the server's ingestion), the throughput of each transformation, and
+ * the compression ratio of each field. Decoding is assumed to cost as
+ * much as encoding.
+ */
+class FieldTransfer {
+
+    public:
+
+    std::unordered_map<std::string, FieldTransferOptions> m_options; // "*": other fields
+    double m_bandwidth = 0.0; // bytes/s, 0 until measured
+
+    /**
+     * @brief Builds a view of mesh in which the values of the fields
+     * with transfer options are converted and/or compressed. Other
+     * data is referenced.
+     *
+     * @return false if the mesh is to be sent as is.
+     */
+    bool encode(const conduit::Node& mesh, conduit::Node& view);
+
+    /**
+     * @brief Folds the time taken to send a number of bytes into the
+     * measured link bandwidth.
+     */
+    void recordTransfer(size_t bytes, double seconds);
+
+    private:
+
+    const FieldTransferOptions* options_of(const std::string& field) const;
+    bool encode_domain(const conduit::Node& domain, conduit::Node& view);
+    bool encode_values(const std::string& field, const FieldTransferOptions& options,
+                       const conduit::Node& values, conduit::Node& view);
+    bool worth(bool adaptive, double saved_bytes, double cost_seconds) const;
+
+    double m_convert_rate  = 0.0; // bytes/s converted to float32, 0 until measured
+    double m_compress_rate = 0.0; // bytes/s compressed, 0 until measured
+    std::unordered_map<std::string, double> m_ratios; // compressed/raw size per field
+};
+
+/**
+ * @brief Decodes, in place, the field values of a mesh encoded by
+ * FieldTransfer::encode. Throws std::runtime_error on an unknown codec
+ * or corrupted values.
+ */
+inline void decode_fields(conduit::Node& node) {
+    if(not node.dtype().is_object() && not node.dtype().is_list())
+        return;
+    if(node.dtype().is_object() && node.has_child("ams_codec")) {
+        std::string codec = node["ams_codec"].as_string();
+        if(codec != word_codec_name)
+            throw std::runtime_error("Unknown field codec " + codec);
+        conduit::DataType dt(conduit::DataType::name_to_id(node["dtype"].as_string()),
+                             node["count"].to_int64());
+        conduit::Node encoded;
+        encoded.set(node["data"]);
+        node.reset();
+        node.set(dt);
+        decompress_words(encoded.as_uint8_ptr(), encoded.dtype().number_of_elements(),
+                         node.element_ptr(0), dt.number_of_elements(), dt.element_bytes());
+        return;
+    }
+    for(conduit::index_t i = 0; i < node.number_of_children(); i++)
+        decode_fields(node.child(i));
+}
+
+}
+
+#endif
@@ -0,0 +1,73 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __AMS_LOAD_HINT_CACHE_H
+#define __AMS_LOAD_HINT_CACHE_H
+
+#include <ams/ServerLoad.hpp>
+#include "WallTime.hpp"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace ams {
+
+/**
+ * @brief Latest load hint attached by a server (a provider at an
+ * address) to its responses.
+ */
+class ServerLoadHint {
+
+    public:
+
+    void update(const LoadHint& hint) {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_hint     = hint;
+        m_received = wall_time();
+    }
+
+    /* Returns false if no hint has been received yet */
+    bool get(LoadHint& hint, double* age) const {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        if(m_received == 0.0) return false;
+        hint = m_hint;
+        if(age) *age = wall_time() - m_received;
+        return true;
+    }
+
+    private:
+
+    mutable std::mutex m_mtx;
+    LoadHint           m_hint;
+    double             m_received = 0.0;
+};
+
+/**
+ * @brief Load hints of the servers a Client talks to, shared by the
+ * NodeHandles targeting the same server so that a response to any of
+ * them refreshes the hint seen by all.
+ */
+class LoadHintCache {
+
+    public:
+
+    std::shared_ptr<ServerLoadHint> get(const std::string& address, uint16_t provider_id) {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        auto& hint = m_hints[address + "#" + std::to_string(provider_id)];
+        if(not hint) hint = std::make_shared<ServerLoadHint>();
+        return hint;
+    }
+
+    private:
+
+    std::unordered_map<std::string, std::shared_ptr<ServerLoadHint>> m_hints;
+    std::mutex                                                        m_mtx;
+};
+
+}
+
+#endif
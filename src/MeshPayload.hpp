@@ -0,0 +1,44 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __AMS_MESH_PAYLOAD_H
+#define __AMS_MESH_PAYLOAD_H
+
+#include <thallium.hpp>
+#include <thallium/serialization/stl/string.hpp>
+#include <thallium/serialization/stl/vector.hpp>
+#include <string>
+#include <vector>
+
+namespace ams {
+
+namespace tl = thallium;
+
+/**
+ * @brief A mesh as sent in an RPC: either serialized inline
+ * (conduit_base64_json), or as the compact schema of the mesh along
+ * with the bulk handles of its data, in schema order, for the
+ * provider to pull. A late-bound mesh is pulled when the server is
+ * about to render it rather than on reception.
+ */
+struct MeshPayload {
+
+    std::string           m_serialized;
+    std::string           m_schema;
+    std::vector<tl::bulk> m_segments;
+    bool                  m_late = false;
+
+    template<typename A>
+    void serialize(A& ar) {
+        ar & m_serialized;
+        ar & m_schema;
+        ar & m_segments;
+        ar & m_late;
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,121 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __AMS_MPI_PROXY_H
+#define __AMS_MPI_PROXY_H
+
+#include <thallium.hpp>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace ams {
+
+namespace tl = thallium;
+
+/**
+ * @brief Funnels the work that uses MPI (collectives, Ascent) through
+ * the execution stream of a given pool, so that RPC handlers running on
+ * several execution streams never enter MPI concurrently.
+ *
+ * - Running on a pool of the primary execution stream (the one that
+ *   called MPI_Init) only requires MPI_THREAD_FUNNELED. This is the
+ *   providers' default.
+ * - Running on a dedicated execution stream requires
+ *   MPI_THREAD_SERIALIZED, and keeps long MPI work (renders) off the
+ *   primary stream.
+ * - Without a proxy, work runs in the calling handler, which requires
+ *   MPI_THREAD_MULTIPLE if handlers run on several streams.
+ */
+class MpiProxy {
+
+    public:
+
+    enum class Mode { NONE, PRIMARY, XSTREAM };
+
+    /**
+     * @brief Constructor. PRIMARY must be used from a ULT of the
+     * primary execution stream.
+     */
+    MpiProxy(Mode mode)
+    : m_mode(mode) {
+        if(mode == Mode::PRIMARY) {
+            m_xstream = tl::xstream::self();
+            m_pool    = m_xstream.get_main_pools(1)[0];
+        } else if(mode == Mode::XSTREAM) {
+            m_managed_pool.reset(new tl::managed<tl::pool>(
+                tl::pool::create(tl::pool::access::mpmc)));
+            m_pool = **m_managed_pool;
+            m_managed_xstream.reset(new tl::managed<tl::xstream>(
+                tl::xstream::create(tl::scheduler::predef::basic_wait, m_pool)));
+            m_xstream = **m_managed_xstream;
+        }
+    }
+
+    MpiProxy(const MpiProxy&) = delete;
+    MpiProxy& operator=(const MpiProxy&) = delete;
+
+    ~MpiProxy() {
+        if(m_managed_xstream)
+            m_xstream.join();
+    }
+
+    Mode mode() const {
+        return m_mode;
+    }
+
+    /**
+     * @brief XSTREAM proxy shared by the providers of the process, so
+     * that MPI is only entered from one execution stream.
+     */
+    static std::shared_ptr<MpiProxy> shared_xstream() {
+        static std::mutex               mtx;
+        static std::weak_ptr<MpiProxy>  shared;
+        std::lock_guard<std::mutex> lock(mtx);
+        auto proxy = shared.lock();
+        if(not proxy) {
+            proxy = std::make_shared<MpiProxy>(Mode::XSTREAM);
+            shared = proxy;
+        }
+        return proxy;
+    }
+
+    /**
+     * @brief Runs f on the proxy's execution stream and waits for it,
+     * yielding, rethrowing the exception it throws if any.
+     */
+    template<typename F>
+    void run(F&& f) {
+        if(m_mode == Mode::NONE || tl::xstream::self() == m_xstream) {
+            f();
+            return;
+        }
+        tl::eventual<void> done;
+        std::exception_ptr error;
+        m_pool.make_thread([&f, &done, &error]() {
+            try {
+                f();
+            } catch(...) {
+                error = std::current_exception();
+            }
+            done.set_value();
+        }, tl::anonymous());
+        done.wait();
+        if(error) std::rethrow_exception(error);
+    }
+
+    private:
+
+    Mode                                      m_mode;
+    tl::pool                                  m_pool;
+    tl::xstream                               m_xstream;
+    std::unique_ptr<tl::managed<tl::pool>>    m_managed_pool;
+    std::unique_ptr<tl::managed<tl::xstream>> m_managed_xstream;
+};
+
+}
+
+#endif
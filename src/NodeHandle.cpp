@@ -6,14 +6,23 @@
 #include "ams/NodeHandle.hpp"
 #include "ams/RequestResult.hpp"
 #include "ams/Exception.hpp"
+#include "ams/ActionAnalysis.hpp"
 
 #include "AsyncRequestImpl.hpp"
 #include "ClientImpl.hpp"
 #include "NodeHandleImpl.hpp"
+#include "MeshPayload.hpp"
+#include "WallTime.hpp"
 
 #include <thallium/serialization/stl/string.hpp>
 #include <thallium/serialization/stl/pair.hpp>
 #include <thallium/async_response.hpp>
+#include <cstdint>
+#include <functional>
+#include <exception>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 #include <conduit.hpp>
 #include <mpi.h>
 
@@ -42,92 +51,862 @@ Client NodeHandle::client() const {
     return Client(self->m_client);
 }
 
-void NodeHandle::sayHello() const {
+/* Sends an RPC that responds with a RequestResult<bool>. Without req, waits
+ * for the response and throws on failure; otherwise returns immediately and
+ * attaches the pending response to *req. Load hints attached to the
+ * response are recorded in hints. */
+template<typename ... Args>
+static void send_rpc(tl::remote_procedure& rpc,
+                   const tl::provider_handle& ph,
+                   const std::shared_ptr<ServerLoadHint>& hints,
+                   AsyncRequest* req,
+                   std::shared_ptr<AsyncRequestImpl>& async_request_impl,
+                   Args&&... args) {
+    if(req == nullptr) { // synchronous call
+        RequestResult<bool> result = rpc.on(ph)(std::forward<Args>(args)...);
+        if(result.hasLoadHint()) hints->update(result.loadHint());
+        if(not result.success()) {
+            throw Exception(result.error());
+        }
+    } else { // asynchronous call
+        auto async_response = rpc.on(ph).async(std::forward<Args>(args)...);
+        async_request_impl =
+            std::make_shared<AsyncRequestImpl>(std::move(async_response));
+        async_request_impl->m_wait_callback =
+            [hints](AsyncRequestImpl& async_request_impl) {
+                RequestResult<bool> result =
+                    async_request_impl.m_async_response.wait();
+                if(result.hasLoadHint()) hints->update(result.loadHint());
+                if(not result.success()) {
+                    throw Exception(result.error());
+                }
+            };
+    }
+}
+
+/* Same as send_rpc, for RPCs responding with a RequestResult<T>
+ * whose value is passed to on_value on success */
+template<typename T, typename OnValue, typename ... Args>
+static void send_rpc_value(tl::remote_procedure& rpc,
+                           const tl::provider_handle& ph,
+                           const std::shared_ptr<ServerLoadHint>& hints,
+                           AsyncRequest* req,
+                           std::shared_ptr<AsyncRequestImpl>& async_request_impl,
+                           OnValue on_value,
+                           Args&&... args) {
+    if(req == nullptr) { // synchronous call
+        RequestResult<T> result = rpc.on(ph)(std::forward<Args>(args)...);
+        if(result.hasLoadHint()) hints->update(result.loadHint());
+        if(not result.success()) {
+            throw Exception(result.error());
+        }
+        on_value(result.value());
+    } else { // asynchronous call
+        auto async_response = rpc.on(ph).async(std::forward<Args>(args)...);
+        async_request_impl =
+            std::make_shared<AsyncRequestImpl>(std::move(async_response));
+        async_request_impl->m_wait_callback =
+            [hints, on_value](AsyncRequestImpl& async_request_impl) {
+                RequestResult<T> result =
+                    async_request_impl.m_async_response.wait();
+                if(result.hasLoadHint()) hints->update(result.loadHint());
+                if(not result.success()) {
+                    throw Exception(result.error());
+                }
+                on_value(result.value());
+            };
+    }
+}
+
+/* on_value function storing the value in *ptr, if ptr is not null */
+template<typename T>
+static std::function<void(const T&)> store_to(T* ptr) {
+    return [ptr](const T& value) { if(ptr) *ptr = value; };
+}
+
+/* Same as send_rpc, for RPCs defined with disable_response() */
+template<typename ... Args>
+static void send_rpc_no_response(tl::remote_procedure& rpc,
+                               const tl::provider_handle& ph,
+                               AsyncRequest* req,
+                               std::shared_ptr<AsyncRequestImpl>& async_request_impl,
+                               Args&&... args) {
+    if(req == nullptr) {
+        rpc.on(ph)(std::forward<Args>(args)...);
+    } else {
+        auto async_response = rpc.on(ph).async(std::forward<Args>(args)...);
+        async_request_impl =
+            std::make_shared<AsyncRequestImpl>(std::move(async_response));
+        async_request_impl->m_wait_callback =
+            [](AsyncRequestImpl& async_request_impl) {
+                async_request_impl.m_async_response.wait();
+            };
+    }
+}
+
+void NodeHandle::sayHello(AsyncRequest* req) const {
     if(not self) throw Exception("Invalid ams::NodeHandle object");
     auto& rpc = self->m_client->m_say_hello;
     auto& ph  = self->m_ph;
     auto& node_id = self->m_node_id;
-    rpc.on(ph)(node_id);
+    std::shared_ptr<AsyncRequestImpl> async_request_impl;
+    send_rpc_no_response(rpc, ph, req, async_request_impl, node_id);
+    if(req) *req = AsyncRequest(std::move(async_request_impl));
 }
 
 /* SR: Core Ascent APIs */
-void NodeHandle::ams_execute_pending_requests() const {
+void NodeHandle::ams_execute_pending_requests(AsyncRequest* req) const {
     if(not self) throw Exception("Invalid ams::NodeHandle object");
     auto& rpc = self->m_client->m_ams_execute_pending_requests;
     auto& ph  = self->m_ph;
     auto& node_id = self->m_node_id;
-    rpc.on(ph)(node_id);
+    std::shared_ptr<AsyncRequestImpl> async_request_impl;
+    send_rpc_no_response(rpc, ph, req, async_request_impl, node_id);
+    if(req) *req = AsyncRequest(std::move(async_request_impl));
 }
 
-void NodeHandle::ams_open(conduit::Node opts) const {
+void NodeHandle::ams_open(const conduit::Node& opts, AsyncRequest* req) const {
     if(not self) throw Exception("Invalid ams::NodeHandle object");
     auto& rpc = self->m_client->m_ams_open;
     auto& ph  = self->m_ph;
     auto& node_id = self->m_node_id;
-    RequestResult<bool> result = rpc.on(ph)(node_id, opts.to_string("conduit_json"));
-    if(not result.success()) {
-        throw Exception(result.error());
-    }
+    std::shared_ptr<AsyncRequestImpl> async_request_impl;
+    send_rpc(rpc, ph, self->m_load_hint, req, async_request_impl, node_id, opts.to_string("conduit_json"));
+    if(req) *req = AsyncRequest(std::move(async_request_impl));
 }
 
-void NodeHandle::ams_publish(conduit::Node bp_mesh) const {
+void NodeHandle::ams_publish(const conduit::Node& bp_mesh, AsyncRequest* req) const {
     if(not self) throw Exception("Invalid ams::NodeHandle object");
     auto& rpc = self->m_client->m_ams_publish;
     auto& ph  = self->m_ph;
     auto& node_id = self->m_node_id;
-    RequestResult<bool> result = rpc.on(ph)(node_id, bp_mesh.to_string("conduit_json"));
-    if(not result.success()) {
-        throw Exception(result.error());
-    }
+    std::shared_ptr<AsyncRequestImpl> async_request_impl;
+    send_rpc(rpc, ph, self->m_load_hint, req, async_request_impl, node_id, bp_mesh.to_string("conduit_json"));
+    if(req) *req = AsyncRequest(std::move(async_request_impl));
 }
 
-void NodeHandle::ams_execute(conduit::Node actions) const {
+void NodeHandle::ams_execute(const conduit::Node& actions, AsyncRequest* req) const {
     if(not self) throw Exception("Invalid ams::NodeHandle object");
     auto& rpc = self->m_client->m_ams_execute;
     auto& ph  = self->m_ph;
     auto& node_id = self->m_node_id;
-    RequestResult<bool> result = rpc.on(ph)(node_id, actions.to_string("conduit_json"));
-    if(not result.success()) {
-        throw Exception(result.error());
-    }
+    std::shared_ptr<AsyncRequestImpl> async_request_impl;
+    send_rpc(rpc, ph, self->m_load_hint, req, async_request_impl, node_id, actions.to_string("conduit_json"));
+    if(req) *req = AsyncRequest(std::move(async_request_impl));
 }
 
-void NodeHandle::ams_publish_and_execute(conduit::Node bp_mesh, conduit::Node actions) const {
+void NodeHandle::ams_publish_and_execute(const conduit::Node& bp_mesh, const conduit::Node& actions,
+                                         AsyncRequest* req) const {
     if(not self) throw Exception("Invalid ams::NodeHandle object");
     auto& rpc = self->m_client->m_ams_publish_and_execute;
     auto& ph  = self->m_ph;
     auto& node_id = self->m_node_id;
-    RequestResult<bool> result = rpc.on(ph)(node_id, bp_mesh.to_string("conduit_json"), actions.to_string("conduit_json"));
-    if(not result.success()) {
-        throw Exception(result.error());
+    std::shared_ptr<AsyncRequestImpl> async_request_impl;
+    const conduit::Node* mesh = &bp_mesh;
+    conduit::Node view;
+    if(self->m_prune_fields && select_fields(bp_mesh, analyze_actions(actions), view))
+        mesh = &view;
+    send_rpc(rpc, ph, self->m_load_hint, req, async_request_impl, node_id,
+           mesh->to_string("conduit_json"), actions.to_string("conduit_json"));
+    if(req) *req = AsyncRequest(std::move(async_request_impl));
+}
+
+/* A mesh ready to be sent. Data exposed for the server to pull must
+ * remain valid, and exposed, until the server responds. */
+struct OutgoingMesh {
+    MeshPayload                    m_payload;
+    std::vector<std::vector<char>> m_copies; // compacted non-contiguous leaves
+    size_t                         m_bytes = 0; // serialized or exposed bytes
+};
+
+/* Arrays smaller than this are not cached but exposed together */
+static const size_t MIN_CACHED_ARRAY = 64 * 1024;
+
+/* Data of the application's arrays, as opposed to the arrays
+ * allocated by the client to send a mesh (see FieldTransfer) */
+using ArraySet = std::unordered_set<const void*>;
+
+static void collect_arrays(const conduit::Node& node, ArraySet& arrays) {
+    if(node.dtype().is_object() || node.dtype().is_list()) {
+        for(conduit::index_t i = 0; i < node.number_of_children(); i++)
+            collect_arrays(node.child(i), arrays);
+    } else if(node.dtype().number_of_elements() > 0) {
+        arrays.insert(node.element_ptr(0));
+    }
+}
+
+/* Bulk handles of the leaves under a node, in the order of the node's
+ * compact schema. Large application arrays are exposed through the
+ * registration cache, other leaves are grouped in uncached handles. */
+struct SegmentCollector {
+    RegistrationCache&                    m_registrations;
+    const ArraySet*                       m_arrays; // null: all arrays are the application's
+    std::vector<tl::bulk>&                m_segments;
+    std::vector<std::vector<char>>&       m_copies;
+    tl::engine&                           m_engine;
+    std::vector<std::pair<void*, size_t>> m_group;
+
+    void flush() {
+        if(m_group.empty()) return;
+        m_segments.push_back(m_engine.expose(m_group, tl::bulk_mode::read_only));
+        m_group.clear();
+    }
+
+    void collect(const conduit::Node& node) {
+        const conduit::DataType& dt = node.dtype();
+        if(dt.is_object() || dt.is_list()) {
+            for(conduit::index_t i = 0; i < node.number_of_children(); i++)
+                collect(node.child(i));
+            return;
+        }
+        size_t bytes = dt.bytes_compact();
+        if(bytes == 0) return;
+        void* data = const_cast<void*>(node.element_ptr(0));
+        if(not dt.is_compact()) {
+            m_copies.emplace_back(bytes);
+            node.compact_elements_to(reinterpret_cast<conduit::uint8*>(m_copies.back().data()));
+            m_group.emplace_back(m_copies.back().data(), bytes);
+        } else if(bytes >= MIN_CACHED_ARRAY && (m_arrays == nullptr || m_arrays->count(data))) {
+            flush();
+            m_segments.push_back(m_registrations.expose(data, bytes));
+        } else {
+            m_group.emplace_back(data, bytes);
+        }
+    }
+};
+
+/* Releases the registrations of the arrays of a mesh about to be freed */
+static void invalidate_registrations(ClientImpl& client, const conduit::Node& mesh) {
+    if(mesh.dtype().is_object() || mesh.dtype().is_list()) {
+        for(conduit::index_t i = 0; i < mesh.number_of_children(); i++)
+            invalidate_registrations(client, mesh.child(i));
+    } else if(mesh.dtype().number_of_elements() > 0) {
+        client.m_registrations.invalidate(mesh.element_ptr(0), mesh.dtype().bytes_compact());
     }
 }
 
-thallium::async_response NodeHandle::ams_open_publish_execute(conduit::Node open_opts, 
-		conduit::Node bp_mesh,
-		size_t mesh_size,
-	       	conduit::Node actions,
-		unsigned int ts) const {
+NodeHandleImpl::~NodeHandleImpl() {
+    if(not m_client) return;
+    /* Submitted requests may still refer to the slots' arrays and to
+     * the subtrees the server keeps for this handle */
+    for(auto& slot : m_slots) {
+        if(not slot.m_request) continue;
+        try {
+            slot.m_request.wait();
+        } catch(const std::exception&) {}
+    }
+    for(auto& slot : m_slots)
+        invalidate_registrations(*m_client, slot.m_mesh);
+    /* Lets the server drop those subtrees. Requests returned to the
+     * application and not waited on yet may then fail with an unknown
+     * subtree reference. */
+    if(m_subtree_refs.used()) {
+        try {
+            m_client->m_ams_release_subtrees.on(m_ph)(m_node_id, m_subtree_refs.m_client_id);
+        } catch(const std::exception&) {
+            /* The server may be gone; it then holds nothing either */
+        }
+    }
+}
+
+/* Serializes a mesh, or exposes its data for the server to pull if
+ * it is at least as large as the bulk threshold. Late-bound meshes are
+ * pulled when the server is about to render them. */
+static std::shared_ptr<OutgoingMesh> make_payload(NodeHandleImpl& impl, const conduit::Node& mesh,
+                                                  const ArraySet* arrays = nullptr,
+                                                  bool late = false) {
+    auto outgoing = std::make_shared<OutgoingMesh>();
+    if((size_t)mesh.total_bytes_compact() < impl.m_bulk_threshold) {
+        outgoing->m_payload.m_serialized = mesh.to_string("conduit_base64_json");
+        outgoing->m_bytes = outgoing->m_payload.m_serialized.size();
+        return outgoing;
+    }
+    outgoing->m_bytes = mesh.total_bytes_compact();
+    conduit::Schema schema;
+    mesh.schema().compact_to(schema);
+    outgoing->m_payload.m_schema = schema.to_json();
+    outgoing->m_payload.m_late   = late;
+    SegmentCollector collector{ impl.m_client->m_registrations, arrays,
+        outgoing->m_payload.m_segments, outgoing->m_copies, impl.m_client->m_engine, {} };
+    collector.collect(mesh);
+    collector.flush();
+    return outgoing;
+}
+
+/* Keeps an outgoing mesh until an asynchronous request completes */
+static void keep_until_response(const std::shared_ptr<OutgoingMesh>& outgoing,
+                                std::shared_ptr<AsyncRequestImpl>& async_request_impl) {
+    if(not async_request_impl || outgoing->m_payload.m_segments.empty()) return;
+    auto wait = std::move(async_request_impl->m_wait_callback);
+    async_request_impl->m_wait_callback =
+        [wait, outgoing](AsyncRequestImpl& async_request_impl) {
+            wait(async_request_impl);
+        };
+}
+
+/* Folds the time a request took to transfer an outgoing mesh, from the
+ * payload being ready to the response, into the measured bandwidth.
+ * An asynchronous request is only timed if it is waited on before its
+ * response arrives: once received, when it arrived is unknown, and the
+ * time until it is reaped (e.g. the next timestep of ams_submit) would
+ * be taken for the transfer. Late-bound ones, which complete once
+ * rendered, are not timed. */
+static void time_transfer(const std::shared_ptr<NodeHandleImpl>& impl,
+                          const std::shared_ptr<OutgoingMesh>& outgoing,
+                          double start,
+                          std::shared_ptr<AsyncRequestImpl>& async_request_impl) {
+    size_t bytes = outgoing->m_bytes;
+    if(not async_request_impl) {
+        impl->m_field_transfer.recordTransfer(bytes, wall_time() - start);
+        return;
+    }
+    if(outgoing->m_payload.m_late) return;
+    std::weak_ptr<NodeHandleImpl> weak_impl = impl;
+    auto wait = std::move(async_request_impl->m_wait_callback);
+    async_request_impl->m_wait_callback =
+        [wait, weak_impl, bytes, start](AsyncRequestImpl& async_request_impl) {
+            bool pending = not async_request_impl.m_async_response.received();
+            wait(async_request_impl);
+            if(not pending) return;
+            if(auto impl = weak_impl.lock())
+                impl->m_field_transfer.recordTransfer(bytes, wall_time() - start);
+        };
+}
+
+/* Whether a request failed because the server no longer holds a
+ * subtree it referred to (see SubtreeCache in the dummy backend) */
+static bool is_unknown_subtree(const Exception& ex) {
+    return std::string(ex.what()).find("Unknown subtree reference") != std::string::npos;
+}
+
+/* Records the completion of a request carrying encoded subtrees, and
+ * forgets what the server holds if it lost one of them */
+static void complete_subtrees(NodeHandleImpl& impl,
+                              const SubtreeRefs::Carried& carried,
+                              const Exception* error) {
+    impl.m_subtree_refs.complete(carried, error == nullptr);
+    if(error && is_unknown_subtree(*error))
+        impl.m_subtree_refs.forget();
+}
+
+/* Same, when an asynchronous request carrying them is waited on */
+static void track_subtrees(const std::shared_ptr<NodeHandleImpl>& impl,
+                           const SubtreeRefs::Carried& carried,
+                           std::shared_ptr<AsyncRequestImpl>& async_request_impl) {
+    std::weak_ptr<NodeHandleImpl> weak_impl = impl;
+    auto wait = std::move(async_request_impl->m_wait_callback);
+    async_request_impl->m_wait_callback =
+        [wait, weak_impl, carried](AsyncRequestImpl& async_request_impl) {
+            try {
+                wait(async_request_impl);
+            } catch(const Exception& ex) {
+                if(auto impl = weak_impl.lock())
+                    complete_subtrees(*impl, carried, &ex);
+                throw;
+            }
+            if(auto impl = weak_impl.lock())
+                complete_subtrees(*impl, carried, nullptr);
+        };
+}
+
+/* Sends a mesh through send(mesh, mesh_size, arrays), with the field transfer
+ * options applied and the coordsets and topologies the server holds
+ * replaced by references. A request failing on a reference is not sent
+ * again: the next ones send the subtrees in full. */
+template<typename Send>
+static void send_mesh(const std::shared_ptr<NodeHandleImpl>& impl,
+                      const conduit::Node& bp_mesh,
+                      size_t mesh_size,
+                      AsyncRequest* req,
+                      std::shared_ptr<AsyncRequestImpl>& async_request_impl,
+                      Send send) {
+    const conduit::Node* mesh = &bp_mesh;
+    conduit::Node transferred;
+    /* Encoded values are temporary arrays, which must not be cached */
+    ArraySet application_arrays;
+    const ArraySet* arrays = nullptr;
+    if(impl->m_field_transfer.encode(bp_mesh, transferred)) {
+        mesh = &transferred;
+        collect_arrays(bp_mesh, application_arrays);
+        arrays = &application_arrays;
+    }
+
+    conduit::Node view;
+    SubtreeRefs::Carried carried;
+    if(not impl->m_subtree_refs.encode(*mesh, view, carried)) {
+        send(*mesh, mesh_size, arrays);
+        return;
+    }
+    try {
+        send(view, mesh_size, arrays);
+    } catch(const Exception& ex) {
+        complete_subtrees(*impl, carried, &ex);
+        throw;
+    }
+    if(req == nullptr)
+        complete_subtrees(*impl, carried, nullptr);
+    else
+        track_subtrees(impl, carried, async_request_impl);
+}
+
+/* Sends ams_open_publish_execute without pruning the mesh nor
+ * replacing its subtrees by references */
+static void send_open_publish_execute(const std::shared_ptr<NodeHandleImpl>& self,
+                                      const conduit::Node& open_opts,
+                                      const conduit::Node& bp_mesh,
+                                      size_t mesh_size,
+                                      const conduit::Node& actions,
+                                      unsigned int ts,
+                                      AsyncRequest* req,
+                                      std::shared_ptr<AsyncRequestImpl>& async_request_impl,
+                                      const ArraySet* arrays = nullptr) {
+    auto& impl = *self;
+    auto& rpc = impl.m_client->m_ams_open_publish_execute;
+    auto& ph  = impl.m_ph;
+    auto& node_id = impl.m_node_id;
+    auto outgoing = make_payload(impl, bp_mesh, arrays, req && impl.m_late_binding);
+    double start = wall_time();
+    send_rpc(rpc, ph, impl.m_load_hint, req, async_request_impl, node_id,
+           open_opts.to_string("conduit_base64_json"),
+           outgoing->m_payload,
+           mesh_size,
+           actions.to_string("conduit_base64_json"),
+           ts);
+    time_transfer(self, outgoing, start, async_request_impl);
+    keep_until_response(outgoing, async_request_impl);
+}
+
+void NodeHandle::ams_open_publish_execute(const conduit::Node& open_opts,
+                                          const conduit::Node& bp_mesh,
+                                          size_t mesh_size,
+                                          const conduit::Node& actions,
+                                          unsigned int ts,
+                                          AsyncRequest* req) const {
+    if(not self) throw Exception("Invalid ams::NodeHandle object");
+    std::shared_ptr<AsyncRequestImpl> async_request_impl;
+    const conduit::Node* mesh = &bp_mesh;
+    conduit::Node view;
+    if(self->m_prune_fields && select_fields(bp_mesh, analyze_actions(actions), view)) {
+        mesh = &view;
+        mesh_size = view.total_bytes_compact();
+    }
+    auto send = [&](const conduit::Node& m, size_t size, const ArraySet* arrays) {
+        send_open_publish_execute(self, open_opts, m, size, actions, ts, req, async_request_impl, arrays);
+    };
+    send_mesh(self, *mesh, mesh_size, req, async_request_impl, send);
+    if(req) *req = AsyncRequest(std::move(async_request_impl));
+}
+
+void NodeHandle::ams_create_mesh(const conduit::Node& bp_mesh,
+                                 uint64_t* mesh_id,
+                                 AsyncRequest* req) const {
+    if(not self) throw Exception("Invalid ams::NodeHandle object");
+    auto& rpc = self->m_client->m_ams_create_mesh;
+    auto& ph  = self->m_ph;
+    auto& node_id = self->m_node_id;
+    std::shared_ptr<AsyncRequestImpl> async_request_impl;
+    auto outgoing = make_payload(*self, bp_mesh);
+    send_rpc_value<uint64_t>(rpc, ph, self->m_load_hint, req, async_request_impl, store_to(mesh_id), node_id,
+           outgoing->m_payload,
+           static_cast<size_t>(bp_mesh.total_bytes_compact()));
+    keep_until_response(outgoing, async_request_impl);
+    if(req) *req = AsyncRequest(std::move(async_request_impl));
+}
+
+void NodeHandle::ams_execute_on_mesh(uint64_t mesh_id,
+                                     const conduit::Node& open_opts,
+                                     const conduit::Node& actions,
+                                     unsigned int ts,
+                                     AsyncRequest* req) const {
+    if(not self) throw Exception("Invalid ams::NodeHandle object");
+    auto& rpc = self->m_client->m_ams_execute_on_mesh;
+    auto& ph  = self->m_ph;
+    auto& node_id = self->m_node_id;
+    std::shared_ptr<AsyncRequestImpl> async_request_impl;
+    send_rpc(rpc, ph, self->m_load_hint, req, async_request_impl, node_id, mesh_id,
+           open_opts.to_string("conduit_base64_json"),
+           actions.to_string("conduit_base64_json"),
+           ts);
+    if(req) *req = AsyncRequest(std::move(async_request_impl));
+}
+
+void NodeHandle::ams_release_mesh(uint64_t mesh_id, AsyncRequest* req) const {
+    if(not self) throw Exception("Invalid ams::NodeHandle object");
+    auto& rpc = self->m_client->m_ams_release_mesh;
+    auto& ph  = self->m_ph;
+    auto& node_id = self->m_node_id;
+    std::shared_ptr<AsyncRequestImpl> async_request_impl;
+    send_rpc(rpc, ph, self->m_load_hint, req, async_request_impl, node_id, mesh_id);
+    if(req) *req = AsyncRequest(std::move(async_request_impl));
+}
+
+void NodeHandle::ams_open_session(const conduit::Node& open_opts,
+                                  uint64_t* session_id,
+                                  AsyncRequest* req) const {
     if(not self) throw Exception("Invalid ams::NodeHandle object");
-    auto& rpc = self->m_client->m_ams_open_publish_execute;
+    auto& rpc = self->m_client->m_ams_open_session;
     auto& ph  = self->m_ph;
     auto& node_id = self->m_node_id;
-    auto response = rpc.on(ph).async(node_id, open_opts.to_string("conduit_base64_json"), bp_mesh.to_string("conduit_base64_json"), mesh_size, actions.to_string("conduit_base64_json"), ts);
-    return response;
+    std::shared_ptr<AsyncRequestImpl> async_request_impl;
+    send_rpc_value<uint64_t>(rpc, ph, self->m_load_hint, req, async_request_impl, store_to(session_id), node_id,
+           open_opts.to_string("conduit_base64_json"));
+    if(req) *req = AsyncRequest(std::move(async_request_impl));
 }
 
-void NodeHandle::ams_close() const {
+void NodeHandle::ams_register_pipeline(uint64_t session_id,
+                                       const std::string& name,
+                                       const conduit::Node& actions,
+                                       uint64_t* pipeline_id,
+                                       AsyncRequest* req) const {
+    if(not self) throw Exception("Invalid ams::NodeHandle object");
+    auto& rpc = self->m_client->m_ams_register_pipeline;
+    auto& ph  = self->m_ph;
+    auto& node_id = self->m_node_id;
+    std::shared_ptr<AsyncRequestImpl> async_request_impl;
+    /* Remember which fields the pipeline uses to prune the meshes
+     * sent with ams_session_publish */
+    std::weak_ptr<NodeHandleImpl> weak_impl = self;
+    FieldSelection selection = analyze_actions(actions);
+    auto on_value = [weak_impl, session_id, selection, pipeline_id](const uint64_t& id) {
+        if(pipeline_id) *pipeline_id = id;
+        if(auto impl = weak_impl.lock())
+            impl->m_pipeline_selections[std::make_pair(session_id, id)] = selection;
+    };
+    send_rpc_value<uint64_t>(rpc, ph, self->m_load_hint, req, async_request_impl, on_value, node_id,
+           session_id, name, actions.to_string("conduit_base64_json"));
+    if(req) *req = AsyncRequest(std::move(async_request_impl));
+}
+
+void NodeHandle::ams_session_publish(uint64_t session_id,
+                                     uint64_t pipeline_id,
+                                     const conduit::Node& bp_mesh,
+                                     unsigned int ts,
+                                     AsyncRequest* req) const {
+    if(not self) throw Exception("Invalid ams::NodeHandle object");
+    auto& rpc = self->m_client->m_ams_session_publish;
+    auto& ph  = self->m_ph;
+    auto& node_id = self->m_node_id;
+    std::shared_ptr<AsyncRequestImpl> async_request_impl;
+    const conduit::Node* mesh = &bp_mesh;
+    conduit::Node view;
+    auto selection = self->m_pipeline_selections.find(std::make_pair(session_id, pipeline_id));
+    if(self->m_prune_fields && selection != self->m_pipeline_selections.end()
+    && select_fields(bp_mesh, selection->second, view))
+        mesh = &view;
+    auto send = [&](const conduit::Node& m, size_t size, const ArraySet* arrays) {
+        auto outgoing = make_payload(*self, m, arrays, req && self->m_late_binding);
+        double start = wall_time();
+        send_rpc(rpc, ph, self->m_load_hint, req, async_request_impl, node_id, session_id, pipeline_id,
+               outgoing->m_payload, size, ts);
+        time_transfer(self, outgoing, start, async_request_impl);
+        keep_until_response(outgoing, async_request_impl);
+    };
+    send_mesh(self, *mesh, static_cast<size_t>(mesh->total_bytes_compact()),
+              req, async_request_impl, send);
+    if(req) *req = AsyncRequest(std::move(async_request_impl));
+}
+
+void NodeHandle::ams_close_session(uint64_t session_id, AsyncRequest* req) const {
+    if(not self) throw Exception("Invalid ams::NodeHandle object");
+    auto& rpc = self->m_client->m_ams_close_session;
+    auto& ph  = self->m_ph;
+    auto& node_id = self->m_node_id;
+    std::shared_ptr<AsyncRequestImpl> async_request_impl;
+    send_rpc(rpc, ph, self->m_load_hint, req, async_request_impl, node_id, session_id);
+    if(req) *req = AsyncRequest(std::move(async_request_impl));
+    auto& selections = self->m_pipeline_selections;
+    selections.erase(selections.lower_bound(std::make_pair(session_id, (uint64_t)0)),
+                     selections.upper_bound(std::make_pair(session_id, UINT64_MAX)));
+}
+
+void NodeHandle::setFieldPruning(bool enable) const {
+    if(not self) throw Exception("Invalid ams::NodeHandle object");
+    self->m_prune_fields = enable;
+}
+
+void NodeHandle::setFieldTransfer(const std::string& field,
+                                  const FieldTransferOptions& options) const {
+    if(not self) throw Exception("Invalid ams::NodeHandle object");
+    if(options.to_float32 || options.compress)
+        self->m_field_transfer.m_options[field] = options;
+    else
+        self->m_field_transfer.m_options.erase(field);
+}
+
+double NodeHandle::linkBandwidth() const {
+    if(not self) throw Exception("Invalid ams::NodeHandle object");
+    return self->m_field_transfer.m_bandwidth;
+}
+
+void NodeHandle::setBulkThreshold(size_t bytes) const {
+    if(not self) throw Exception("Invalid ams::NodeHandle object");
+    self->m_bulk_threshold = bytes;
+}
+
+void NodeHandle::setLateBinding(bool enable) const {
+    if(not self) throw Exception("Invalid ams::NodeHandle object");
+    self->m_late_binding = enable;
+}
+
+void NodeHandle::setSubtreeCaching(bool enable, size_t min_bytes) const {
+    if(not self) throw Exception("Invalid ams::NodeHandle object");
+    self->m_subtree_refs.m_enabled   = enable;
+    self->m_subtree_refs.m_min_bytes = min_bytes;
+    if(not enable) self->m_subtree_refs.forget();
+}
+
+void NodeHandle::ams_close(AsyncRequest* req) const {
     if(not self) throw Exception("Invalid ams::NodeHandle object");
     auto& rpc = self->m_client->m_ams_close;
     auto& ph  = self->m_ph;
     auto& node_id = self->m_node_id;
-    RequestResult<bool> result = rpc.on(ph)(node_id);
-    if(not result.success()) {
-        throw Exception(result.error());
-    }
+    std::shared_ptr<AsyncRequestImpl> async_request_impl;
+    send_rpc(rpc, ph, self->m_load_hint, req, async_request_impl, node_id);
+    if(req) *req = AsyncRequest(std::move(async_request_impl));
 }
 /* SR: Core Ascent APIs */
 
+/* Whether dst has the same tree structure, types and sizes as src,
+ * in which case src's data can be copied into it without reallocation */
+static bool same_layout(const conduit::Node& src, const conduit::Node& dst) {
+    const conduit::DataType& src_dt = src.dtype();
+    const conduit::DataType& dst_dt = dst.dtype();
+    if(src_dt.id() != dst_dt.id()) return false;
+    if(src_dt.is_object() || src_dt.is_list()) {
+        conduit::index_t n = src.number_of_children();
+        if(n != dst.number_of_children()) return false;
+        for(conduit::index_t i = 0; i < n; i++) {
+            if(src_dt.is_object() && src.child(i).name() != dst.child(i).name())
+                return false;
+            if(not same_layout(src.child(i), dst.child(i)))
+                return false;
+        }
+        return true;
+    }
+    return src_dt.number_of_elements() == dst_dt.number_of_elements();
+}
+
+/* Copies the leaves of src into dst, which must have the same layout */
+static void copy_leaves(const conduit::Node& src, conduit::Node& dst) {
+    const conduit::DataType& dt = src.dtype();
+    if(dt.is_object() || dt.is_list()) {
+        for(conduit::index_t i = 0; i < src.number_of_children(); i++)
+            copy_leaves(src.child(i), dst.child(i));
+    } else if(not dt.is_empty()) {
+        src.compact_elements_to(static_cast<conduit::uint8*>(dst.element_ptr(0)));
+    }
+}
+
+/* Folds the latency of a completed ams_submit request into the
+ * smoothed latency of the window */
+static void record_completion(NodeHandleImpl& impl, size_t index) {
+    double latency = wall_time() - impl.m_slots[index].m_submit_time;
+    if(impl.m_submit_latency == 0.0)
+        impl.m_submit_latency = latency;
+    else
+        impl.m_submit_latency = 0.75*impl.m_submit_latency + 0.25*latency;
+}
+
+/* Releases the slots of the ams_submit requests that have completed,
+ * returning the first error if some of them failed */
+static std::exception_ptr reap_completed(NodeHandleImpl& impl) {
+    std::exception_ptr error;
+    for(auto it = impl.m_in_flight.begin(); it != impl.m_in_flight.end();) {
+        bool done;
+        try {
+            done = impl.m_slots[*it].m_request.test();
+        } catch(...) {
+            done = true;
+            if(not error) error = std::current_exception();
+        }
+        if(done) {
+            record_completion(impl, *it);
+            impl.m_free_slots.push_back(*it);
+            it = impl.m_in_flight.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return error;
+}
+
+void NodeHandle::setInFlightWindow(size_t max_in_flight,
+                                   WindowPolicy policy,
+                                   FallbackFunction fallback,
+                                   MPI_Comm comm) const {
+    if(not self) throw Exception("Invalid ams::NodeHandle object");
+    if(max_in_flight == 0)
+        throw Exception("The in-flight window must hold at least one request");
+    if(policy == WindowPolicy::FALLBACK && not fallback)
+        throw Exception("The FALLBACK window policy requires a fallback function");
+    if(not self->m_in_flight.empty())
+        throw Exception("Cannot resize the in-flight window while requests are in flight");
+    self->m_max_in_flight = max_in_flight;
+    self->m_window_policy = policy;
+    self->m_fallback      = std::move(fallback);
+    self->m_window_comm   = comm;
+    MPI_Comm_size(comm, &self->m_window_comm_size);
+    if(self->m_slots.size() > max_in_flight) {
+        for(size_t i = max_in_flight; i < self->m_slots.size(); i++)
+            invalidate_registrations(*self->m_client, self->m_slots[i].m_mesh);
+        self->m_slots.resize(max_in_flight);
+        self->m_free_slots.clear();
+        for(size_t i = 0; i < max_in_flight; i++)
+            self->m_free_slots.push_back(i);
+    }
+}
+
+SubmitStatus NodeHandle::ams_submit(const conduit::Node& open_opts,
+                                    const conduit::Node& bp_mesh,
+                                    const conduit::Node& actions,
+                                    unsigned int ts) const {
+    if(not self) throw Exception("Invalid ams::NodeHandle object");
+    auto& impl = *self;
+
+    std::exception_ptr error = reap_completed(impl);
+
+    bool full = impl.m_in_flight.size() >= impl.m_max_in_flight;
+    /* All ranks drop or fall back together if any window is full, and
+     * report an error together if a request failed on any of them, so
+     * that none is left in the collective */
+    if(impl.m_window_policy != WindowPolicy::BLOCK && impl.m_window_comm_size > 1) {
+        int local[2] = { full ? 1 : 0, error ? 1 : 0 }, any[2] = { 0, 0 };
+        MPI_Allreduce(local, any, 2, MPI_INT, MPI_MAX, impl.m_window_comm);
+        full = any[0] != 0;
+        if(any[1] && not error)
+            throw Exception("A request submitted by another rank failed");
+    }
+    if(error) std::rethrow_exception(error);
+    if(full) {
+        switch(impl.m_window_policy) {
+            case WindowPolicy::BLOCK:
+                {
+                    size_t oldest = impl.m_in_flight.front();
+                    impl.m_in_flight.pop_front();
+                    impl.m_free_slots.push_back(oldest);
+                    impl.m_slots[oldest].m_request.wait();
+                    record_completion(impl, oldest);
+                }
+                break;
+            case WindowPolicy::DROP:
+                return SubmitStatus::DROPPED;
+            case WindowPolicy::FALLBACK:
+                impl.m_fallback(open_opts, bp_mesh, actions);
+                return SubmitStatus::FALLBACK;
+        }
+    }
+
+    size_t index;
+    if(impl.m_free_slots.empty()) {
+        impl.m_slots.emplace_back();
+        index = impl.m_slots.size() - 1;
+    } else {
+        index = impl.m_free_slots.back();
+        impl.m_free_slots.pop_back();
+    }
+
+    /* Only the fields the actions use are copied and sent, with
+     * their transfer options, and only the coordsets and topologies
+     * the server does not hold */
+    const conduit::Node* mesh = &bp_mesh;
+    conduit::Node view;
+    if(impl.m_prune_fields && select_fields(bp_mesh, analyze_actions(actions), view))
+        mesh = &view;
+    size_t mesh_size = mesh->total_bytes_compact();
+    conduit::Node transferred;
+    if(impl.m_field_transfer.encode(*mesh, transferred))
+        mesh = &transferred;
+    conduit::Node encoded;
+    SubtreeRefs::Carried carried;
+    bool has_refs = impl.m_subtree_refs.encode(*mesh, encoded, carried);
+    if(has_refs)
+        mesh = &encoded;
+
+    /* A mesh below the bulk threshold is serialized by the send; a
+     * larger one is exposed for the server to pull after we return,
+     * so its arrays are first copied into the slot */
+    auto& slot = impl.m_slots[index];
+    if((size_t)mesh->total_bytes_compact() >= impl.m_bulk_threshold) {
+        if(same_layout(*mesh, slot.m_mesh)) {
+            copy_leaves(*mesh, slot.m_mesh);
+        } else {
+            invalidate_registrations(*impl.m_client, slot.m_mesh);
+            slot.m_mesh.reset();
+            mesh->compact_to(slot.m_mesh);
+        }
+        mesh = &slot.m_mesh;
+    }
+
+    slot.m_submit_time = wall_time();
+    try {
+        std::shared_ptr<AsyncRequestImpl> async_request_impl;
+        try {
+            send_open_publish_execute(self, open_opts, *mesh, mesh_size,
+                                      actions, ts, &slot.m_request, async_request_impl);
+        } catch(const Exception& ex) {
+            if(has_refs) complete_subtrees(impl, carried, &ex);
+            throw;
+        }
+        if(has_refs)
+            track_subtrees(self, carried, async_request_impl);
+        slot.m_request = AsyncRequest(std::move(async_request_impl));
+    } catch(...) {
+        impl.m_free_slots.push_back(index);
+        throw;
+    }
+    impl.m_in_flight.push_back(index);
+    return SubmitStatus::SENT;
+}
+
+void NodeHandle::ams_flush() const {
+    if(not self) throw Exception("Invalid ams::NodeHandle object");
+    std::exception_ptr error;
+    while(not self->m_in_flight.empty()) {
+        size_t index = self->m_in_flight.front();
+        self->m_in_flight.pop_front();
+        self->m_free_slots.push_back(index);
+        try {
+            self->m_slots[index].m_request.wait();
+            record_completion(*self, index);
+        } catch(...) {
+            if(not error) error = std::current_exception();
+        }
+    }
+    if(error) std::rethrow_exception(error);
+}
+
+void NodeHandle::ams_get_load(ServerLoad* load, AsyncRequest* req) const {
+    if(not self) throw Exception("Invalid ams::NodeHandle object");
+    auto& rpc = self->m_client->m_get_load;
+    auto& ph  = self->m_ph;
+    auto& node_id = self->m_node_id;
+    std::shared_ptr<AsyncRequestImpl> async_request_impl;
+    send_rpc_value<ServerLoad>(rpc, ph, self->m_load_hint, req, async_request_impl, store_to(load), node_id);
+    if(req) *req = AsyncRequest(std::move(async_request_impl));
+}
+
+bool NodeHandle::loadHint(LoadHint& hint, double* age) const {
+    if(not self) throw Exception("Invalid ams::NodeHandle object");
+    return self->m_load_hint->get(hint, age);
+}
+
+size_t NodeHandle::inFlight() const {
+    if(not self) throw Exception("Invalid ams::NodeHandle object");
+    std::exception_ptr error = reap_completed(*self);
+    if(error) std::rethrow_exception(error);
+    return self->m_in_flight.size();
+}
+
+size_t NodeHandle::inFlightWindow() const {
+    if(not self) throw Exception("Invalid ams::NodeHandle object");
+    return self->m_max_in_flight;
+}
+
+double NodeHandle::submitLatency() const {
+    if(not self) throw Exception("Invalid ams::NodeHandle object");
+    return self->m_submit_latency;
+}
+
 void NodeHandle::computeSum(
         int32_t x, int32_t y,
         int32_t* result,
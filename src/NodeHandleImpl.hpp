@@ -7,9 +7,31 @@
 #define __AMS_NODE_HANDLE_IMPL_H
 
 #include <ams/UUID.hpp>
+#include <ams/NodeHandle.hpp>
+#include <ams/AsyncRequest.hpp>
+#include <ams/ActionAnalysis.hpp>
+#include "SubtreeRefs.hpp"
+#include "FieldTransfer.hpp"
+#include "LoadHintCache.hpp"
+#include <conduit.hpp>
+#include <mpi.h>
+#include <deque>
+#include <map>
+#include <utility>
+#include <vector>
 
 namespace ams {
 
+/**
+ * @brief Request sent by ams_submit, with the copy of its mesh the
+ * server pulls (empty if the mesh was serialized).
+ */
+struct InFlightSlot {
+    conduit::Node m_mesh;
+    AsyncRequest  m_request;
+    double        m_submit_time = 0.0;
+};
+
 class NodeHandleImpl {
 
     public:
@@ -17,15 +39,51 @@ class NodeHandleImpl {
     UUID                        m_node_id;
     std::shared_ptr<ClientImpl> m_client;
     tl::provider_handle         m_ph;
+    // Latest load hint of the server, shared with the client's other handles
+    std::shared_ptr<ServerLoadHint> m_load_hint = std::make_shared<ServerLoadHint>();
+
+    // ams_submit window
+    size_t                      m_max_in_flight = 2;
+    WindowPolicy                m_window_policy = WindowPolicy::BLOCK;
+    FallbackFunction            m_fallback;
+    MPI_Comm                    m_window_comm = MPI_COMM_SELF; // DROP/FALLBACK decided over it
+    int                         m_window_comm_size = 1;
+    std::vector<InFlightSlot>   m_slots;
+    std::deque<size_t>          m_in_flight;  // slot indices, oldest first
+    std::vector<size_t>         m_free_slots;
+    double                      m_submit_latency = 0.0; // smoothed, 0 until a request completes
+
+    // Fields used by the pipelines registered with ams_register_pipeline
+    bool                        m_prune_fields = true;
+    std::map<std::pair<uint64_t, uint64_t>, FieldSelection> m_pipeline_selections;
+
+    // Coordsets and topologies cached by the server
+    SubtreeRefs                 m_subtree_refs;
+
+    // Per-field conversion and compression
+    FieldTransfer               m_field_transfer;
+
+    // Meshes of at least this size are pulled by the server
+    size_t                      m_bulk_threshold = 1024 * 1024;
+    // Asynchronous bulk transfers are pulled when the server renders
+    bool                        m_late_binding = false;
 
     NodeHandleImpl() = default;
     
     NodeHandleImpl(const std::shared_ptr<ClientImpl>& client, 
                        tl::provider_handle&& ph,
-                       const UUID& node_id)
+                       const UUID& node_id,
+                       const std::shared_ptr<ServerLoadHint>& load_hint)
     : m_node_id(node_id)
     , m_client(client)
-    , m_ph(std::move(ph)) {}
+    , m_ph(std::move(ph))
+    , m_load_hint(load_hint) {
+        m_subtree_refs.m_client_id = UUID::generate().to_string();
+    }
+
+    /* Waits for the submitted requests, releases the registrations of
+     * the slots' arrays and the subtrees cached by the server */
+    ~NodeHandleImpl();
 };
 
 }
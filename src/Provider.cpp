@@ -4,6 +4,8 @@
  * See COPYRIGHT in top-level directory.
  */
 #include "ams/Provider.hpp"
+#include "ams/Exception.hpp"
+#include "ams/RequestResult.hpp"
 
 #include "ProviderImpl.hpp"
 
@@ -14,21 +16,21 @@ namespace tl = thallium;
 namespace ams {
 
 Provider::Provider(const tl::engine& engine, uint16_t provider_id, const std::string& config, const tl::pool& p)
-: self(std::make_shared<ProviderImpl>(engine, provider_id, MPI_COMM_WORLD, p)) {
+: self(std::make_shared<ProviderImpl>(engine, provider_id, MPI_COMM_WORLD, config, p)) {
     self->get_engine().push_finalize_callback(this, [p=this]() { p->self.reset(); });
-    (void)config;
+    self->configure(config);
 }
 
 Provider::Provider(margo_instance_id mid, uint16_t provider_id, const std::string& config, const tl::pool& p)
-: self(std::make_shared<ProviderImpl>(mid, provider_id, MPI_COMM_WORLD, p)) {
+: self(std::make_shared<ProviderImpl>(mid, provider_id, MPI_COMM_WORLD, config, p)) {
     self->get_engine().push_finalize_callback(this, [p=this]() { p->self.reset(); });
-    (void)config;
+    self->configure(config);
 }
 
 Provider::Provider(const tl::engine& engine, uint16_t provider_id, MPI_Comm comm, const std::string& config, const tl::pool& p)
-: self(std::make_shared<ProviderImpl>(engine, provider_id, comm, p)) {
+: self(std::make_shared<ProviderImpl>(engine, provider_id, comm, config, p)) {
     self->get_engine().push_finalize_callback(this, [p=this]() { p->self.reset(); });
-    (void)config;
+    self->configure(config);
 }
 
 Provider::Provider(Provider&& other) {
@@ -43,8 +45,19 @@ Provider::~Provider() {
     }
 }
 
+UUID Provider::createNode(const std::string& type, const std::string& config) {
+    RequestResult<UUID> result = self->create_node(type, config);
+    if(not result.success())
+        throw Exception(result.error());
+    return result.value();
+}
+
+void Provider::publishMembership() {
+    self->publish_membership();
+}
+
 std::string Provider::getConfig() const {
-    return "{}";
+    return self->get_config().dump();
 }
 
 Provider::operator bool() const {
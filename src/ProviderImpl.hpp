@@ -7,7 +7,12 @@
 #define __AMS_PROVIDER_IMPL_H
 
 #include "ams/Backend.hpp"
+#include "ams/Scheduler.hpp"
 #include "ams/UUID.hpp"
+#include "Tracer.hpp"
+#include "BufferPool.hpp"
+#include "MeshPayload.hpp"
+#include "MpiProxy.hpp"
 
 #include <thallium.hpp>
 #include <thallium/serialization/stl/string.hpp>
@@ -17,21 +22,20 @@
 
 #include <ascent/ascent.hpp>
 
+#include <algorithm>
+#include <memory>
 #include <tuple>
 #include <mpi.h>
 
 #define FIND_NODE(__var__) \
-        std::shared_ptr<Backend> __var__;\
+        std::shared_ptr<Backend> __var__ = find_backend(node_id);\
         do {\
-            std::lock_guard<tl::mutex> lock(m_backends_mtx);\
-            auto it = m_backends.find(node_id);\
-            if(it == m_backends.end()) {\
+            if(not __var__) {\
                 result.success() = false;\
                 result.error() = "Node with UUID "s + node_id.to_string() + " not found";\
                 req.respond(result);\
                 return;\
             }\
-            __var__ = it->second;\
         }while(0)
 
 #define MAX_BULK_STRING_SIZE 1000000
@@ -41,6 +45,52 @@ namespace ams {
 using namespace std::string_literals;
 namespace tl = thallium;
 
+/* Response to a request whose mesh is pulled late (see MeshData):
+ * sent by the backend once the mesh has been pulled, or with an error
+ * when the last reference to it goes away */
+class DeferredResponse {
+
+    tl::request m_req;
+    bool        m_responded = false;
+
+    public:
+
+    DeferredResponse(const tl::request& req)
+    : m_req(req) {}
+
+    ~DeferredResponse() {
+        RequestResult<bool> result;
+        result.success() = false;
+        result.error() = "Request dropped before its mesh was pulled";
+        respond(result);
+    }
+
+    void respond(const RequestResult<bool>& result) {
+        if(m_responded) return;
+        m_responded = true;
+        try {
+            m_req.respond(result);
+        } catch(const std::exception&) {
+            /* The client is gone */
+        }
+    }
+};
+
+/* Pools handling each class of RPCs: control (node management and
+ * small queries), ingest (requests carrying or queuing meshes) and
+ * execution (direct Ascent calls, and the renders that ingest handlers
+ * trigger). The pools are named in the provider configuration, e.g.
+ * { "pools": { "control": "__control__", "ingest": "__ingest__", "execution": "__execution__" } }
+ * and looked up in the margo instance (or Bedrock) configuration, which
+ * sets their execution streams and priorities, e.g. a "prio_wait"
+ * scheduler polls its pools in the order they are listed. Missing
+ * classes use the provider's pool. */
+struct RpcPools {
+    tl::pool m_control;
+    tl::pool m_ingest;
+    tl::pool m_execution;
+};
+
 class ProviderImpl : public tl::provider<ProviderImpl> {
 
     auto id() const { return get_provider_id(); } // for convenience
@@ -52,6 +102,7 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
     std::string          m_token;
     tl::pool             m_pool;
     MPI_Comm             m_comm;
+    RpcPools             m_pools;
     // Admin RPC
     tl::remote_procedure m_create_node;
     tl::remote_procedure m_open_node;
@@ -69,29 +120,70 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
     tl::remote_procedure m_ams_publish_and_execute;
     tl::remote_procedure m_ams_open_publish_execute;
     tl::remote_procedure m_ams_execute_pending_requests;
-    // Backends
-    std::unordered_map<UUID, std::shared_ptr<Backend>> m_backends;
+    tl::remote_procedure m_ams_create_mesh;
+    tl::remote_procedure m_ams_execute_on_mesh;
+    tl::remote_procedure m_ams_release_mesh;
+    tl::remote_procedure m_ams_release_subtrees;
+    tl::remote_procedure m_ams_open_session;
+    tl::remote_procedure m_ams_register_pipeline;
+    tl::remote_procedure m_ams_session_publish;
+    tl::remote_procedure m_ams_close_session;
+    tl::remote_procedure m_update_config;
+    tl::remote_procedure m_get_directory;
+    tl::remote_procedure m_get_member;
+    tl::remote_procedure m_get_load;
+    // Backends: lookups read an immutable snapshot of the table, updates
+    // (serialized by m_backends_mtx) publish a modified copy. Requests in
+    // flight keep the backend they found alive.
+    using BackendTable = std::unordered_map<UUID, std::shared_ptr<Backend>>;
+    std::shared_ptr<const BackendTable> m_backends = std::make_shared<BackendTable>();
     tl::mutex m_backends_mtx;
+    // Buffers that meshes sent by bulk transfer land in
+    std::shared_ptr<BufferPool> m_buffer_pool;
+    // Execution stream on which the backends use MPI
+    std::shared_ptr<MpiProxy> m_mpi_proxy;
+    // Communicators of the nodes (see Backend::comm), freed with the
+    // provider since requests in flight may outlive their node
+    std::vector<MPI_Comm> m_node_comms;
+    // Address of every rank of the instance, see publish_membership
+    std::shared_ptr<const std::vector<std::string>> m_members;
+    // Configuration, see configure; updates are serialized by m_config_mtx
+    json      m_config = json::object();
+    tl::mutex m_config_mtx;
 
-    ProviderImpl(const tl::engine& engine, uint16_t provider_id, MPI_Comm comm, const tl::pool& pool)
+    ProviderImpl(const tl::engine& engine, uint16_t provider_id, MPI_Comm comm,
+                 const std::string& config, const tl::pool& pool)
     : tl::provider<ProviderImpl>(engine, provider_id)
     , m_pool(pool), m_comm(comm)
-    , m_create_node(define("ams_create_node", &ProviderImpl::createNode, pool))
-    , m_open_node(define("ams_open_node", &ProviderImpl::openNode, pool))
-    , m_close_node(define("ams_close_node", &ProviderImpl::closeNode, pool))
-    , m_destroy_node(define("ams_destroy_node", &ProviderImpl::destroyNode, pool))
-    , m_check_node(define("ams_check_node", &ProviderImpl::checkNode, pool))
-    , m_say_hello(define("ams_say_hello", &ProviderImpl::sayHello, pool))
-    , m_compute_sum(define("ams_compute_sum",  &ProviderImpl::computeSum, pool))
-    , m_ams_open(define("ams_open",  &ProviderImpl::ams_open, pool))
-    , m_ams_close(define("ams_close",  &ProviderImpl::ams_close, pool))
-    , m_ams_publish(define("ams_publish",  &ProviderImpl::ams_publish, pool))
-    , m_ams_execute(define("ams_execute",  &ProviderImpl::ams_execute, pool))
-    , m_ams_publish_and_execute(define("ams_publish_and_execute",  &ProviderImpl::ams_publish_and_execute, pool))
-    , m_ams_open_publish_execute(define("ams_open_publish_execute",  &ProviderImpl::ams_open_publish_execute, pool))
-    , m_ams_execute_pending_requests(define("ams_execute_pending_requests",  &ProviderImpl::ams_execute_pending_requests, pool))
-    {
-    }
+    , m_pools(select_pools(engine, config, pool))
+    , m_create_node(define("ams_create_node", &ProviderImpl::createNode, m_pools.m_control))
+    , m_open_node(define("ams_open_node", &ProviderImpl::openNode, m_pools.m_control))
+    , m_close_node(define("ams_close_node", &ProviderImpl::closeNode, m_pools.m_control))
+    , m_destroy_node(define("ams_destroy_node", &ProviderImpl::destroyNode, m_pools.m_control))
+    , m_check_node(define("ams_check_node", &ProviderImpl::checkNode, m_pools.m_control))
+    , m_say_hello(define("ams_say_hello", &ProviderImpl::sayHello, m_pools.m_control))
+    , m_compute_sum(define("ams_compute_sum",  &ProviderImpl::computeSum, m_pools.m_control))
+    , m_ams_open(define("ams_open",  &ProviderImpl::ams_open, m_pools.m_execution))
+    , m_ams_close(define("ams_close",  &ProviderImpl::ams_close, m_pools.m_execution))
+    , m_ams_publish(define("ams_publish",  &ProviderImpl::ams_publish, m_pools.m_execution))
+    , m_ams_execute(define("ams_execute",  &ProviderImpl::ams_execute, m_pools.m_execution))
+    , m_ams_publish_and_execute(define("ams_publish_and_execute",  &ProviderImpl::ams_publish_and_execute, m_pools.m_execution))
+    , m_ams_open_publish_execute(define("ams_open_publish_execute",  &ProviderImpl::ams_open_publish_execute, m_pools.m_ingest))
+    , m_ams_execute_pending_requests(define("ams_execute_pending_requests",  &ProviderImpl::ams_execute_pending_requests, m_pools.m_execution))
+    , m_ams_create_mesh(define("ams_create_mesh",  &ProviderImpl::ams_create_mesh, m_pools.m_ingest))
+    , m_ams_execute_on_mesh(define("ams_execute_on_mesh",  &ProviderImpl::ams_execute_on_mesh, m_pools.m_ingest))
+    , m_ams_release_mesh(define("ams_release_mesh",  &ProviderImpl::ams_release_mesh, m_pools.m_control))
+    , m_ams_release_subtrees(define("ams_release_subtrees",  &ProviderImpl::ams_release_subtrees, m_pools.m_control))
+    , m_ams_open_session(define("ams_open_session",  &ProviderImpl::ams_open_session, m_pools.m_control))
+    , m_ams_register_pipeline(define("ams_register_pipeline",  &ProviderImpl::ams_register_pipeline, m_pools.m_control))
+    , m_ams_session_publish(define("ams_session_publish",  &ProviderImpl::ams_session_publish, m_pools.m_ingest))
+    , m_ams_close_session(define("ams_close_session",  &ProviderImpl::ams_close_session, m_pools.m_control))
+    , m_update_config(define("ams_update_config", &ProviderImpl::updateConfig, m_pools.m_control))
+    , m_get_directory(define("ams_get_directory", &ProviderImpl::getDirectory, m_pools.m_control))
+    , m_get_member(define("ams_get_member", &ProviderImpl::getMember, m_pools.m_control))
+    , m_get_load(define("ams_get_load", &ProviderImpl::getLoad, m_pools.m_control))
+    , m_buffer_pool(std::make_shared<BufferPool>(get_engine()))
+    {}
 
     ~ProviderImpl() {
         m_create_node.deregister();
@@ -108,6 +200,256 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
         m_ams_open_publish_execute.deregister();
         m_ams_execute_pending_requests.deregister();
         m_ams_publish.deregister();
+        m_ams_create_mesh.deregister();
+        m_ams_execute_on_mesh.deregister();
+        m_ams_release_mesh.deregister();
+        m_ams_release_subtrees.deregister();
+        m_ams_open_session.deregister();
+        m_ams_register_pipeline.deregister();
+        m_ams_session_publish.deregister();
+        m_ams_close_session.deregister();
+        m_update_config.deregister();
+        m_get_directory.deregister();
+        m_get_member.deregister();
+        m_get_load.deregister();
+        if(m_mpi_proxy) {
+            m_mpi_proxy->run([&]() {
+                for(auto& comm : m_node_comms)
+                    MPI_Comm_free(&comm);
+            });
+        }
+        Tracer::instance().flush();
+    }
+
+    /* Parses the JSON configuration given to the Provider, e.g.
+     * { "scheduler": { "mode": "lazyish", "policy": "timestep", "lazyish_threshold": 5 },
+     *   "receive_buffers": { "max_cached_bytes": 1073741824, "hugepages": false },
+     *   "mpi_proxy": "primary",
+     *   "pools": { "ingest": "__ingest__" },
+     *   "trace": { "prefix": "ams-trace" } }
+     * where "mpi_proxy" is "primary" (default), "xstream" or "none" (see MpiProxy.hpp),
+     * "pools" is read by select_pools and "trace" enables the Tracer.
+     * The scheduler settings are passed to every node and override the
+     * ones of their own configuration. AMS_SERVER_MODE and
+     * AMS_TRACE_PREFIX are used when the configuration does not give a
+     * server mode or a trace prefix. Called once, on every rank. */
+    void configure(const std::string& config) {
+        json json_config = config.empty() ? json::object() : json::parse(config);
+        if(not json_config.is_object())
+            throw std::invalid_argument("Provider configuration should be an object");
+        /* Funneling MPI through the primary execution stream only
+         * requires MPI_THREAD_FUNNELED */
+        std::string proxy = json_config.value("mpi_proxy", "primary"s);
+        if(proxy == "none")
+            m_mpi_proxy.reset(new MpiProxy(MpiProxy::Mode::NONE));
+        else if(proxy == "xstream")
+            m_mpi_proxy = MpiProxy::shared_xstream();
+        else if(proxy == "primary")
+            m_mpi_proxy.reset(new MpiProxy(MpiProxy::Mode::PRIMARY));
+        else
+            throw std::invalid_argument("Unknown mpi_proxy " + proxy);
+        json_config["mpi_proxy"] = proxy;
+        if(not json_config.contains("pools"))
+            json_config["pools"] = json::object();
+
+        json& scheduler = json_config["scheduler"];
+        if(scheduler.is_null())
+            scheduler = json::object();
+        const char* server_mode = getenv("AMS_SERVER_MODE");
+        if(server_mode && not scheduler.contains("mode"))
+            scheduler["mode"] = server_mode;
+        const char* trace_prefix = getenv("AMS_TRACE_PREFIX");
+        if(trace_prefix && not json_config.contains("trace"))
+            json_config["trace"]["prefix"] = trace_prefix;
+        if(json_config.contains("trace")) {
+            /* Chrome trace output, see Tracer.hpp */
+            std::string prefix = json_config["trace"].value("prefix", ""s);
+            if(not prefix.empty())
+                Tracer::instance().enable(prefix, m_comm);
+        } else {
+            json_config["trace"] = json::object();
+        }
+        apply_tunables(json_config);
+        m_config = std::move(json_config);
+    }
+
+    /* Validates and applies the settings that can change at runtime
+     * (scheduler and receive buffers), completing them with their
+     * current values so that getConfig reports everything. Nothing is
+     * applied unless every setting is valid. */
+    void apply_tunables(json& config) {
+        json& scheduler = config["scheduler"];
+        if(not scheduler.is_object())
+            throw std::invalid_argument("\"scheduler\" should be an object");
+        SchedulerConfig defaults;
+        scheduler["mode"] = to_string(parse_server_mode(
+            scheduler.value("mode", to_string(defaults.mode))));
+        scheduler["policy"] = to_string(parse_queue_policy(
+            scheduler.value("policy", to_string(defaults.policy))));
+        scheduler["lazyish_threshold"] = unsigned_setting(scheduler, "lazyish_threshold", defaults.lazyish_threshold);
+        if(scheduler.contains("memory_limit"))
+            scheduler["memory_limit"] = unsigned_setting(scheduler, "memory_limit", 0);
+
+        json& buffers = config["receive_buffers"];
+        if(buffers.is_null())
+            buffers = json::object();
+        if(not buffers.is_object())
+            throw std::invalid_argument("\"receive_buffers\" should be an object");
+        size_t max_cached_bytes = unsigned_setting(buffers, "max_cached_bytes", m_buffer_pool->maxCachedBytes());
+        if(buffers.contains("hugepages") && not buffers["hugepages"].is_boolean())
+            throw std::invalid_argument("\"hugepages\" should be a boolean");
+        bool hugepages = buffers.value("hugepages", m_buffer_pool->hugepages());
+        buffers["max_cached_bytes"] = max_cached_bytes;
+        buffers["hugepages"] = hugepages;
+
+        m_buffer_pool->configure(max_cached_bytes, hugepages);
+        auto backends = std::atomic_load(&m_backends);
+        for(auto& backend : *backends)
+            backend.second->configureScheduler(scheduler);
+    }
+
+    /* Value of an optional non-negative integer setting */
+    static size_t unsigned_setting(const json& settings, const char* key, size_t default_value) {
+        if(not settings.contains(key))
+            return default_value;
+        if(not settings[key].is_number_unsigned())
+            throw std::invalid_argument("\""s + key + "\" should be a non-negative integer");
+        return settings[key].get<size_t>();
+    }
+
+    /* Current configuration, with default values filled in */
+    json get_config() {
+        std::lock_guard<tl::mutex> lock(m_config_mtx);
+        return m_config;
+    }
+
+    std::shared_ptr<Backend> find_backend(const UUID& node_id) const {
+        auto backends = std::atomic_load(&m_backends);
+        auto it = backends->find(node_id);
+        return it == backends->end() ? nullptr : it->second;
+    }
+
+    /* Applies f to a copy of the backend table and publishes
+     * the copy. Must be called with m_backends_mtx held. */
+    template<typename F>
+    void update_backends(F&& f) {
+        auto backends = std::make_shared<BackendTable>(*m_backends);
+        f(*backends);
+        std::atomic_store(&m_backends, std::shared_ptr<const BackendTable>(std::move(backends)));
+    }
+
+    /* Resolves the pools of each RPC class, see RpcPools */
+    static RpcPools select_pools(const tl::engine& engine, const std::string& config,
+                                 const tl::pool& pool) {
+        tl::pool fallback = pool.native_handle() == ABT_POOL_NULL ? engine.get_handler_pool() : pool;
+        RpcPools pools = { fallback, fallback, fallback };
+        if(config.empty()) return pools;
+        json json_config = json::parse(config);
+        if(not json_config.contains("pools")) return pools;
+        const json& names = json_config["pools"];
+        auto lookup = [&engine, &names](const char* rpc_class, tl::pool& p) {
+            if(not names.contains(rpc_class)) return;
+            std::string name = names[rpc_class].get<std::string>();
+            ABT_pool abt_pool = ABT_POOL_NULL;
+            if(margo_get_pool_by_name(engine.get_margo_instance(), name.c_str(), &abt_pool) != 0
+            || abt_pool == ABT_POOL_NULL)
+                throw std::invalid_argument("Unknown pool "s + name + " for " + rpc_class + " RPCs");
+            p = tl::pool(abt_pool);
+        };
+        lookup("control", pools.m_control);
+        lookup("ingest", pools.m_ingest);
+        lookup("execution", pools.m_execution);
+        return pools;
+    }
+
+    /* Lets the backend execute queued requests, on the MPI proxy. When
+     * execution has its own pool, the ingest handler returns right away
+     * and the requests are rendered by a ULT of the execution pool. */
+    void schedule(const std::shared_ptr<Backend>& node, size_t pool_size) {
+        if(m_pools.m_execution.native_handle() == m_pools.m_ingest.native_handle()) {
+            m_mpi_proxy->run([&]() { node->ams_schedule(pool_size, node->comm()); });
+            return;
+        }
+        auto proxy = m_mpi_proxy;
+        MPI_Comm comm = node->comm();
+        m_pools.m_execution.make_thread([node, proxy, comm, pool_size]() {
+            proxy->run([&]() { node->ams_schedule(pool_size, comm); });
+        }, tl::anonymous());
+    }
+
+    /* Pulls the segments of a payload, in order, into a pooled buffer */
+    static std::shared_ptr<void> pull_segments(BufferPool& pool, const tl::endpoint& ep,
+                                               const std::vector<tl::bulk>& segments) {
+        AMS_TRACE_SCOPE("pull", "ingest");
+        size_t size = 0;
+        for(auto& segment : segments)
+            size += segment.size();
+        auto buffer = pool.acquire(size);
+        size_t offset = 0;
+        for(auto& segment : segments) {
+            segment.on(ep) >> buffer->m_bulk.select(offset, segment.size());
+            offset += segment.size();
+        }
+        return std::shared_ptr<void>(buffer, buffer->m_data);
+    }
+
+    /* Turns a received payload into mesh data, pulling the segments
+     * sent by bulk transfer into a pooled buffer, unless the payload is
+     * late-bound and deferred is given: the backend then pulls them when
+     * it is about to render the mesh, and answers the client through
+     * *deferred */
+    MeshData receive_mesh(const tl::request& req, MeshPayload& payload,
+                          std::shared_ptr<DeferredResponse>* deferred = nullptr) {
+        MeshData mesh;
+        mesh.m_serialized = std::move(payload.m_serialized);
+        if(payload.m_segments.empty())
+            return mesh;
+        mesh.m_schema = std::move(payload.m_schema);
+        if(not payload.m_late || deferred == nullptr) {
+            mesh.m_buffer = pull_segments(*m_buffer_pool, req.get_endpoint(), payload.m_segments);
+            return mesh;
+        }
+        *deferred = std::make_shared<DeferredResponse>(req);
+        std::shared_ptr<BufferPool> pool = m_buffer_pool;
+        tl::endpoint ep = req.get_endpoint();
+        std::vector<tl::bulk> segments = std::move(payload.m_segments);
+        mesh.m_pull = [pool, ep, segments]() {
+            return pull_segments(*pool, ep, segments);
+        };
+        std::shared_ptr<DeferredResponse> response = *deferred;
+        mesh.m_respond = [response](const RequestResult<bool>& result) {
+            response->respond(result);
+        };
+        return mesh;
+    }
+
+    /* Answers a request carrying a mesh, unless the mesh is late-bound
+     * and queued, in which case the backend answers once it is pulled */
+    void respond_mesh(const tl::request& req,
+                      std::shared_ptr<DeferredResponse>& deferred,
+                      RequestResult<bool>& result) {
+        if(not deferred)
+            respond_with_load(req, result);
+        else if(not result.success())
+            deferred->respond(result);
+        deferred.reset();
+    }
+
+    /* Load of this rank, summed over its nodes */
+    ServerLoad rank_load() const {
+        ServerLoad load;
+        auto backends = std::atomic_load(&m_backends);
+        for(auto& backend : *backends)
+            load += backend.second->load();
+        return load;
+    }
+
+    /* Answers a node request with this rank's load attached, so that
+     * clients get fresh load information without polling ams_get_load */
+    template<typename T>
+    void respond_with_load(const tl::request& req, RequestResult<T>& result) {
+        result.setLoadHint(LoadHint(rank_load()));
+        req.respond(result);
     }
 
     void createNode(const tl::request& req,
@@ -115,8 +457,6 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
                         const std::string& node_type,
                         const std::string& node_config) {
 
-
-        auto node_id = UUID::generate();
         RequestResult<UUID> result;
 
         if(m_token.size() > 0 && m_token != token) {
@@ -126,38 +466,62 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
             return;
         }
 
+        result = create_node(node_type, node_config);
+        req.respond(result);
+    }
+
+    /* Duplicates m_comm for a new node, on the MPI proxy. Collective:
+     * the ranks of the instance create their nodes in the same order. */
+    MPI_Comm duplicate_comm() {
+        MPI_Comm comm;
+        MPI_Comm_dup(m_comm, &comm);
+        std::lock_guard<tl::mutex> lock(m_backends_mtx);
+        m_node_comms.push_back(comm);
+        return comm;
+    }
+
+    /* Creates a node, for the ams_create_node RPC or for a local caller */
+    RequestResult<UUID> create_node(const std::string& node_type,
+                                    const std::string& node_config) {
+
+        auto node_id = UUID::generate();
+        RequestResult<UUID> result;
+
         json json_config;
         try {
             json_config = json::parse(node_config);
         } catch(json::parse_error& e) {
             result.error() = e.what();
             result.success() = false;
-            req.respond(result);
-            return;
+            return result;
         }
 
+        /* Backends may call MPI when they are created */
         std::unique_ptr<Backend> backend;
         try {
-            backend = NodeFactory::createNode(node_type, get_engine(), json_config);
+            m_mpi_proxy->run([&]() {
+                backend = NodeFactory::createNode(node_type, get_engine(), json_config);
+                if(backend) backend->setComm(duplicate_comm());
+            });
         } catch(const std::exception& ex) {
             result.success() = false;
             result.error() = ex.what();
-            req.respond(result);
-            return;
+            return result;
         }
 
         if(not backend) {
             result.success() = false;
             result.error() = "Unknown node type "s + node_type;
-            req.respond(result);
-            return;
         } else {
+            /* Holding m_config_mtx, no update of the settings is missed */
+            std::lock_guard<tl::mutex> config_lock(m_config_mtx);
+            backend->configureScheduler(m_config["scheduler"]);
             std::lock_guard<tl::mutex> lock(m_backends_mtx);
-            m_backends[node_id] = std::move(backend);
+            std::shared_ptr<Backend> added = std::move(backend);
+            update_backends([&](BackendTable& backends) { backends[node_id] = added; });
             result.value() = node_id;
         }
-        
-        req.respond(result);
+        return result;
     }
 
     void openNode(const tl::request& req,
@@ -188,7 +552,10 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
 
         std::unique_ptr<Backend> backend;
         try {
-            backend = NodeFactory::openNode(node_type, get_engine(), json_config);
+            m_mpi_proxy->run([&]() {
+                backend = NodeFactory::openNode(node_type, get_engine(), json_config);
+                if(backend) backend->setComm(duplicate_comm());
+            });
         } catch(const std::exception& ex) {
             result.success() = false;
             result.error() = ex.what();
@@ -202,8 +569,12 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
             req.respond(result);
             return;
         } else {
+            /* Holding m_config_mtx, no update of the settings is missed */
+            std::lock_guard<tl::mutex> config_lock(m_config_mtx);
+            backend->configureScheduler(m_config["scheduler"]);
             std::lock_guard<tl::mutex> lock(m_backends_mtx);
-            m_backends[node_id] = std::move(backend);
+            std::shared_ptr<Backend> added = std::move(backend);
+            update_backends([&](BackendTable& backends) { backends[node_id] = added; });
             result.value() = node_id;
         }
         
@@ -226,14 +597,14 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
         {
             std::lock_guard<tl::mutex> lock(m_backends_mtx);
 
-            if(m_backends.count(node_id) == 0) {
+            if(m_backends->count(node_id) == 0) {
                 result.success() = false;
                 result.error() = "Node "s + node_id.to_string() + " not found";
                 req.respond(result);
                 return;
             }
 
-            m_backends.erase(node_id);
+            update_backends([&](BackendTable& backends) { backends.erase(node_id); });
         }
         req.respond(result);
     }
@@ -253,20 +624,193 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
         {
             std::lock_guard<tl::mutex> lock(m_backends_mtx);
 
-            if(m_backends.count(node_id) == 0) {
+            if(m_backends->count(node_id) == 0) {
                 result.success() = false;
                 result.error() = "Node "s + node_id.to_string() + " not found";
                 req.respond(result);
                 return;
             }
 
-            result = m_backends[node_id]->destroy();
-            m_backends.erase(node_id);
+            result = m_backends->at(node_id)->destroy();
+            update_backends([&](BackendTable& backends) { backends.erase(node_id); });
         }
 
         req.respond(result);
     }
 
+    /* Merges a partial configuration into the current one (JSON merge
+     * patch) and applies it, answering with the new configuration. Only
+     * the scheduler and receive buffer settings can change at runtime. */
+    void updateConfig(const tl::request& req,
+                      const std::string& token,
+                      const std::string& config) {
+
+        RequestResult<std::string> result;
+
+        if(m_token.size() > 0 && m_token != token) {
+            result.success() = false;
+            result.error() = "Invalid security token";
+            req.respond(result);
+            return;
+        }
+
+        try {
+            json patch = json::parse(config);
+            std::lock_guard<tl::mutex> lock(m_config_mtx);
+            json updated = m_config;
+            updated.merge_patch(patch);
+            for(const char* key : { "mpi_proxy", "pools", "trace" }) {
+                if(updated[key] != m_config[key])
+                    throw std::invalid_argument("\""s + key + "\" cannot be changed at runtime");
+            }
+            apply_tunables(updated);
+            m_config = std::move(updated);
+            result.value() = m_config.dump();
+        } catch(const std::exception& ex) {
+            result.success() = false;
+            result.error() = ex.what();
+        }
+        req.respond(result);
+    }
+
+    /* Answers with the current nodes and load of every rank of the
+     * instance, asked to each of them, and with the load of the instance:
+     * { "members": [ { "address": "...", "nodes": [ "<uuid>", ... ],
+     *                  "load": { ... } }, ... ],
+     *   "load": { "queued_requests": 0, "queued_bytes": 0, "eta": 0.0,
+     *             "executing": false, "memory_pressure": false } }
+     * where members are in instance rank order. The instance's queues
+     * add up and its ranks render together, so its eta is the largest of
+     * theirs. Before publish_membership is called, only this rank is
+     * listed. */
+    void getDirectory(const tl::request& req) {
+        RequestResult<std::string> result;
+        std::string self = (std::string)get_engine().self();
+        auto addresses = std::atomic_load(&m_members);
+        if(not addresses)
+            addresses = std::make_shared<const std::vector<std::string>>(1, self);
+        try {
+            /* Ask the other ranks in parallel, and wait for every answer
+             * before looking at any */
+            std::vector<tl::provider_handle> handles;
+            for(auto& address : *addresses) {
+                if(address != self)
+                    handles.emplace_back(get_engine().lookup(address), get_provider_id());
+            }
+            std::vector<tl::async_response> pending;
+            for(auto& ph : handles)
+                pending.push_back(m_get_member.on(ph).async());
+            std::vector<RequestResult<std::string>> answers;
+            for(auto& response : pending) {
+                RequestResult<std::string> answer = response.wait();
+                answers.push_back(std::move(answer));
+            }
+
+            json directory;
+            directory["members"] = json::array();
+            ServerLoad total;
+            auto answer = answers.begin();
+            for(auto& address : *addresses) {
+                json member;
+                if(address == self) {
+                    member = local_member();
+                } else {
+                    if(not answer->success())
+                        throw std::runtime_error(address + ": " + answer->error());
+                    member = json::parse(answer->value());
+                    ++answer;
+                }
+                ServerLoad load = load_from_json(member["load"]);
+                total.queued_requests += load.queued_requests;
+                total.queued_bytes += load.queued_bytes;
+                total.eta = std::max(total.eta, load.eta);
+                total.executing = total.executing || load.executing;
+                total.memory_pressure = total.memory_pressure || load.memory_pressure;
+                directory["members"].push_back(std::move(member));
+            }
+            directory["load"] = load_to_json(total);
+            result.value() = directory.dump();
+        } catch(const std::exception& ex) {
+            result.success() = false;
+            result.error() = "Could not reach every rank of the instance: "s + ex.what();
+        }
+        req.respond(result);
+    }
+
+    /* Answers with the address, nodes and load of this rank, see
+     * getDirectory */
+    void getMember(const tl::request& req) {
+        RequestResult<std::string> result;
+        result.value() = local_member().dump();
+        req.respond(result);
+    }
+
+    /* Answers with the load of a node. Neither the backend table lock
+     * nor the execution pool is involved, so that clients can poll it
+     * while the node is rendering. */
+    void getLoad(const tl::request& req,
+                 const UUID& node_id) {
+        RequestResult<ServerLoad> result;
+        FIND_NODE(node);
+        result.value() = node->load();
+        respond_with_load(req, result);
+    }
+
+    static json load_to_json(const ServerLoad& load) {
+        json j;
+        j["queued_requests"] = load.queued_requests;
+        j["queued_bytes"] = load.queued_bytes;
+        j["eta"] = load.eta;
+        j["executing"] = load.executing;
+        j["memory_pressure"] = load.memory_pressure;
+        return j;
+    }
+
+    static ServerLoad load_from_json(const json& j) {
+        ServerLoad load;
+        load.queued_requests = j.at("queued_requests").get<uint64_t>();
+        load.queued_bytes = j.at("queued_bytes").get<uint64_t>();
+        load.eta = j.value("eta", 0.0);
+        load.executing = j.value("executing", false);
+        load.memory_pressure = j.value("memory_pressure", false);
+        return load;
+    }
+
+    json local_member() const {
+        json member;
+        member["address"] = (std::string)get_engine().self();
+        member["nodes"] = json::array();
+        auto backends = std::atomic_load(&m_backends);
+        for(auto& backend : *backends)
+            member["nodes"].push_back(backend.first.to_string());
+        member["load"] = load_to_json(rank_load());
+        return member;
+    }
+
+    /* Gathers the address of every rank of the instance; their nodes
+     * and loads are asked to them by getDirectory. Collective over
+     * m_comm. */
+    void publish_membership() {
+        std::string local = (std::string)get_engine().self();
+        std::vector<std::string> all;
+        m_mpi_proxy->run([&]() {
+            int size;
+            MPI_Comm_size(m_comm, &size);
+            int length = (int)local.size();
+            std::vector<int> lengths(size), offsets(size, 0);
+            MPI_Allgather(&length, 1, MPI_INT, lengths.data(), 1, MPI_INT, m_comm);
+            for(int i = 1; i < size; i++)
+                offsets[i] = offsets[i-1] + lengths[i-1];
+            std::vector<char> buffer(offsets[size-1] + lengths[size-1]);
+            MPI_Allgatherv(local.data(), length, MPI_CHAR, buffer.data(), lengths.data(),
+                           offsets.data(), MPI_CHAR, m_comm);
+            for(int i = 0; i < size; i++)
+                all.emplace_back(buffer.data() + offsets[i], lengths[i]);
+        });
+        std::atomic_store(&m_members,
+            std::make_shared<const std::vector<std::string>>(std::move(all)));
+    }
+
     void checkNode(const tl::request& req,
                        const UUID& node_id) {
         RequestResult<bool> result;
@@ -286,72 +830,196 @@ class ProviderImpl : public tl::provider<ProviderImpl> {
     void ams_open(const tl::request& req,
                   const UUID& node_id,
 		  std::string opts) {
+        AMS_TRACE_SCOPE("ams_open", "rpc");
         RequestResult<bool> result;
         FIND_NODE(node);
-        result = node->ams_open(opts);
-	req.respond(result);
+        m_mpi_proxy->run([&]() { result = node->ams_open(opts); });
+	respond_with_load(req, result);
     }
 
     void ams_close(const tl::request& req,
                   const UUID& node_id) {
+        AMS_TRACE_SCOPE("ams_close", "rpc");
         RequestResult<bool> result;
         FIND_NODE(node);
-        result = node->ams_close();
-	req.respond(result);
+        m_mpi_proxy->run([&]() { result = node->ams_close(); });
+	respond_with_load(req, result);
     }
 
     void ams_execute(const tl::request& req,
                   const UUID& node_id,
 		  std::string actions) {
+        AMS_TRACE_SCOPE("ams_execute", "rpc");
         RequestResult<bool> result;
         FIND_NODE(node);
-        result = node->ams_execute(actions);
-	req.respond(result);
+        m_mpi_proxy->run([&]() { result = node->ams_execute(actions); });
+	respond_with_load(req, result);
     }
 
     void ams_open_publish_execute(const tl::request& req,
                   const UUID& node_id,
 		  std::string open_opts,
-		  std::string bp_mesh,
+		  MeshPayload bp_mesh,
 		  size_t mesh_size,
 		  std::string actions,
 		  unsigned int ts) {
+        AMS_TRACE_SCOPE("ams_open_publish_execute", "rpc");
         RequestResult<bool> result;
         FIND_NODE(node);
 
-	auto engine = get_engine();
-	auto pool = engine.get_handler_pool();
-	result.value() = true;
-	req.respond(result);
-	node->ams_open_publish_execute(open_opts, bp_mesh, mesh_size, actions, ts, pool.total_size(), m_comm);
+	/* Respond once the request is queued so that ingestion errors
+	 * (e.g. unknown cached subtrees) reach the client, then execute.
+	 * The backend queues the request even if it failed on this rank,
+	 * so every rank schedules the same requests.
+	 * Late-bound meshes are answered once pulled, see MeshData. */
+	auto& pool = m_pools.m_ingest;
+	MeshData mesh;
+	std::shared_ptr<DeferredResponse> deferred;
+	try {
+	    mesh = receive_mesh(req, bp_mesh, &deferred);
+	} catch(const std::exception& ex) {
+	    mesh.m_error = ex.what();
+	}
+	result = node->ams_open_publish_execute(open_opts, std::move(mesh), mesh_size, actions, ts, pool.total_size());
+	respond_mesh(req, deferred, result);
+	schedule(node, pool.total_size());
     }
 
     void ams_execute_pending_requests(const tl::request& req,
                   const UUID& node_id) {
+        AMS_TRACE_SCOPE("ams_execute_pending_requests", "rpc");
         RequestResult<bool> result;
         FIND_NODE(node);
 	auto engine = get_engine();
-	auto pool = engine.get_handler_pool();
-	node->ams_execute_pending_requests(engine, pool.total_size(), m_comm);
+	m_mpi_proxy->run([&]() { node->ams_execute_pending_requests(engine, m_pools.m_ingest.total_size(), node->comm()); });
     }
 
     void ams_publish_and_execute(const tl::request& req,
                   const UUID& node_id,
 		  std::string bp_mesh,
 		  std::string actions) {
+        AMS_TRACE_SCOPE("ams_publish_and_execute", "rpc");
         RequestResult<bool> result;
         FIND_NODE(node);
-        result = node->ams_publish_and_execute(bp_mesh, actions);
-	req.respond(result);
+        m_mpi_proxy->run([&]() { result = node->ams_publish_and_execute(bp_mesh, actions); });
+	respond_with_load(req, result);
     }
 
     void ams_publish(const tl::request& req,
                   const UUID& node_id,
 		  std::string bp_mesh) {
+        AMS_TRACE_SCOPE("ams_publish", "rpc");
+        RequestResult<bool> result;
+        FIND_NODE(node);
+        m_mpi_proxy->run([&]() { result = node->ams_publish(bp_mesh); });
+	respond_with_load(req, result);
+    }
+
+    void ams_create_mesh(const tl::request& req,
+                  const UUID& node_id,
+		  MeshPayload bp_mesh,
+		  size_t mesh_size) {
+        AMS_TRACE_SCOPE("ams_create_mesh", "rpc");
+        RequestResult<uint64_t> result;
+        FIND_NODE(node);
+	try {
+	    result = node->ams_create_mesh(receive_mesh(req, bp_mesh), mesh_size);
+	} catch(const std::exception& ex) {
+	    result.success() = false;
+	    result.error() = ex.what();
+	}
+	respond_with_load(req, result);
+    }
+
+    void ams_execute_on_mesh(const tl::request& req,
+                  const UUID& node_id,
+		  uint64_t mesh_id,
+		  std::string open_opts,
+		  std::string actions,
+		  unsigned int ts) {
+        AMS_TRACE_SCOPE("ams_execute_on_mesh", "rpc");
+        RequestResult<bool> result;
+        FIND_NODE(node);
+
+	auto& pool = m_pools.m_ingest;
+	result = node->ams_execute_on_mesh(mesh_id, open_opts, actions, ts, pool.total_size());
+	respond_with_load(req, result);
+	schedule(node, pool.total_size());
+    }
+
+    void ams_release_mesh(const tl::request& req,
+                  const UUID& node_id,
+		  uint64_t mesh_id) {
+        AMS_TRACE_SCOPE("ams_release_mesh", "rpc");
+        RequestResult<bool> result;
+        FIND_NODE(node);
+        result = node->ams_release_mesh(mesh_id);
+	respond_with_load(req, result);
+    }
+
+    /* Sent without expecting a response by a NodeHandle being destroyed */
+    void ams_release_subtrees(const tl::request& req,
+                  const UUID& node_id,
+		  const std::string& client_id) {
+        AMS_TRACE_SCOPE("ams_release_subtrees", "rpc");
+        auto node = find_backend(node_id);
+        if(node) node->ams_release_subtrees(client_id);
+    }
+
+    void ams_open_session(const tl::request& req,
+                  const UUID& node_id,
+		  std::string open_opts) {
+        AMS_TRACE_SCOPE("ams_open_session", "rpc");
+        RequestResult<uint64_t> result;
+        FIND_NODE(node);
+        result = node->ams_open_session(open_opts);
+	respond_with_load(req, result);
+    }
+
+    void ams_register_pipeline(const tl::request& req,
+                  const UUID& node_id,
+		  uint64_t session_id,
+		  std::string name,
+		  std::string actions) {
+        AMS_TRACE_SCOPE("ams_register_pipeline", "rpc");
+        RequestResult<uint64_t> result;
+        FIND_NODE(node);
+        result = node->ams_register_pipeline(session_id, name, actions);
+	respond_with_load(req, result);
+    }
+
+    void ams_session_publish(const tl::request& req,
+                  const UUID& node_id,
+		  uint64_t session_id,
+		  uint64_t pipeline_id,
+		  MeshPayload bp_mesh,
+		  size_t mesh_size,
+		  unsigned int ts) {
+        AMS_TRACE_SCOPE("ams_session_publish", "rpc");
+        RequestResult<bool> result;
+        FIND_NODE(node);
+
+	auto& pool = m_pools.m_ingest;
+	MeshData mesh;
+	std::shared_ptr<DeferredResponse> deferred;
+	try {
+	    mesh = receive_mesh(req, bp_mesh, &deferred);
+	} catch(const std::exception& ex) {
+	    mesh.m_error = ex.what();
+	}
+	result = node->ams_session_publish(session_id, pipeline_id, std::move(mesh), mesh_size, ts, pool.total_size());
+	respond_mesh(req, deferred, result);
+	schedule(node, pool.total_size());
+    }
+
+    void ams_close_session(const tl::request& req,
+                  const UUID& node_id,
+		  uint64_t session_id) {
+        AMS_TRACE_SCOPE("ams_close_session", "rpc");
         RequestResult<bool> result;
         FIND_NODE(node);
-        result = node->ams_publish(bp_mesh);
-	req.respond(result);
+        result = node->ams_close_session(session_id);
+	respond_with_load(req, result);
     }
 
     void computeSum(const tl::request& req,
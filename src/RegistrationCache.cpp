@@ -0,0 +1,68 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "RegistrationCache.hpp"
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace ams {
+
+void RegistrationCache::setCapacity(size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_capacity = bytes;
+    while(m_bytes > m_capacity)
+        erase(m_entries.find(m_lru.back()));
+}
+
+void RegistrationCache::erase(std::map<uintptr_t, Entry>::iterator it) {
+    m_bytes -= it->second.m_size;
+    m_lru.erase(it->second.m_lru);
+    m_entries.erase(it);
+}
+
+void RegistrationCache::erase_overlapping(uintptr_t start, size_t size) {
+    auto it = m_entries.upper_bound(start);
+    if(it != m_entries.begin()) {
+        auto previous = std::prev(it);
+        if(previous->first + previous->second.m_size > start)
+            it = previous;
+    }
+    while(it != m_entries.end() && it->first < start + size) {
+        auto next = std::next(it);
+        erase(it);
+        it = next;
+    }
+}
+
+tl::bulk RegistrationCache::expose(void* ptr, size_t size) {
+    std::vector<std::pair<void*, size_t>> segment = {{ ptr, size }};
+    uintptr_t start = reinterpret_cast<uintptr_t>(ptr);
+    std::lock_guard<std::mutex> lock(m_mtx);
+    auto it = m_entries.find(start);
+    if(it != m_entries.end() && it->second.m_size == size) {
+        m_hits += 1;
+        m_lru.splice(m_lru.begin(), m_lru, it->second.m_lru);
+        return it->second.m_bulk;
+    }
+    m_misses += 1;
+    erase_overlapping(start, size);
+    tl::bulk bulk = m_engine.expose(segment, tl::bulk_mode::read_only);
+    if(size > m_capacity)
+        return bulk;
+    while(m_bytes + size > m_capacity)
+        erase(m_entries.find(m_lru.back()));
+    m_lru.push_front(start);
+    m_entries.emplace(start, Entry{ size, bulk, m_lru.begin() });
+    m_bytes += size;
+    return bulk;
+}
+
+void RegistrationCache::invalidate(const void* ptr, size_t size) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    erase_overlapping(reinterpret_cast<uintptr_t>(ptr), size);
+}
+
+}
@@ -0,0 +1,95 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __AMS_REGISTRATION_CACHE_H
+#define __AMS_REGISTRATION_CACHE_H
+
+#include <thallium.hpp>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+
+namespace ams {
+
+namespace tl = thallium;
+
+/**
+ * @brief Client-side cache of the bulk handles exposing the arrays
+ * of the meshes sent by bulk transfer.
+ *
+ * Arrays are keyed by address and size, so that an array that persists
+ * across timesteps is registered once. Exposing a range that overlaps
+ * a cached array of a different address or size means that the array
+ * was reallocated: the stale registration is dropped. Arrays freed and
+ * reallocated at the same address with the same size cannot be told
+ * apart and must be invalidated explicitly (see
+ * Client::invalidateRegistrations). Registered memory stays pinned:
+ * the least recently used handles are released beyond the capacity.
+ * Since a missed invalidation makes the server pull stale data, the
+ * cache is disabled (capacity 0) unless the application enables it.
+ */
+class RegistrationCache {
+
+    public:
+
+    RegistrationCache(const tl::engine& engine)
+    : m_engine(engine) {}
+
+    /**
+     * @brief Sets the number of bytes of registered arrays kept
+     * (0 disables caching).
+     */
+    void setCapacity(size_t bytes);
+
+    size_t capacity() const {
+        return m_capacity;
+    }
+
+    /**
+     * @brief Returns a read-only bulk handle exposing size bytes at ptr.
+     */
+    tl::bulk expose(void* ptr, size_t size);
+
+    /**
+     * @brief Releases the handles of the arrays overlapping a range.
+     */
+    void invalidate(const void* ptr, size_t size);
+
+    /**
+     * @brief Number of expose calls served from the cache, and not.
+     */
+    size_t hits() const {
+        return m_hits;
+    }
+
+    size_t misses() const {
+        return m_misses;
+    }
+
+    private:
+
+    struct Entry {
+        size_t                         m_size;
+        tl::bulk                       m_bulk;
+        std::list<uintptr_t>::iterator m_lru;
+    };
+
+    void erase_overlapping(uintptr_t start, size_t size);
+    void erase(std::map<uintptr_t, Entry>::iterator it);
+
+    tl::engine                 m_engine;
+    std::mutex                 m_mtx;
+    size_t                     m_capacity = 0;
+    size_t                     m_bytes    = 0;
+    size_t                     m_hits     = 0;
+    size_t                     m_misses   = 0;
+    std::map<uintptr_t, Entry> m_entries; // by address
+    std::list<uintptr_t>       m_lru;     // most recently used first
+};
+
+}
+
+#endif
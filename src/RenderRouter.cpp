@@ -0,0 +1,184 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "ams/RenderRouter.hpp"
+#include "ams/Exception.hpp"
+#include "WallTime.hpp"
+#include <algorithm>
+#include <exception>
+
+namespace ams {
+
+RenderRouter::RenderRouter(const NodeHandle& node,
+                           InlineFunction inline_fn,
+                           const RenderRouterConfig& config,
+                           MPI_Comm comm)
+: m_node(node)
+, m_inline_fn(std::move(inline_fn))
+, m_config(config)
+, m_comm(comm) {
+    if(not m_inline_fn)
+        throw Exception("RenderRouter requires an inline rendering function");
+    MPI_Comm_size(m_comm, &m_comm_size);
+    m_node.setInFlightWindow(m_config.max_in_flight, WindowPolicy::BLOCK);
+}
+
+RenderRouter::~RenderRouter() {
+    try {
+        m_node.ams_flush();
+    } catch(...) {}
+    try {
+        if(m_load_request) m_load_request.wait();
+    } catch(...) {}
+}
+
+void RenderRouter::smooth(double& estimate, double sample) const {
+    if(estimate == 0.0)
+        estimate = sample;
+    else
+        estimate = (1.0 - m_config.smoothing)*estimate + m_config.smoothing*sample;
+}
+
+double RenderRouter::inTransitCost() const {
+    double latency = m_node.submitLatency();
+    if(m_server_load_at > 0.0
+    && wall_time() - m_server_load_at <= m_config.max_load_age
+    && m_server_queue > 0)
+        latency = std::max(latency, m_server_eta);
+    double covered = m_step_interval * m_node.inFlightWindow();
+    return m_submit_cost + std::max(0.0, latency - covered);
+}
+
+RenderPath RenderRouter::choosePath(double remote, double local, bool measured) const {
+    /* Nothing to compare against until a request has completed */
+    if(not measured)
+        return RenderPath::IN_TRANSIT;
+    if(m_steps_on_path < m_config.min_dwell)
+        return m_path;
+    if(m_path == RenderPath::IN_TRANSIT) {
+        if(remote > (1.0 + m_config.hysteresis)*local)
+            return RenderPath::INLINE;
+    } else {
+        if(remote < (1.0 - m_config.hysteresis)*local)
+            return RenderPath::IN_TRANSIT;
+    }
+    return m_path;
+}
+
+RenderPath RenderRouter::submit(const conduit::Node& open_opts,
+                                const conduit::Node& bp_mesh,
+                                const conduit::Node& actions,
+                                unsigned int ts) {
+    double start = wall_time();
+    if(m_last_return > 0.0)
+        smooth(m_step_interval, start - m_last_return);
+    LoadHint hint;
+    double hint_age = 0.0;
+    if(m_node.loadHint(hint, &hint_age) && start - hint_age > m_server_load_at) {
+        reportServerLoad(hint.queue_depth, hint.wait);
+        m_server_load_at = start - hint_age;
+    }
+    if(m_config.load_poll_interval > 0.0)
+        pollServerLoad(start);
+
+    /* An earlier request that failed is reported once the ranks have
+     * agreed, by all of them, so that none is left in the collective */
+    size_t in_flight = 0;
+    std::exception_ptr error;
+    try {
+        in_flight = m_node.inFlight();
+    } catch(...) {
+        error = std::current_exception();
+        in_flight = m_node.inFlightWindow();
+    }
+    /* The ranks of the tenant agree on the largest costs, on whether
+     * a request has completed on all of them, on whether all windows
+     * have room and on whether a request failed. Until it has been
+     * measured, the inline cost is optimistically taken to be the
+     * submission overhead, so that a stalling server triggers a first
+     * inline render. */
+    double view[5] = {
+        inTransitCost(),
+        m_inline_cost > 0.0 ? m_inline_cost : m_submit_cost,
+        m_node.submitLatency() == 0.0 ? 1.0 : 0.0,
+        in_flight < m_node.inFlightWindow() ? 0.0 : 1.0,
+        error ? 1.0 : 0.0
+    };
+    if(m_comm_size > 1) {
+        double local_view[5] = { view[0], view[1], view[2], view[3], view[4] };
+        MPI_Allreduce(local_view, view, 5, MPI_DOUBLE, MPI_MAX, m_comm);
+    }
+    if(error)
+        std::rethrow_exception(error);
+    if(view[4] != 0.0)
+        throw Exception("A request submitted by another rank failed");
+    bool measured    = view[2] == 0.0;
+    bool window_room = view[3] == 0.0;
+    RenderPath path  = choosePath(view[0], view[1], measured);
+    if(path != m_path) {
+        m_path = path;
+        m_steps_on_path = 0;
+        m_stats.switches += 1;
+    }
+    m_steps_on_path += 1;
+
+    bool probe = m_path == RenderPath::INLINE
+              && m_config.probe_interval > 0
+              && m_steps_on_path % m_config.probe_interval == 0
+              && window_room;
+
+    RenderPath taken = probe ? RenderPath::IN_TRANSIT : m_path;
+    if(taken == RenderPath::IN_TRANSIT) {
+        m_node.ams_submit(open_opts, bp_mesh, actions, ts);
+        double elapsed = wall_time() - start;
+        if(in_flight < m_node.inFlightWindow())
+            smooth(m_submit_cost, elapsed);
+        m_stats.in_transit += 1;
+        m_stats.probes += probe ? 1 : 0;
+        m_stats.in_transit_seconds += elapsed;
+    } else {
+        m_inline_fn(open_opts, bp_mesh, actions);
+        double elapsed = wall_time() - start;
+        smooth(m_inline_cost, elapsed);
+        m_stats.inline_renders += 1;
+        m_stats.inline_seconds += elapsed;
+    }
+
+    m_last_return = wall_time();
+    return taken;
+}
+
+void RenderRouter::flush() {
+    m_node.ams_flush();
+}
+
+/* Uses the answer of the previous poll, if any, and sends a new one
+ * when the interval has elapsed. A failed poll only loses a sample. */
+void RenderRouter::pollServerLoad(double now) {
+    if(m_load_request) {
+        try {
+            if(not m_load_request.test())
+                return;
+            reportServerLoad(m_polled_load.queued_requests, m_polled_load.eta);
+        } catch(const Exception&) {}
+        m_load_request = AsyncRequest();
+    }
+    if(now - m_last_poll < m_config.load_poll_interval)
+        return;
+    m_last_poll = now;
+    try {
+        m_node.ams_get_load(&m_polled_load, &m_load_request);
+    } catch(const Exception&) {
+        m_load_request = AsyncRequest();
+    }
+}
+
+void RenderRouter::reportServerLoad(size_t queue_depth, double eta) {
+    m_server_queue   = queue_depth;
+    m_server_eta     = eta;
+    m_server_load_at = wall_time();
+}
+
+}
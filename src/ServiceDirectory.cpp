@@ -0,0 +1,107 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "ams/ServiceDirectory.hpp"
+#include "ams/Exception.hpp"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace ams {
+
+static bool read_file(const std::string& filename, std::string& contents) {
+    std::ifstream in(filename.c_str());
+    if(not in) return false;
+    std::stringstream ss;
+    ss << in.rdbuf();
+    contents = ss.str();
+    return true;
+}
+
+ServiceDirectory ServiceDirectory::parse(const std::string& addresses,
+                                         const std::string& nodes) {
+    ServiceDirectory directory;
+    std::istringstream in(addresses);
+    std::string line;
+    size_t size = 0;
+    std::getline(in, line);
+    std::istringstream header(line);
+    if(not (header >> size) || not (header >> std::ws).eof())
+        throw Exception("Address file should start with the number of ranks");
+    while(directory.m_members.size() < size && std::getline(in, line)) {
+        size_t pos = line.find(' ');
+        ServiceMember member;
+        if(pos == std::string::npos || not (std::istringstream(line.substr(0, pos)) >> member.instance_rank))
+            throw Exception("Malformed address file line \"" + line + "\"");
+        member.address = line.substr(pos + 1);
+        directory.m_members.push_back(std::move(member));
+    }
+    if(directory.m_members.size() != size)
+        throw Exception("Address file lists " + std::to_string(directory.m_members.size())
+                      + " of " + std::to_string(size) + " ranks");
+    if(nodes.empty())
+        return directory;
+    std::istringstream node_in(nodes);
+    size_t i = 0;
+    while(std::getline(node_in, line)) {
+        if(line.empty()) continue;
+        if(i == size)
+            throw Exception("Node file lists more nodes than there are ranks");
+        try {
+            directory.m_members[i++].node_id = UUID::from_string(line.c_str());
+        } catch(const std::invalid_argument&) {
+            throw Exception("Malformed node id \"" + line + "\"");
+        }
+    }
+    if(i != size)
+        throw Exception("Node file lists " + std::to_string(i) + " of "
+                      + std::to_string(size) + " nodes");
+    return directory;
+}
+
+std::vector<InstanceInfo> ServiceDirectory::instances() const {
+    std::vector<InstanceInfo> instances;
+    for(auto& member : m_members) {
+        if(instances.empty() || member.instance_rank == 0)
+            instances.emplace_back();
+        instances.back().members.push_back(member);
+    }
+    return instances;
+}
+
+ServiceDirectory ServiceDirectory::load(const std::string& address_file,
+                                        const std::string& node_file) {
+    std::string addresses, nodes;
+    if(not read_file(address_file, addresses))
+        throw Exception("Could not read " + address_file);
+    if(not node_file.empty() && not read_file(node_file, nodes))
+        throw Exception("Could not read " + node_file);
+    return parse(addresses, nodes);
+}
+
+ServiceDirectory ServiceDirectory::load(const std::string& address_file,
+                                        const std::string& node_file,
+                                        MPI_Comm comm, int root) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    std::string addresses, nodes;
+    long long sizes[2] = { -1, -1 };
+    if(rank == root && read_file(address_file, addresses)
+    && (node_file.empty() || read_file(node_file, nodes))) {
+        sizes[0] = (long long)addresses.size();
+        sizes[1] = (long long)nodes.size();
+    }
+    MPI_Bcast(sizes, 2, MPI_LONG_LONG, root, comm);
+    if(sizes[0] < 0)
+        throw Exception("Could not read " + address_file
+                      + (node_file.empty() ? "" : " or " + node_file));
+    addresses.resize(sizes[0]);
+    nodes.resize(sizes[1]);
+    MPI_Bcast(&addresses[0], (int)sizes[0], MPI_CHAR, root, comm);
+    MPI_Bcast(&nodes[0], (int)sizes[1], MPI_CHAR, root, comm);
+    return parse(addresses, nodes);
+}
+
+}
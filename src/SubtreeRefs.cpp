@@ -0,0 +1,228 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "SubtreeRefs.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace ams {
+
+static const uint64_t K1 = 0x87c37b91114253d5ULL;
+static const uint64_t K2 = 0x4cf5ad432745937fULL;
+
+static inline uint64_t rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t mix(uint64_t h, uint64_t w) {
+    h ^= rotl(w * K1, 31) * K2;
+    return rotl(h, 27) * 5 + 0x52dce729;
+}
+
+static uint64_t hash_bytes(uint64_t h, const void* data, size_t size) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    size_t i = 0;
+    for(; i + 8 <= size; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, p + i, 8);
+        h = mix(h, w);
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, p + i, size - i);
+    return mix(h, tail ^ ((uint64_t)size << 56));
+}
+
+static uint64_t hash_node(uint64_t h, const conduit::Node& node) {
+    const conduit::DataType& dt = node.dtype();
+    h = mix(h, (uint64_t)dt.id());
+    if(dt.is_object()) {
+        for(conduit::index_t i = 0; i < node.number_of_children(); i++) {
+            const std::string name = node.child(i).name();
+            h = hash_bytes(h, name.data(), name.size());
+            h = hash_node(h, node.child(i));
+        }
+    } else if(dt.is_list()) {
+        for(conduit::index_t i = 0; i < node.number_of_children(); i++)
+            h = hash_node(h, node.child(i));
+    } else if(not dt.is_empty()) {
+        conduit::index_t n = dt.number_of_elements();
+        h = mix(h, (uint64_t)n);
+        if(dt.is_compact()) {
+            h = hash_bytes(h, node.element_ptr(0), dt.bytes_compact());
+        } else {
+            for(conduit::index_t i = 0; i < n; i++)
+                h = hash_bytes(h, node.element_ptr(i), dt.element_bytes());
+        }
+    }
+    return h;
+}
+
+uint64_t hash_subtree(const conduit::Node& node) {
+    uint64_t h = hash_node(0x9e3779b97f4a7c15ULL, node);
+    /* final avalanche */
+    h ^= h >> 33; h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33; h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+std::string SubtreeRefs::marker(uint64_t hash) const {
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)hash);
+    return m_client_id + "/" + hex;
+}
+
+/* Views are only read (serialized), see ActionAnalysis.cpp */
+static void reference(conduit::Node& dst, const conduit::Node& src) {
+    dst.set_external(const_cast<conduit::Node&>(src));
+}
+
+/* The first marker of a view also carries its drops, see encode */
+void SubtreeRefs::mark(conduit::Node& dst, const char* kind, uint64_t hash) {
+    dst[kind] = marker(hash);
+    if(not m_first_marker) m_first_marker = &dst;
+    m_used = true;
+}
+
+bool SubtreeRefs::encode_domain(const std::string& prefix, const conduit::Node& domain,
+                                conduit::Node& view, Carried& carried) {
+    bool changed = false;
+    for(conduit::index_t i = 0; i < domain.number_of_children(); i++) {
+        const conduit::Node& group = domain.child(i);
+        const std::string group_name = group.name();
+        if(group_name != "coordsets" && group_name != "topologies") {
+            reference(view[group_name], group);
+            continue;
+        }
+        for(conduit::index_t j = 0; j < group.number_of_children(); j++) {
+            const conduit::Node& subtree = group.child(j);
+            conduit::Node& dst = view[group_name][subtree.name()];
+            size_t bytes = subtree.total_bytes_compact();
+            if(bytes < m_min_bytes) {
+                reference(dst, subtree);
+                continue;
+            }
+            const std::string path = prefix + group_name + "/" + subtree.name();
+            uint64_t hash = hash_subtree(subtree);
+            auto known = m_known.find(hash);
+            if(known != m_known.end()) {
+                m_lru.splice(m_lru.begin(), m_lru, known->second);
+                known->second->m_last_use = m_next_seq;
+                mark(dst, "ams_ref", hash);
+                changed = true;
+            } else if(m_last_hash.count(path) && m_last_hash[path] == hash
+                   && not m_dropping.count(hash)) {
+                /* Unchanged since the last request: ask the server to keep it
+                 * (it may still hold it, if its drop has not been sent yet) */
+                reference(dst, subtree);
+                mark(dst, "ams_hash", hash);
+                m_evicted.erase(hash);
+                carried.m_stored.emplace_back(hash, bytes);
+                changed = true;
+            } else {
+                reference(dst, subtree);
+            }
+            m_last_hash[path] = hash;
+        }
+    }
+    return changed;
+}
+
+bool SubtreeRefs::encode(const conduit::Node& mesh, conduit::Node& view, Carried& carried) {
+    if(not m_enabled) return false;
+    view.reset();
+    carried = Carried();
+    m_first_marker = nullptr;
+    bool changed = false;
+    try {
+        if(mesh.has_child("coordsets")) {
+            changed = encode_domain("", mesh, view, carried);
+        } else if(mesh.dtype().is_list()) {
+            for(conduit::index_t d = 0; d < mesh.number_of_children(); d++)
+                changed |= encode_domain(std::to_string(d) + "/", mesh.child(d), view.append(), carried);
+        } else if(mesh.dtype().is_object()) {
+            for(conduit::index_t d = 0; d < mesh.number_of_children(); d++) {
+                const conduit::Node& domain = mesh.child(d);
+                changed |= encode_domain(domain.name() + "/", domain, view[domain.name()], carried);
+            }
+        }
+    } catch(const conduit::Error&) {
+        changed = false;
+    }
+    if(not changed) {
+        /* Subtrees taken off the drop list are not sent after all */
+        for(auto& stored : carried.m_stored)
+            m_evicted.emplace(stored.first, 0);
+        view.reset();
+        carried = Carried();
+        m_first_marker = nullptr;
+        return false;
+    }
+
+    carried.m_seq = m_next_seq++;
+    /* Subtrees are dropped once the requests referring to them have completed */
+    uint64_t oldest = m_in_flight.empty() ? carried.m_seq : *m_in_flight.begin();
+    for(auto it = m_evicted.begin(); it != m_evicted.end();) {
+        if(it->second >= oldest) {
+            ++it;
+            continue;
+        }
+        (*m_first_marker)["ams_drop"].append().set(marker(it->first));
+        carried.m_dropped.push_back(it->first);
+        m_dropping[it->first] = carried.m_seq;
+        it = m_evicted.erase(it);
+    }
+    m_first_marker = nullptr;
+    m_in_flight.insert(carried.m_seq);
+    return true;
+}
+
+void SubtreeRefs::evict(const Known& known) {
+    uint64_t& last_use = m_evicted[known.m_hash];
+    last_use = std::max(last_use, known.m_last_use);
+}
+
+void SubtreeRefs::complete(const Carried& carried, bool success) {
+    m_in_flight.erase(carried.m_seq);
+    for(uint64_t hash : carried.m_dropped) {
+        auto it = m_dropping.find(hash);
+        if(it != m_dropping.end() && it->second == carried.m_seq)
+            m_dropping.erase(it);
+        /* The server may not have seen the drop: send it again */
+        if(not success)
+            m_evicted.emplace(hash, 0);
+    }
+    for(auto& c : carried.m_stored) {
+        if(m_known.count(c.first)) continue;
+        /* A subtree the server may hold without being known here is
+         * dropped, unless a drop is already on its way */
+        if(not success || c.second > m_capacity || m_dropping.count(c.first)) {
+            if(not m_dropping.count(c.first))
+                m_evicted.emplace(c.first, carried.m_seq);
+            continue;
+        }
+        while(m_known_bytes + c.second > m_capacity && not m_lru.empty()) {
+            evict(m_lru.back());
+            m_known_bytes -= m_lru.back().m_bytes;
+            m_known.erase(m_lru.back().m_hash);
+            m_lru.pop_back();
+        }
+        m_lru.push_front(Known{c.first, c.second, carried.m_seq});
+        m_known[c.first] = m_lru.begin();
+        m_known_bytes += c.second;
+        m_evicted.erase(c.first);
+    }
+}
+
+void SubtreeRefs::forget() {
+    for(auto& known : m_lru)
+        evict(known);
+    m_lru.clear();
+    m_known.clear();
+    m_known_bytes = 0;
+}
+
+}
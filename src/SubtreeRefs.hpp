@@ -0,0 +1,124 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __AMS_SUBTREE_REFS_H
+#define __AMS_SUBTREE_REFS_H
+
+#include <conduit.hpp>
+#include <cstdint>
+#include <list>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ams {
+
+/**
+ * @brief Content hash of a conduit subtree (names, types and data).
+ */
+uint64_t hash_subtree(const conduit::Node& node);
+
+/**
+ * @brief Client side of the coordset/topology cache.
+ *
+ * Each coordset and topology of the meshes sent to a node is hashed.
+ * A subtree seen unchanged at the same path for the second time is sent
+ * with an "ams_hash" marker, asking the server to keep a copy. Once the
+ * request carrying it has been acknowledged, the subtree is sent as an
+ * "ams_ref" node, which the server replaces with its copy (see
+ * SubtreeCache in the dummy backend). Markers are "<client id>/<hash>".
+ *
+ * The set of subtrees the server is known to hold is bounded by the
+ * capacity, which should not exceed the per-client capacity of the
+ * server. The server never evicts subtrees on its own: those evicted
+ * here are listed in an "ams_drop" node on the first marker of a later
+ * mesh, once the requests that referred to them have completed. Each
+ * encoded mesh must be passed to complete() when its request completes.
+ * If the server reports an unknown reference anyway (restart),
+ * forget() makes the next requests send everything again.
+ */
+class SubtreeRefs {
+
+    public:
+
+    /**
+     * @brief Subtrees marked for caching and dropped by an encoded mesh.
+     */
+    struct Carried {
+        uint64_t                                 m_seq = 0;
+        std::vector<std::pair<uint64_t, size_t>> m_stored;  // hash, bytes
+        std::vector<uint64_t>                    m_dropped; // hashes
+    };
+
+    std::string m_client_id;
+    bool        m_enabled   = true;
+    size_t      m_min_bytes = 4096;             // smaller subtrees are always sent
+    size_t      m_capacity  = 32 * 1024 * 1024; // bytes of subtrees known by the server
+
+    /**
+     * @brief Builds a view of mesh in which the subtrees known by the
+     * server are replaced by references and the subtrees to be cached
+     * are marked. The view references the mesh's data.
+     *
+     * @param mesh Blueprint mesh (single or multi-domain).
+     * @param view Resulting view.
+     * @param carried What the view asks the server to store and drop.
+     *
+     * @return false if the mesh is to be sent as is.
+     */
+    bool encode(const conduit::Node& mesh, conduit::Node& view, Carried& carried);
+
+    /**
+     * @brief Records the completion of the request that sent an encoded
+     * mesh: the server holds the stored subtrees if it succeeded.
+     */
+    void complete(const Carried& carried, bool success);
+
+    /**
+     * @brief Forgets which subtrees the server holds. They are dropped
+     * once the requests referring to them have completed.
+     */
+    void forget();
+
+    /**
+     * @brief Whether the server was ever asked to store a subtree, in
+     * which case it should be told to release them when done.
+     */
+    bool used() const {
+        return m_used;
+    }
+
+    private:
+
+    struct Known {
+        uint64_t m_hash;
+        size_t   m_bytes;
+        uint64_t m_last_use; // last request referring to it
+    };
+
+    bool encode_domain(const std::string& prefix, const conduit::Node& domain,
+                       conduit::Node& view, Carried& carried);
+    void mark(conduit::Node& dst, const char* kind, uint64_t hash);
+    std::string marker(uint64_t hash) const;
+    void evict(const Known& known);
+
+    std::unordered_map<std::string, uint64_t> m_last_hash; // path -> hash
+    std::list<Known>                          m_lru;       // most recently used first
+    std::unordered_map<uint64_t, std::list<Known>::iterator> m_known;
+    size_t m_known_bytes = 0;
+
+    uint64_t                               m_next_seq = 1;
+    std::set<uint64_t>                     m_in_flight; // requests not completed
+    std::unordered_map<uint64_t, uint64_t> m_evicted;   // hash -> last use, to drop
+    std::unordered_map<uint64_t, uint64_t> m_dropping;  // hash -> request dropping it
+    conduit::Node*                         m_first_marker = nullptr;
+    bool                                   m_used = false;
+};
+
+}
+
+#endif
@@ -0,0 +1,134 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "ams/TenantPlacement.hpp"
+#include "ams/Exception.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace ams {
+
+/* FNV-1a followed by a 64-bit finalizer, for an even spread of
+ * similar strings (e.g. addresses differing by a port) */
+static uint64_t hash_string(const std::string& str) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for(unsigned char c : str) {
+        h ^= c;
+        h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 33; h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33; h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+TenantPlacement::TenantPlacement(std::vector<InstanceInfo> instances,
+                                 const PlacementConfig& config)
+: m_instances(std::move(instances))
+, m_config(config)
+, m_assigned(m_instances.size(), 0) {
+    if(m_instances.empty())
+        throw Exception("No instance to place tenants on");
+    for(size_t i = 0; i < m_instances.size(); i++) {
+        if(m_instances[i].members.empty())
+            throw Exception("Instance " + std::to_string(i) + " has no rank");
+        /* An instance is identified by the address of its first rank */
+        const std::string& key = m_instances[i].members[0].address;
+        for(unsigned v = 0; v < std::max(m_config.virtual_nodes, 1u); v++)
+            m_ring.emplace_back(hash_string(key + "#" + std::to_string(v)), i);
+    }
+    std::sort(m_ring.begin(), m_ring.end());
+}
+
+uint64_t TenantPlacement::load(size_t instance) const {
+    return m_instances[instance].load.queued_requests + m_assigned[instance];
+}
+
+size_t TenantPlacement::place(const std::string& tenant) {
+    auto known = m_tenants.find(tenant);
+    if(known != m_tenants.end())
+        return known->second;
+
+    uint64_t total = 0;
+    for(size_t i = 0; i < m_instances.size(); i++)
+        total += load(i);
+    /* Bound on the load of the chosen instance once the tenant is added */
+    double bound = std::ceil(m_config.load_bound * (double)(total + 1) / (double)m_instances.size());
+
+    /* Distinct instances in ring order from the tenant's hash */
+    std::vector<size_t> order;
+    std::vector<bool> seen(m_instances.size(), false);
+    auto start = std::lower_bound(m_ring.begin(), m_ring.end(),
+                                  std::make_pair(hash_string(tenant), (size_t)0));
+    for(size_t k = 0; k < m_ring.size() && order.size() < m_instances.size(); k++) {
+        size_t instance = m_ring[((start - m_ring.begin()) + k) % m_ring.size()].second;
+        if(not seen[instance]) {
+            seen[instance] = true;
+            order.push_back(instance);
+        }
+    }
+
+    size_t chosen = order[0];
+    bool found = false;
+    unsigned considered = 0;
+    for(size_t instance : order) {
+        if((double)(load(instance) + 1) > bound)
+            continue;
+        if(not found || load(instance) < load(chosen)) {
+            chosen = instance;
+            found = true;
+        }
+        if(++considered == std::max(m_config.choices, 1u))
+            break;
+    }
+    if(not found) {
+        /* Every instance is above the bound: take the least loaded */
+        for(size_t instance : order)
+            if(load(instance) < load(chosen)) chosen = instance;
+    }
+    m_assigned[chosen] += 1;
+    m_tenants[tenant] = chosen;
+    return chosen;
+}
+
+size_t TenantPlacement::place(const std::string& tenant, MPI_Comm comm, int root) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    std::string key;
+    if(rank == root)
+        key = m_instances[place(tenant)].members[0].address;
+    int length = (int)key.size();
+    MPI_Bcast(&length, 1, MPI_INT, root, comm);
+    key.resize(length);
+    MPI_Bcast(&key[0], length, MPI_CHAR, root, comm);
+    if(rank == root)
+        return m_tenants[tenant];
+
+    auto known = m_tenants.find(tenant);
+    if(known != m_tenants.end() && m_instances[known->second].members[0].address == key)
+        return known->second;
+    for(size_t i = 0; i < m_instances.size(); i++) {
+        if(m_instances[i].members[0].address != key)
+            continue;
+        if(known != m_tenants.end())
+            m_assigned[known->second] -= 1;
+        m_assigned[i] += 1;
+        m_tenants[tenant] = i;
+        return i;
+    }
+    throw Exception("Tenant " + tenant + " was placed on unknown instance " + key);
+}
+
+const ServiceMember& TenantPlacement::member(const std::string& tenant, int rank, int ranks) {
+    const auto& members = m_instances[place(tenant)].members;
+    if(ranks < 0 || (size_t)ranks != members.size())
+        throw Exception("Tenant " + tenant + " has " + std::to_string(ranks)
+                      + " ranks but its instance has " + std::to_string(members.size()));
+    if(rank < 0 || rank >= ranks)
+        throw Exception("Invalid rank " + std::to_string(rank) + " for tenant " + tenant);
+    return members[rank];
+}
+
+}
@@ -0,0 +1,98 @@
+/*
+ * (C) 2020 The University of Chicago
+ * 
+ * See COPYRIGHT in top-level directory.
+ */
+#include "Tracer.hpp"
+#include "WallTime.hpp"
+
+#include <abt.h>
+
+#define TRACE_FLUSH_THRESHOLD (1024*1024)
+
+namespace ams {
+
+Tracer& Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+void Tracer::enable(const std::string& prefix, MPI_Comm comm) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    if(m_enabled) return;
+
+    int rank, comm_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_rank(comm, &comm_rank);
+
+    std::string filename = prefix + "." + std::to_string(rank) + ".json";
+    m_file = fopen(filename.c_str(), "w");
+    if(m_file) {
+        fprintf(m_file, "[\n");
+        fprintf(m_file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,"
+                        "\"args\":{\"name\":\"rank %d (instance rank %d)\"}},\n",
+                        rank, rank, comm_rank);
+        fprintf(m_file, "{\"name\":\"process_sort_index\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,"
+                        "\"args\":{\"sort_index\":%d}},\n", rank, rank);
+    }
+
+    /* Every rank enters the barrier, even if it cannot trace */
+    MPI_Barrier(comm);
+    if(!m_file) {
+        fprintf(stderr, "Error: could not open trace file %s. Tracing disabled.\n", filename.c_str());
+        return;
+    }
+    m_origin  = wall_time();
+    m_pid     = rank;
+    m_enabled = true;
+}
+
+void Tracer::disable() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    if(!m_enabled) return;
+    m_enabled = false;
+    flush_locked();
+    fclose(m_file);
+    m_file = nullptr;
+}
+
+/* Not MPI_Wtime: events are recorded by handlers that may not call MPI */
+double Tracer::now() const {
+    return (wall_time() - m_origin)*1.0e6;
+}
+
+void Tracer::complete(const char* name, const char* cat, double start, double end) {
+    int xstream_rank = 0;
+    if(ABT_xstream_self_rank(&xstream_rank) != ABT_SUCCESS)
+        xstream_rank = -1;
+    char event[256];
+    snprintf(event, sizeof(event),
+             "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d},\n",
+             name, cat, start, end - start, m_pid, xstream_rank);
+    std::lock_guard<std::mutex> lock(m_mtx);
+    if(!m_enabled) return;
+    m_buffer += event;
+    if(m_buffer.size() > TRACE_FLUSH_THRESHOLD)
+        flush_locked();
+}
+
+void Tracer::flush() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    flush_locked();
+}
+
+void Tracer::flush_locked() {
+    if(!m_file || m_buffer.empty()) return;
+    fwrite(m_buffer.data(), 1, m_buffer.size(), m_file);
+    fflush(m_file);
+    m_buffer.clear();
+}
+
+Tracer::~Tracer() {
+    if(m_file) {
+        flush_locked();
+        fclose(m_file);
+    }
+}
+
+}
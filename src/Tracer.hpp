@@ -0,0 +1,134 @@
+/*
+ * (C) 2020 The University of Chicago
+ * 
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __AMS_TRACER_HPP
+#define __AMS_TRACER_HPP
+
+#include <mpi.h>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+#define __AMS_TRACE_CONCAT2(a, b) a ## b
+#define __AMS_TRACE_CONCAT(a, b) __AMS_TRACE_CONCAT2(a, b)
+
+/**
+ * @brief Records a trace event spanning the rest of the enclosing scope.
+ */
+#define AMS_TRACE_SCOPE(__name__, __cat__) \
+    ams::TraceScope __AMS_TRACE_CONCAT(__ams_trace_scope_, __LINE__)(__name__, __cat__)
+
+namespace ams {
+
+/**
+ * @brief The Tracer records server activity as Chrome trace events
+ * (https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU)
+ * that can be visualized with chrome://tracing or Perfetto.
+ *
+ * Each process writes <prefix>.<global rank>.json in the JSON array
+ * format, leaving the array open so that the file stays valid if the
+ * server is killed. Timestamps are relative to a barrier on the
+ * provider's communicator, and the process id is the global MPI rank,
+ * so the files of all the ranks of an instance can be merged with
+ * scripts/ams_merge_traces.py.
+ */
+class Tracer {
+
+    public:
+
+    /**
+     * @brief Returns the process-wide tracer.
+     */
+    static Tracer& instance();
+
+    /**
+     * @brief Starts tracing. Collective over comm. Has no effect
+     * if the tracer is already enabled.
+     *
+     * @param prefix Prefix of the output file.
+     * @param comm Communicator of the instance.
+     */
+    void enable(const std::string& prefix, MPI_Comm comm);
+
+    /**
+     * @brief Writes buffered events and closes the output file.
+     */
+    void disable();
+
+    /**
+     * @brief Whether events are being recorded.
+     */
+    bool enabled() const {
+        return m_enabled;
+    }
+
+    /**
+     * @brief Current time in microseconds since the trace origin.
+     */
+    double now() const;
+
+    /**
+     * @brief Records a complete event (phase "X") on the calling
+     * execution stream.
+     *
+     * @param name Name of the event.
+     * @param cat Category (rpc, ingest, queue, mpi, ascent).
+     * @param start Start time, as returned by now().
+     * @param end End time, as returned by now().
+     */
+    void complete(const char* name, const char* cat, double start, double end);
+
+    /**
+     * @brief Writes buffered events to the output file.
+     */
+    void flush();
+
+    ~Tracer();
+
+    private:
+
+    Tracer() = default;
+
+    void flush_locked();
+
+    /* Read without the lock by enabled(); m_origin and m_pid are
+     * set before it becomes true and not modified afterwards */
+    std::atomic<bool> m_enabled{false};
+    double      m_origin  = 0.0;
+    int         m_pid     = 0;
+    FILE*       m_file    = nullptr;
+    std::string m_buffer;
+    std::mutex  m_mtx;
+};
+
+/**
+ * @brief RAII helper that records a complete event covering its lifetime.
+ */
+class TraceScope {
+
+    const char* m_name;
+    const char* m_cat;
+    double      m_start;
+
+    public:
+
+    TraceScope(const char* name, const char* cat)
+    : m_name(name), m_cat(cat)
+    , m_start(Tracer::instance().enabled() ? Tracer::instance().now() : 0.0) {}
+
+    ~TraceScope() {
+        auto& tracer = Tracer::instance();
+        if(tracer.enabled())
+            tracer.complete(m_name, m_cat, m_start, tracer.now());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
+
+}
+
+#endif
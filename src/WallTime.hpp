@@ -0,0 +1,23 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __AMS_WALL_TIME_HPP
+#define __AMS_WALL_TIME_HPP
+
+#include <chrono>
+
+namespace ams {
+
+/**
+ * @brief Seconds on a monotonic clock, for measuring intervals.
+ */
+inline double wall_time() {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+#endif
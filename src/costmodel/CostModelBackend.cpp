@@ -0,0 +1,66 @@
+/*
+ * (C) 2020 The University of Chicago
+ * 
+ * See COPYRIGHT in top-level directory.
+ */
+#include "CostModelBackend.hpp"
+#include "../Tracer.hpp"
+#include <chrono>
+#include <thread>
+
+AMS_REGISTER_BACKEND(costmodel, CostModelNode);
+
+void CostModelNode::parse_cost_model(const json& config) {
+    if(!config.is_object() || config.count("cost_model") == 0)
+        return;
+    auto& model = config["cost_model"];
+    m_base_ms       = model.value("base_ms", m_base_ms);
+    m_ms_per_mb     = model.value("ms_per_mb", m_ms_per_mb);
+    m_ms_per_action = model.value("ms_per_action", m_ms_per_action);
+    m_spin          = model.value("spin", m_spin);
+}
+
+double CostModelNode::modeled_time(size_t mesh_bytes, size_t num_actions) const {
+    double mesh_mb = (double)mesh_bytes / (1024.0*1024.0);
+    double ms = m_base_ms + m_ms_per_mb*mesh_mb + m_ms_per_action*(double)num_actions;
+    return ms > 0.0 ? ms/1000.0 : 0.0;
+}
+
+void CostModelNode::consume(size_t mesh_bytes, size_t num_actions) const {
+    AMS_TRACE_SCOPE("modeled_render", "ascent");
+    auto duration = std::chrono::duration<double>(modeled_time(mesh_bytes, num_actions));
+    /* Like a real render, this deliberately holds the execution stream */
+    if(m_spin) {
+        auto deadline = std::chrono::steady_clock::now() + duration;
+        while(std::chrono::steady_clock::now() < deadline);
+    } else {
+        std::this_thread::sleep_for(duration);
+    }
+}
+
+ams::RequestResult<bool> CostModelNode::ams_publish_and_execute(std::string bp_mesh, std::string actions) {
+    conduit::Node n, n_mesh;
+
+    n.parse(actions,"conduit_json");
+    n_mesh.parse(bp_mesh,"conduit_json");
+
+    consume(n_mesh.total_bytes_compact(), n.number_of_children());
+
+    ams::RequestResult<bool> result;
+    result.value() = true;
+    return result;
+}
+
+void CostModelNode::render(ascent::Ascent& a_lib, const ConduitNodeData& request) {
+    (void)a_lib;
+    consume(request.mesh().total_bytes_compact(), request.actions().number_of_children());
+}
+
+std::unique_ptr<ams::Backend> CostModelNode::create(const thallium::engine& engine, const json& config) {
+    return std::unique_ptr<ams::Backend>(new CostModelNode(config, engine));
+}
+
+std::unique_ptr<ams::Backend> CostModelNode::open(const thallium::engine& engine, const json& config) {
+    (void)engine;
+    return std::unique_ptr<ams::Backend>(new CostModelNode(config));
+}
@@ -0,0 +1,101 @@
+/*
+ * (C) 2020 The University of Chicago
+ * 
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __COST_MODEL_BACKEND_HPP
+#define __COST_MODEL_BACKEND_HPP
+
+#include "../null/NullBackend.hpp"
+
+/**
+ * Cost-model implementation of an ams Backend. Instead of calling
+ * Ascent, it occupies the calling execution stream for a time
+ * modeled from the mesh size and the number of actions:
+ *
+ *   t = base_ms + ms_per_mb * mesh_MB + ms_per_action * num_actions
+ *
+ * The parameters are read from the "cost_model" entry of the node
+ * configuration, e.g.
+ *
+ *   { "cost_model" : { "base_ms" : 1.0, "ms_per_mb" : 20.0,
+ *                      "ms_per_action" : 5.0, "spin" : false } }
+ *
+ * If "spin" is true the time is spent busy-waiting (emulating a
+ * CPU-bound render), otherwise the execution stream sleeps.
+ */
+class CostModelNode : public NullNode {
+
+    double m_base_ms       = 1.0;
+    double m_ms_per_mb     = 10.0;
+    double m_ms_per_action = 5.0;
+    bool   m_spin          = false;
+
+    void parse_cost_model(const json& config);
+
+    /* Occupies the execution stream for the modeled time */
+    void consume(size_t mesh_bytes, size_t num_actions) const;
+
+    public:
+
+    /**
+     * @brief Constructor.
+     */
+    CostModelNode(const json& config, const thallium::engine& engine)
+    : NullNode(config, engine) {
+        parse_cost_model(config);
+    }
+
+    /**
+     * @brief Constructor.
+     */
+    CostModelNode(const json& config)
+    : NullNode(config) {
+        parse_cost_model(config);
+    }
+
+    /**
+     * @brief Destructor.
+     */
+    virtual ~CostModelNode() = default;
+
+    /**
+     * @brief Returns the modeled execution time (in seconds) for
+     * a mesh of the given size and a given number of actions.
+     */
+    double modeled_time(size_t mesh_bytes, size_t num_actions) const;
+
+    /**
+     * @brief Parses the mesh and the actions and waits for the modeled time.
+     */
+    ams::RequestResult<bool> ams_publish_and_execute(std::string bp_mesh, std::string actions) override;
+
+    /**
+     * @brief Waits for the modeled time of a dequeued request.
+     */
+    void render(ascent::Ascent& a_lib, const ConduitNodeData& request) override;
+
+    /**
+     * @brief Static factory function used by the NodeFactory to
+     * create a CostModelNode.
+     *
+     * @param engine Thallium engine
+     * @param config JSON configuration for the node
+     *
+     * @return a unique_ptr to a node
+     */
+    static std::unique_ptr<ams::Backend> create(const thallium::engine& engine, const json& config);
+
+    /**
+     * @brief Static factory function used by the NodeFactory to
+     * open a CostModelNode.
+     *
+     * @param engine Thallium engine
+     * @param config JSON configuration for the node
+     *
+     * @return a unique_ptr to a node
+     */
+    static std::unique_ptr<ams::Backend> open(const thallium::engine& engine, const json& config);
+};
+
+#endif
@@ -4,18 +4,22 @@
  * See COPYRIGHT in top-level directory.
  */
 #include "DummyBackend.hpp"
+#include "../Tracer.hpp"
+#include "../Collectives.hpp"
+#include "../WallTime.hpp"
+#include "../FieldTransfer.hpp"
 #include <iostream>
 #include <ascent/ascent.hpp>
 #include <mpi.h>
 #include <unistd.h>
+#include <algorithm>
+#include <iterator>
 #include <iostream>
 #include <fstream>
+#include <mutex>
 #include <string>
 
 #define WARMUP_PERIOD 0
-#define EAGER 0
-#define LAZY 1
-#define LAZYISH 2
 
 AMS_REGISTER_BACKEND(dummy, DummyNode);
 
@@ -25,6 +29,14 @@ AMS_REGISTER_BACKEND(dummy, DummyNode);
 	return a;
 }*/
 
+DummyNode::~DummyNode() {
+    /* Resident meshes release their bytes into the scheduler when
+     * their last reference is dropped, so drop them while it exists */
+    m_meshes.clear();
+    while(not m_scheduler.empty())
+        m_scheduler.pop();
+}
+
 void DummyNode::sayHello() {
     std::cout << "Hello World" << std::endl;
 }
@@ -91,27 +103,106 @@ static double calculate_percent_memory_util()
     return (1.0-((double)memfree/(double)memtotal))*100.0;
 }
 
-void DummyNode::ams_execute_one_request(MPI_Comm comm, ascent::Ascent& a_lib, int rank, int size, FILE *fp) {
+/* Whether every rank has the same request, identified by its client
+ * task and timestep, at the head of its queue */
+static bool same_head(const ams::Scheduler<ConduitNodeData>& scheduler, MPI_Comm comm) {
+    int64_t task_id = -1, ts = -1;
+    if(not scheduler.empty()) {
+        task_id = scheduler.top().m_task_id;
+        ts      = scheduler.top().m_ts;
+    }
+    /* The maxima of the values and of their opposites give both extremes */
+    int64_t local[4] = { task_id, -task_id, ts, -ts }, global[4];
+    {
+        AMS_TRACE_SCOPE("MPI_Allreduce", "mpi");
+        ams::allreduce_yielding(local, global, 4, MPI_INT64_T, MPI_MAX, comm);
+    }
+    return global[0] == -global[1] && global[2] == -global[3];
+}
+
+/* Gives Ascent the instance's communicator. Called by the executions,
+ * which run on the MPI proxy, rather than by the handlers queuing the
+ * requests, which may run on other execution streams */
+static void bind_comm(ConduitNodeData& request, MPI_Comm comm) {
+    if(request.m_session_open_opts) {
+        request.m_open_opts = *request.m_session_open_opts;
+        request.m_session_open_opts.reset();
+    }
+    request.m_open_opts["mpi_comm"] = MPI_Comm_c2f(comm);
+}
 
-    int top_task_id = (pq.top()).m_task_id;
-    int recv;
-    MPI_Allreduce(&top_task_id, &recv, 1, MPI_INT, MPI_SUM, comm);
-    if(recv != top_task_id*size) {
+void DummyNode::ams_execute_one_request(MPI_Comm comm, ascent::Ascent& a_lib, int rank, int size, FILE *fp, FILE *state_fp) {
+
+    /* The head cannot change while the ranks compare it */
+    std::unique_lock<thallium::mutex> queue_lock(m_queue_mtx);
+    if(not same_head(m_scheduler, comm)) {
         if(rank == 0)
-            std::cerr << "Skipping this request. Size of pq: " << pq.size() << std::endl;
+            std::cerr << "Skipping this request. Size of pq: " << m_scheduler.size() << std::endl;
     } else {
         if(rank == 0) {
-            fprintf(fp, "Request is valid. Proceeding with the Ascent computation. Num items in queue: %d\n", pq.size());
+            fprintf(fp, "Request is valid. Proceeding with the Ascent computation. Num items in queue: %zu\n", m_scheduler.size());
 	}
     }
     /* Perform the ascent viz as a single, atomic operation within the context of the RPC */
-    a_lib.open((pq.top()).m_open_opts);
-    a_lib.publish((pq.top()).m_data);
-    a_lib.execute((pq.top()).m_actions);
-    a_lib.close();
+    ConduitNodeData request = m_scheduler.pop();
+    publish_load();
+    queue_lock.unlock();
+    fprintf(state_fp, "3,%.10lf,%d,%u\n", ams::wall_time(), request.m_task_id, request.m_ts);
+    trace_queue_wait(request);
+    bind_comm(request, comm);
+    if(fetch_mesh(request, comm))
+        timed_render(a_lib, request);
+    fprintf(state_fp, "0,%.10lf,%d,%u\n", ams::wall_time(), request.m_task_id, request.m_ts);
+}
 
-    /* Pop the top element */
-    pq.pop();
+bool DummyNode::fetch_mesh(ConduitNodeData& request, MPI_Comm comm) {
+    int ready = request.m_error.empty() ? 1 : 0;
+    if(request.m_pending) {
+        auto pending = std::move(request.m_pending);
+        ams::RequestResult<bool> result;
+        try {
+            pending->m_buffer = pending->m_pull();
+            request.m_mesh = ingest_mesh(*pending);
+            result.value() = true;
+        } catch(const std::exception& ex) {
+            result.success() = false;
+            result.error() = ex.what();
+            ready = 0;
+        }
+        /* The client's arrays are free from now on */
+        pending->m_respond(result);
+    }
+    int all_ready;
+    {
+        AMS_TRACE_SCOPE("MPI_Allreduce", "mpi");
+        ams::allreduce_yielding(&ready, &all_ready, 1, MPI_INT, MPI_MIN, comm);
+    }
+    return all_ready == 1;
+}
+
+void DummyNode::trace_queue_wait(const ConduitNodeData& request) {
+    auto& tracer = ams::Tracer::instance();
+    if(tracer.enabled())
+        tracer.complete("queue_wait", "queue", request.m_enqueue_time, tracer.now());
+}
+
+void DummyNode::render(ascent::Ascent& a_lib, const ConduitNodeData& request) {
+    {
+        AMS_TRACE_SCOPE("ascent_open", "ascent");
+        a_lib.open(request.open_opts());
+    }
+    {
+        AMS_TRACE_SCOPE("ascent_publish", "ascent");
+        a_lib.publish(request.mesh());
+    }
+    {
+        AMS_TRACE_SCOPE("ascent_execute", "ascent");
+        a_lib.execute(request.actions());
+    }
+    {
+        AMS_TRACE_SCOPE("ascent_close", "ascent");
+        a_lib.close();
+    }
 }
 
 /* Go through priority queue and execute all the pending requests one by one */
@@ -130,40 +221,121 @@ void DummyNode::ams_execute_pending_requests(thallium::engine& engine, size_t po
 
     FILE *fp;
     fp = fopen(filename, "a");
-
-    double start = MPI_Wtime();
-
-    while(pq.size() != 0) {
-        ams_execute_one_request(comm, a_lib, rank, size, fp);
-	if(rank == 0)
-            fflush(fp);
+    std::string state_filename = std::to_string(global_rank) + "_server_state.txt";
+    FILE *state_fp = fopen(state_filename.c_str(), "a");
+
+    double start = ams::wall_time();
+
+    std::lock_guard<thallium::mutex> lock(m_execute_mtx);
+    agree_scheduler_config(comm);
+    /* Every rank executes as many requests as the shortest queue holds,
+     * until one of them is empty */
+    while(true) {
+        uint64_t queued, drain;
+        {
+            std::lock_guard<thallium::mutex> queue_lock(m_queue_mtx);
+            queued = m_scheduler.size();
+        }
+        {
+            AMS_TRACE_SCOPE("MPI_Allreduce", "mpi");
+            ams::allreduce_yielding(&queued, &drain, 1, MPI_UINT64_T, MPI_MIN, comm);
+        }
+        if(drain == 0)
+            break;
+        for(uint64_t i = 0; i < drain; i++) {
+            ams_execute_one_request(comm, a_lib, rank, size, fp, state_fp);
+            if(rank == 0)
+                fflush(fp);
+        }
     }
 
-    double end = MPI_Wtime();
+    double end = ams::wall_time();
 
     if(rank == 0) {
         fprintf(fp, "Total server time for finishing pending requests: %lf\n", end-start);
     }
 
     fclose(fp);
+    fclose(state_fp);
     //engine.finalize();
 }
 
-ams::RequestResult<bool> DummyNode::ams_open_publish_execute(std::string open_opts, std::string bp_mesh, size_t mesh_size, std::string actions, unsigned int ts, size_t pool_size, MPI_Comm comm) {
-    conduit::Node n, n_mesh, n_opts;
+ams::RequestResult<bool> DummyNode::ams_open_publish_execute(std::string open_opts, ams::MeshData bp_mesh, size_t mesh_size, std::string actions, unsigned int ts, size_t pool_size) {
+    conduit::Node n, n_opts;
+    std::shared_ptr<conduit::Node> mesh;
+    std::string error = bp_mesh.m_error;
+
+    double arrival = ams::wall_time();
+    int task_id = -1;
+    if(error.empty()) {
+        try {
+            AMS_TRACE_SCOPE("parse", "ingest");
+            n_opts.parse(open_opts,"conduit_base64_json");
+            task_id = n_opts["task_id"].to_int();
+            n.parse(actions,"conduit_base64_json");
+            if(not bp_mesh.m_pull)
+                mesh = ingest_mesh(bp_mesh);
+        } catch(const std::exception& ex) {
+            error = ex.what();
+        }
+    }
+    ConduitNodeData c(conduit::Node(), n_opts, n, ts, task_id);
+    if(not error.empty())
+        return enqueue_failed(std::move(c), error, mesh_size, arrival, pool_size);
+    c.m_mesh = std::move(mesh);
+    bool held = not bp_mesh.m_pull;
+    if(not held)
+        c.m_pending = std::make_shared<ams::MeshData>(std::move(bp_mesh));
+    return enqueue(std::move(c), mesh_size, arrival, pool_size, held);
+}
 
-    int size;
-    int rank;
-    int global_rank;
-    int mode = std::stoi(std::string(getenv("AMS_SERVER_MODE")));
+std::shared_ptr<conduit::Node> DummyNode::ingest_mesh(const ams::MeshData& bp_mesh) {
+    /* The mesh is used in place: the receive buffer and the cached
+     * subtrees it refers to are released with it */
+    auto buffer = bp_mesh.m_buffer;
+    auto subtrees = std::make_shared<SubtreeCache::Held>();
+    std::shared_ptr<conduit::Node> mesh(new conduit::Node(),
+            [buffer, subtrees](conduit::Node* n) { delete n; });
+    if(buffer)
+        mesh->set_external(conduit::Schema(bp_mesh.m_schema), buffer.get());
+    else
+        mesh->parse(bp_mesh.m_serialized,"conduit_base64_json");
+    {
+        AMS_TRACE_SCOPE("decode_fields", "ingest");
+        ams::decode_fields(*mesh);
+    }
+    /* Cached subtrees count against the scheduler's memory limit,
+     * including those stored or dropped before a resolution failed */
+    std::lock_guard<thallium::mutex> lock(m_state_mtx);
+    size_t cached = m_subtree_cache.bytes();
+    auto account = [this, cached]() {
+        std::lock_guard<thallium::mutex> queue_lock(m_queue_mtx);
+        if(m_subtree_cache.bytes() > cached)
+            m_scheduler.retain(m_subtree_cache.bytes() - cached);
+        else
+            m_scheduler.release(cached - m_subtree_cache.bytes());
+    };
+    try {
+        m_subtree_cache.resolve(*mesh, *subtrees);
+    } catch(...) {
+        account();
+        throw;
+    }
+    account();
+    return mesh;
+}
 
+ams::RequestResult<bool> DummyNode::enqueue_failed(ConduitNodeData&& request, const std::string& error, size_t mesh_size, double arrival, size_t pool_size) {
+    request.m_error = error;
+    enqueue(std::move(request), mesh_size, arrival, pool_size, false);
     ams::RequestResult<bool> result;
-    result.value() = true;
+    result.success() = false;
+    result.error() = error;
+    return result;
+}
 
-    MPI_Comm_rank(comm, &rank);
-    MPI_Comm_rank(MPI_COMM_WORLD, &global_rank);
-    MPI_Comm_size(comm, &size);
-    std::ofstream myfile;
+ams::RequestResult<bool> DummyNode::enqueue(ConduitNodeData&& request, size_t mesh_size, double arrival, size_t pool_size, bool held) {
+    int global_rank = m_global_rank;
 
     FILE *fp, *fp_pq, *fp_argoq, *fp_memq;
 
@@ -182,94 +354,419 @@ ams::RequestResult<bool> DummyNode::ams_open_publish_execute(std::string open_op
     fp_argoq = fopen(argoq_size, "a");
     fp_memq = fopen(memq_size, "a");
 
-    double start = MPI_Wtime();
-    fprintf(fp, "1,%.10lf\n", MPI_Wtime());
+    /* Records are "<code>,<time>,<task_id>,<ts>": 1 arrival, 2 queued,
+     * 3 execution start, 0 execution end */
+    fprintf(fp, "1,%.10lf,%d,%u\n", arrival, request.m_task_id, request.m_ts);
+    fprintf(fp, "2,%.10lf,%d,%u\n", ams::wall_time(), request.m_task_id, request.m_ts);
+
+    if(ams::Tracer::instance().enabled())
+        request.m_enqueue_time = ams::Tracer::instance().now();
+    unsigned int ts = request.m_ts;
+    size_t queued;
+    {
+        std::lock_guard<thallium::mutex> queue_lock(m_queue_mtx);
+        m_scheduler.push(std::move(request), ts, mesh_size, held);
+        publish_load();
+        queued = m_scheduler.size();
+    }
 
-    ascent::Ascent a_lib;
-    n.parse(actions,"conduit_base64_json");
-    n_mesh.parse(bp_mesh,"conduit_base64_json");
-    n_opts.parse(open_opts,"conduit_base64_json");
-    n_opts["mpi_comm"] = MPI_Comm_c2f(comm);
+    fprintf(fp_pq, "%.10lf\n", (double)queued);
+    fprintf(fp_argoq, "%.10lf\n", (double)pool_size);
+    fprintf(fp_memq, "%.10lf\n", (double)calculate_percent_memory_util());
 
-    fprintf(fp, "2,%.10lf\n", MPI_Wtime());
+    fclose(fp);
+    fclose(fp_pq);
+    fclose(fp_argoq);
+    fclose(fp_memq);
 
-    /* Checking if all my peers are working on the same request. If not, skip! */
-    int task_id = n_opts["task_id"].to_int();
-    ConduitNodeData c(n_mesh, n_opts, n, ts, task_id);
-    pq.push(c);
+    ams::RequestResult<bool> result;
+    result.value() = true;
+    return result;
+}
 
-    fprintf(fp_pq, "%.10lf\n", (double)pq.size());
-    fprintf(fp_argoq, "%.10lf\n", (double)pool_size);
-    fprintf(fp_memq, "%.10lf\n", (double)calculate_percent_memory_util());
+void DummyNode::ams_schedule(size_t pool_size, MPI_Comm comm) {
+    int size;
+    int rank;
+    int global_rank;
 
-    if(mode == LAZY) {
-        fclose(fp);
-        fclose(fp_pq);
-        fclose(fp_argoq);
-        fclose(fp_memq);
-        return result;
-    }
+    std::lock_guard<thallium::mutex> lock(m_execute_mtx);
+    /* The ranks decide whether to execute with the same settings */
+    agree_scheduler_config(comm);
+    /* Held until the request is popped, so that the head the ranks
+     * agree on is the one popped */
+    std::unique_lock<thallium::mutex> queue_lock(m_queue_mtx);
+    ams::SchedulerConfig config = m_scheduler.config();
+
+    if(config.mode == ams::ServerMode::LAZY)
+        return;
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_rank(MPI_COMM_WORLD, &global_rank);
+    MPI_Comm_size(comm, &size);
+
+    double start = ams::wall_time();
+    ascent::Ascent a_lib;
 
     /* Check if there are too many pending requests to respond to. If so, I just return. If not, proceed with ascent computation */
-    if(mode == LAZYISH) {
+    if(config.mode == ams::ServerMode::LAZYISH) {
         int execute_ascent = 0;
-        if(rank == 0 and pool_size < 5) { /* 5 is chosen as some arbitrary number */
+        if(rank == 0 and m_scheduler.shouldExecute(pool_size)) {
 	    execute_ascent = 1;
         }
 
-        MPI_Bcast(&execute_ascent, 1, MPI_INT, 0, comm);
-        if(execute_ascent == 0) {
-            fclose(fp);
-            fclose(fp_pq);
-            fclose(fp_argoq);
-            fclose(fp_memq);
-            return result;
+        {
+            AMS_TRACE_SCOPE("MPI_Bcast", "mpi");
+            ams::bcast_yielding(&execute_ascent, 1, MPI_INT, 0, comm);
         }
+        if(execute_ascent == 0)
+            return;
     }
 
-    /* Execute the code below if there is not much work in the Argobots pending queue */
-    int top_task_id = (pq.top()).m_task_id;
-   
-    /* Make sure that are all on the same page regarding which client's request we are executing. */ 
-    int recv;
-    MPI_Allreduce(&top_task_id, &recv, 1, MPI_INT, MPI_SUM, comm);
-    if(recv != top_task_id*size) {
+    /* Execute the code below if there is not much work in the Argobots pending queue.
+     * Make sure that are all on the same page regarding which client's request
+     * (task and timestep) we are executing. Requests that failed on some rank
+     * are queued anyway, see enqueue_failed. */
+    bool agreed = same_head(m_scheduler, comm);
+    if(m_scheduler.empty() || not agreed) {
         if(rank == 0)
-            std::cerr << "Skipping this request. Size of pq: " << pq.size() << " and size of ABT pool: " << pool_size << std::endl;
-        return result;
+            std::cerr << "Skipping this request. Size of pq: " << m_scheduler.size() << " and size of ABT pool: " << pool_size << std::endl;
+        return;
     } else {
 	if(rank == 0) {
-            std::cerr << "Request is valid. Size of pq: " << pq.size() << " and size of ABT pool: " << pool_size << std::endl;
+            std::cerr << "Request is valid. Size of pq: " << m_scheduler.size() << " and size of ABT pool: " << pool_size << std::endl;
 	}
     }
 
-    fprintf(fp, "3,%.10lf\n", MPI_Wtime());
+    std::string filename_cpp = std::to_string(global_rank) + "_server_state.txt";
+    FILE *fp = fopen(filename_cpp.c_str(), "a");
+
+    /* Perform the ascent viz as a single, atomic operation within the context of the RPC */
+    ConduitNodeData request = m_scheduler.pop();
+    publish_load();
+    queue_lock.unlock();
+
+    fprintf(fp, "3,%.10lf,%d,%u\n", ams::wall_time(), request.m_task_id, request.m_ts);
 
     symbiomon_metric_update(this->m_server_state, (double)1.0);
 
-    /* Perform the ascent viz as a single, atomic operation within the context of the RPC */
-    a_lib.open((pq.top()).m_open_opts);
-    a_lib.publish((pq.top()).m_data);
-    a_lib.execute((pq.top()).m_actions);
-    a_lib.close();
+    trace_queue_wait(request);
+    bind_comm(request, comm);
+    if(fetch_mesh(request, comm))
+        timed_render(a_lib, request);
 
     symbiomon_metric_update(this->m_server_state, (double)0.0);
 
-    fprintf(fp, "0,%.10lf\n", MPI_Wtime());
+    fprintf(fp, "0,%.10lf,%d,%u\n", ams::wall_time(), request.m_task_id, request.m_ts);
 
-    /* Pop the top element */
-    pq.pop();
-
-    double end = MPI_Wtime();
+    double end = ams::wall_time();
 
     if(rank == 0)
         std::cerr << "Total server time for ascent call: " << end-start << std::endl;
 
     fclose(fp);
-    fclose(fp_pq);
-    fclose(fp_argoq);
-    fclose(fp_memq);
+}
 
+void DummyNode::configure_scheduler() {
+    ams::SchedulerConfig config = m_scheduler.config();
+    config.memory_limit = m_config.value("memory_limit", (size_t)0);
+    m_scheduler.setConfig(config);
+    m_subtree_cache.setCapacity(m_config.value("subtree_cache_size", m_subtree_cache.capacity()));
+    m_subtree_cache.setMaxClients(m_config.value("subtree_cache_clients", m_subtree_cache.maxClients()));
+}
+
+void DummyNode::configureScheduler(const json& settings) {
+    auto config = std::make_shared<ams::SchedulerConfig>();
+    config->memory_limit = m_config.value("memory_limit", (size_t)0);
+    if(settings.contains("mode"))
+        config->mode = ams::parse_server_mode(settings["mode"].get<std::string>());
+    if(settings.contains("policy"))
+        config->policy = ams::parse_queue_policy(settings["policy"].get<std::string>());
+    config->lazyish_threshold = settings.value("lazyish_threshold", config->lazyish_threshold);
+    config->memory_limit = settings.value("memory_limit", config->memory_limit);
+    std::lock_guard<std::mutex> lock(m_config_mtx);
+    m_pending_configs[++m_config_epoch] = std::move(config);
+}
+
+void DummyNode::publish_load() {
+    m_queued_requests = m_scheduler.size();
+    m_queued_bytes = m_scheduler.bytes();
+    /* Close to the point where the scheduler stops admitting requests */
+    size_t limit = m_scheduler.config().memory_limit;
+    m_memory_pressure = limit > 0 && m_scheduler.totalBytes() >= limit - limit / 10;
+}
+
+void DummyNode::timed_render(ascent::Ascent& a_lib, const ConduitNodeData& request) {
+    double start = ams::wall_time();
+    m_execution_start = start;
+    m_executing = true;
+    try {
+        render(a_lib, request);
+    } catch(...) {
+        m_executing = false;
+        throw;
+    }
+    m_executing = false;
+    /* Only this function writes the average, requests are rendered one at a time */
+    double elapsed = ams::wall_time() - start;
+    double average = m_render_seconds;
+    m_render_seconds = average == 0.0 ? elapsed : 0.8 * average + 0.2 * elapsed;
+}
+
+ams::ServerLoad DummyNode::load() const {
+    ams::ServerLoad load;
+    load.queued_requests = m_queued_requests;
+    load.queued_bytes = m_queued_bytes;
+    load.executing = m_executing;
+    load.memory_pressure = m_memory_pressure;
+    double average = m_render_seconds;
+    load.eta = load.queued_requests * average;
+    if(load.executing)
+        load.eta += std::max(0.0, average - (ams::wall_time() - m_execution_start));
+    return load;
+}
+
+void DummyNode::agree_scheduler_config(MPI_Comm comm) {
+    uint64_t received, agreed;
+    {
+        std::lock_guard<std::mutex> lock(m_config_mtx);
+        received = m_config_epoch;
+    }
+    {
+        AMS_TRACE_SCOPE("MPI_Allreduce", "mpi");
+        ams::allreduce_yielding(&received, &agreed, 1, MPI_UINT64_T, MPI_MIN, comm);
+    }
+    std::shared_ptr<const ams::SchedulerConfig> config;
+    {
+        std::lock_guard<std::mutex> lock(m_config_mtx);
+        auto end = m_pending_configs.upper_bound(agreed);
+        if(end == m_pending_configs.begin())
+            return;
+        config = std::prev(end)->second;
+        m_pending_configs.erase(m_pending_configs.begin(), end);
+    }
+    std::lock_guard<thallium::mutex> queue_lock(m_queue_mtx);
+    m_scheduler.setConfig(*config);
+    publish_load();
+}
+
+ams::RequestResult<uint64_t> DummyNode::ams_create_mesh(ams::MeshData bp_mesh, size_t mesh_size) {
+    ams::RequestResult<uint64_t> result;
+
+    /* The bytes are reserved as they are admitted, and released when
+     * the mesh and the executions queued on it are gone */
+    {
+        std::lock_guard<thallium::mutex> queue_lock(m_queue_mtx);
+        if(not m_scheduler.admits(mesh_size)) {
+            result.success() = false;
+            result.error() = "Not enough memory to keep a mesh of " + std::to_string(mesh_size)
+                           + " bytes (" + std::to_string(m_scheduler.totalBytes()) + " of "
+                           + std::to_string(m_scheduler.config().memory_limit) + " bytes in use)";
+            return result;
+        }
+        m_scheduler.retain(mesh_size);
+        publish_load();
+    }
+
+    std::shared_ptr<conduit::Node> mesh;
+    try {
+        AMS_TRACE_SCOPE("parse", "ingest");
+        mesh = ingest_mesh(bp_mesh);
+    } catch(const std::exception& ex) {
+        release_resident(mesh_size);
+        result.success() = false;
+        result.error() = ex.what();
+        return result;
+    }
+
+    std::shared_ptr<const conduit::Node> resident(mesh.get(),
+            [this, mesh, mesh_size](const conduit::Node*) { release_resident(mesh_size); });
+    std::lock_guard<thallium::mutex> lock(m_state_mtx);
+    uint64_t mesh_id = m_next_mesh_id++;
+    m_meshes[mesh_id] = ResidentMesh{std::move(resident), mesh_size};
+
+    result.value() = mesh_id;
+    return result;
+}
+
+ams::RequestResult<bool> DummyNode::ams_execute_on_mesh(uint64_t mesh_id, std::string open_opts, std::string actions, unsigned int ts, size_t pool_size) {
+    conduit::Node n, n_opts;
+    std::string error;
+
+    double arrival = ams::wall_time();
+    /* The mesh is already accounted for as resident data, the
+     * request only holds its options and actions */
+    size_t request_size = open_opts.size() + actions.size();
+    int task_id = -1;
+    try {
+        AMS_TRACE_SCOPE("parse", "ingest");
+        n_opts.parse(open_opts,"conduit_base64_json");
+        task_id = n_opts["task_id"].to_int();
+        n.parse(actions,"conduit_base64_json");
+    } catch(const std::exception& ex) {
+        error = ex.what();
+    }
+    /* Dropped outside the locks: it may be the last reference */
+    std::shared_ptr<const conduit::Node> resident;
+    if(error.empty()) {
+        std::lock_guard<thallium::mutex> lock(m_state_mtx);
+        auto it = m_meshes.find(mesh_id);
+        if(it == m_meshes.end())
+            error = "Mesh " + std::to_string(mesh_id) + " not found";
+        else
+            resident = it->second.m_mesh;
+    }
+    if(error.empty()) {
+        std::lock_guard<thallium::mutex> queue_lock(m_queue_mtx);
+        if(not m_scheduler.admits(request_size))
+            error = "Not enough memory to queue an execution on mesh " + std::to_string(mesh_id)
+                  + " (" + std::to_string(m_scheduler.totalBytes()) + " of "
+                  + std::to_string(m_scheduler.config().memory_limit) + " bytes in use)";
+    }
+
+    ConduitNodeData c(conduit::Node(), n_opts, n, ts, task_id);
+    if(not error.empty())
+        return enqueue_failed(std::move(c), error, request_size, arrival, pool_size);
+    c.m_mesh = std::move(resident);
+    return enqueue(std::move(c), request_size, arrival, pool_size);
+}
+
+ams::RequestResult<bool> DummyNode::ams_release_mesh(uint64_t mesh_id) {
+    ams::RequestResult<bool> result;
+    /* Its bytes are released when the last queued execution drops it,
+     * possibly here, outside the lock */
+    std::shared_ptr<const conduit::Node> released;
+    std::lock_guard<thallium::mutex> lock(m_state_mtx);
+    auto it = m_meshes.find(mesh_id);
+    if(it == m_meshes.end()) {
+        result.success() = false;
+        result.error() = "Mesh " + std::to_string(mesh_id) + " not found";
+        return result;
+    }
+    released = std::move(it->second.m_mesh);
+    m_meshes.erase(it);
+    return result;
+}
+
+void DummyNode::ams_release_subtrees(const std::string& client_id) {
+    std::lock_guard<thallium::mutex> lock(m_state_mtx);
+    size_t cached = m_subtree_cache.bytes();
+    m_subtree_cache.release(client_id);
+    release_resident(cached - m_subtree_cache.bytes());
+}
+
+void DummyNode::release_resident(size_t bytes) {
+    std::lock_guard<thallium::mutex> queue_lock(m_queue_mtx);
+    m_scheduler.release(bytes);
+    publish_load();
+}
+
+ams::RequestResult<uint64_t> DummyNode::ams_open_session(std::string open_opts) {
+    ams::RequestResult<uint64_t> result;
+    Session session;
+    try {
+        auto opts = std::make_shared<conduit::Node>();
+        opts->parse(open_opts,"conduit_base64_json");
+        session.m_task_id = (*opts)["task_id"].to_int();
+        session.m_open_opts = std::move(opts);
+    } catch(const std::exception& ex) {
+        result.success() = false;
+        result.error() = ex.what();
+        return result;
+    }
+
+    std::lock_guard<thallium::mutex> lock(m_state_mtx);
+    uint64_t session_id = m_next_session_id++;
+    m_sessions[session_id] = std::move(session);
+    result.value() = session_id;
+    return result;
+}
+
+ams::RequestResult<uint64_t> DummyNode::ams_register_pipeline(uint64_t session_id, std::string name, std::string actions) {
+    ams::RequestResult<uint64_t> result;
+    auto n = std::make_shared<conduit::Node>();
+    try {
+        n->parse(actions,"conduit_base64_json");
+    } catch(const std::exception& ex) {
+        result.success() = false;
+        result.error() = ex.what();
+        return result;
+    }
+
+    std::lock_guard<thallium::mutex> lock(m_state_mtx);
+    auto it = m_sessions.find(session_id);
+    if(it == m_sessions.end()) {
+        result.success() = false;
+        result.error() = "Session " + std::to_string(session_id) + " not found";
+        return result;
+    }
+    auto& session = it->second;
+
+    /* Requests already queued keep the actions they were queued with */
+    auto p = session.m_pipeline_ids.find(name);
+    if(p != session.m_pipeline_ids.end()) {
+        session.m_pipelines[p->second] = std::move(n);
+        result.value() = p->second;
+    } else {
+        uint64_t pipeline_id = session.m_pipelines.size();
+        session.m_pipelines.push_back(std::move(n));
+        session.m_pipeline_ids[name] = pipeline_id;
+        result.value() = pipeline_id;
+    }
+    return result;
+}
+
+ams::RequestResult<bool> DummyNode::ams_session_publish(uint64_t session_id, uint64_t pipeline_id, ams::MeshData bp_mesh, size_t mesh_size, unsigned int ts, size_t pool_size) {
+    std::shared_ptr<conduit::Node> mesh;
+    std::string error = bp_mesh.m_error;
+
+    double arrival = ams::wall_time();
+    /* What the request needs from its session, which may be modified
+     * or closed while the mesh is ingested */
+    int task_id = -1;
+    std::shared_ptr<const conduit::Node> session_open_opts, session_actions;
+    {
+        std::lock_guard<thallium::mutex> lock(m_state_mtx);
+        auto it = m_sessions.find(session_id);
+        if(it != m_sessions.end()) {
+            task_id = it->second.m_task_id;
+            session_open_opts = it->second.m_open_opts;
+            if(pipeline_id < it->second.m_pipelines.size())
+                session_actions = it->second.m_pipelines[pipeline_id];
+        }
+    }
+    if(error.empty() && not session_open_opts)
+        error = "Session " + std::to_string(session_id) + " not found";
+    if(error.empty() && not session_actions)
+        error = "Pipeline " + std::to_string(pipeline_id) + " not found in session "
+              + std::to_string(session_id);
+    bool held = not bp_mesh.m_pull;
+    if(error.empty() && held) {
+        try {
+            AMS_TRACE_SCOPE("parse", "ingest");
+            mesh = ingest_mesh(bp_mesh);
+        } catch(const std::exception& ex) {
+            error = ex.what();
+        }
+    }
+    ConduitNodeData c(conduit::Node(), conduit::Node(), conduit::Node(), ts, task_id);
+    if(not error.empty())
+        return enqueue_failed(std::move(c), error, mesh_size, arrival, pool_size);
+
+    c.m_mesh = std::move(mesh);
+    if(not held)
+        c.m_pending = std::make_shared<ams::MeshData>(std::move(bp_mesh));
+    c.m_session_open_opts = std::move(session_open_opts);
+    c.m_session_actions = std::move(session_actions);
+    return enqueue(std::move(c), mesh_size, arrival, pool_size, held);
+}
+
+ams::RequestResult<bool> DummyNode::ams_close_session(uint64_t session_id) {
+    ams::RequestResult<bool> result;
+    std::lock_guard<thallium::mutex> lock(m_state_mtx);
+    if(m_sessions.erase(session_id) == 0) {
+        result.success() = false;
+        result.error() = "Session " + std::to_string(session_id) + " not found";
+    }
     return result;
 }
 
@@ -7,8 +7,15 @@
 #define __DUMMY_BACKEND_HPP
 
 #include <ams/Backend.hpp>
+#include <ams/Scheduler.hpp>
+#include "SubtreeCache.hpp"
 #include <ascent/ascent.hpp>
-#include <queue> 
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 using json = nlohmann::json;
 
@@ -26,6 +33,12 @@ class ConduitNodeData {
     int m_task_id;
 
     unsigned int m_ts;
+    double m_enqueue_time = 0.0; /* Tracer time at which the request was queued */
+    std::shared_ptr<const conduit::Node> m_mesh; /* set if m_data is unused (received or resident mesh) */
+    std::shared_ptr<const conduit::Node> m_session_open_opts; /* set if m_open_opts is unused */
+    std::shared_ptr<const conduit::Node> m_session_actions;   /* set if m_actions is unused */
+    std::shared_ptr<ams::MeshData> m_pending; /* set if the mesh is still on the client */
+    std::string m_error; /* set if the request failed on this rank, see enqueue_failed */
     /**
      * @brief Constructor.
      */
@@ -60,26 +73,136 @@ class ConduitNodeData {
      * @brief Destructor.
      */
     virtual ~ConduitNodeData() = default;
-};
 
-class Compare
-{
-public:
-    bool operator() (ConduitNodeData const& a, ConduitNodeData const& b)
-    {
-        if(a.m_ts > b.m_ts)
-   	    return true;
-	else
-	    return false;
+    /**
+     * @brief Mesh to publish: the mesh received with the request
+     * or the resident mesh it refers to, if any, or m_data.
+     */
+    const conduit::Node& mesh() const {
+        return m_mesh ? *m_mesh : m_data;
+    }
+
+    /**
+     * @brief Open options: those of the session the request
+     * belongs to, if any, or those sent with the request.
+     */
+    const conduit::Node& open_opts() const {
+        return m_session_open_opts ? *m_session_open_opts : m_open_opts;
+    }
+
+    /**
+     * @brief Actions: those of the session pipeline the request
+     * refers to, if any, or those sent with the request.
+     */
+    const conduit::Node& actions() const {
+        return m_session_actions ? *m_session_actions : m_actions;
     }
 };
 
+/**
+ * Open options and action pipelines registered by a client, kept parsed.
+ */
+struct Session {
+    std::shared_ptr<const conduit::Node> m_open_opts;
+    int m_task_id;
+    std::vector<std::shared_ptr<const conduit::Node>> m_pipelines;
+    std::unordered_map<std::string, uint64_t> m_pipeline_ids;
+};
+
+/**
+ * A mesh kept in server memory by ams_create_mesh. The queued
+ * executions on the mesh share it, and its bytes are accounted as
+ * resident in the scheduler until the last of them drops it.
+ */
+struct ResidentMesh {
+    std::shared_ptr<const conduit::Node> m_mesh;
+    size_t m_bytes;
+};
 
 class DummyNode : public ams::Backend {
    
     json m_config;
     ascent::Ascent ascent_lib;
-    std::priority_queue <ConduitNodeData, std::vector<ConduitNodeData>, Compare> pq;
+    ams::Scheduler<ConduitNodeData> m_scheduler;
+    std::unordered_map<uint64_t, ResidentMesh> m_meshes;
+    uint64_t m_next_mesh_id = 1;
+    std::unordered_map<uint64_t, Session> m_sessions;
+    uint64_t m_next_session_id = 1;
+    SubtreeCache m_subtree_cache;
+
+    /* Rank in MPI_COMM_WORLD, naming the state files. Read when the node
+     * is created, on the MPI proxy, so that handlers queuing requests on
+     * other execution streams do not call MPI */
+    int m_global_rank = 0;
+
+    /* Reads the scheduler and cache settings from the node configuration */
+    void configure_scheduler();
+
+    /* Settings given by configureScheduler, numbered in the order they
+     * were received (the epoch). Executions apply the latest settings
+     * every rank has received (see agree_scheduler_config), so that the
+     * ranks take the same decisions. Guarded by m_config_mtx, which is
+     * never held while yielding. */
+    std::map<uint64_t, std::shared_ptr<const ams::SchedulerConfig>> m_pending_configs;
+    uint64_t   m_config_epoch = 0;
+    std::mutex m_config_mtx;
+
+    /* Collective: applies the settings of the lowest epoch received by
+     * the ranks of comm. Called by executions, holding m_execute_mtx */
+    void agree_scheduler_config(MPI_Comm comm);
+
+    /* Copy of the scheduler's queue length and size, and whether its
+     * memory limit is nearly reached, readable by load() while handlers
+     * modify the queue; updated by publish_load */
+    std::atomic<uint64_t> m_queued_requests{0};
+    std::atomic<uint64_t> m_queued_bytes{0};
+    std::atomic<bool>     m_memory_pressure{false};
+    void publish_load();
+
+    /* Whether a request is being rendered, since when (steady clock
+     * seconds), and a moving average of the rendering times, used by
+     * load() to estimate the time needed to drain the queue */
+    std::atomic<bool>   m_executing{false};
+    std::atomic<double> m_execution_start{0.0};
+    std::atomic<double> m_render_seconds{0.0};
+
+    /* Stops accounting for the bytes of a resident mesh no longer
+     * referenced, or of released cached subtrees */
+    void release_resident(size_t bytes);
+
+    /* Calls render, recording its duration */
+    void timed_render(ascent::Ascent& a_lib, const ConduitNodeData& request);
+
+    /* Builds a received mesh, decoding its fields and resolving its cached subtrees */
+    std::shared_ptr<conduit::Node> ingest_mesh(const ams::MeshData& bp_mesh);
+
+    /* Queues a parsed request */
+    ams::RequestResult<bool> enqueue(ConduitNodeData&& request, size_t mesh_size, double arrival, size_t pool_size, bool held = true);
+
+    /* Queues a request that failed on this rank and returns the error.
+     * Every call of a queuing handler queues exactly one request, so
+     * that the ranks pop the same requests; they skip this one together
+     * (see fetch_mesh). mesh_size orders it like its peers. */
+    ams::RequestResult<bool> enqueue_failed(ConduitNodeData&& request, const std::string& error, size_t mesh_size, double arrival, size_t pool_size);
+
+    /* Pulls and ingests the mesh of a late-bound request, answering its
+     * client, and returns whether every rank has its mesh to render */
+    bool fetch_mesh(ConduitNodeData& request, MPI_Comm comm);
+
+    /* Serializes executions, whose collectives and pulls yield to other handlers */
+    thallium::mutex m_execute_mtx;
+
+    /* Guard the node's state against handlers running on several
+     * execution streams (see the provider's pools). m_queue_mtx guards
+     * the scheduler (queue, accounted bytes and settings); executions
+     * hold it from the ranks' agreement on the head of their queues to
+     * its pop, which yields in between, so that requests queued
+     * meanwhile cannot replace it. m_state_mtx guards the resident
+     * meshes, the sessions and the subtree cache, and is taken first
+     * when both are held. Neither is held when dropping a resident
+     * mesh, which releases its bytes (see release_resident). */
+    thallium::mutex m_queue_mtx;
+    thallium::mutex m_state_mtx;
 
     public:
 
@@ -110,6 +233,8 @@ class DummyNode : public ams::Backend {
             symbiomon_metric_create("ams", "server_state", SYMBIOMON_TYPE_GAUGE, "ams:server_state", m_taglist, &m_server_state, m_metric_provider);
             fprintf(stderr, "Metric created successfully!!\n");
         }
+        MPI_Comm_rank(MPI_COMM_WORLD, &m_global_rank);
+        configure_scheduler();
     }
 
     /**
@@ -117,6 +242,8 @@ class DummyNode : public ams::Backend {
      */
     DummyNode(const json& config)
     : m_config(config) {
+        MPI_Comm_rank(MPI_COMM_WORLD, &m_global_rank);
+        configure_scheduler();
     }
 
     /**
@@ -142,7 +269,7 @@ class DummyNode : public ams::Backend {
     /**
      * @brief Destructor.
      */
-    virtual ~DummyNode() = default;
+    virtual ~DummyNode();
 
     /**
      * @brief Prints Hello World.
@@ -155,7 +282,17 @@ class DummyNode : public ams::Backend {
     void ams_execute_pending_requests(thallium::engine& engine, size_t pool_size, MPI_Comm comm) override;
 
     /* Helper function that executes one request */
-    void ams_execute_one_request(MPI_Comm comm, ascent::Ascent& a_lib, int rank, int size, FILE *fp);
+    void ams_execute_one_request(MPI_Comm comm, ascent::Ascent& a_lib, int rank, int size, FILE *fp, FILE *state_fp);
+
+    /**
+     * @brief Runs the Ascent open/publish/execute/close sequence for
+     * a dequeued request. Backends that reuse the DummyNode queueing
+     * and scheduling path (e.g. for benchmarking) override this.
+     */
+    virtual void render(ascent::Ascent& a_lib, const ConduitNodeData& request);
+
+    /* Records the time a request spent in the queue, if tracing is enabled */
+    void trace_queue_wait(const ConduitNodeData& request);
 
     /**
      * @brief Opens Ascent with a given set of actions.
@@ -185,7 +322,65 @@ class DummyNode : public ams::Backend {
     /**
      * @brief Publishes a mesh and executes a set of actions in Ascent.
      */
-    ams::RequestResult<bool> ams_open_publish_execute(std::string open_opts, std::string bp_mesh, size_t mesh_size, std::string actions, unsigned int ts, size_t pool_size, MPI_Comm comm) override;
+    ams::RequestResult<bool> ams_open_publish_execute(std::string open_opts, ams::MeshData bp_mesh, size_t mesh_size, std::string actions, unsigned int ts, size_t pool_size) override;
+
+    /**
+     * @brief Executes the request at the head of the queue, depending on the server mode.
+     */
+    void ams_schedule(size_t pool_size, MPI_Comm comm) override;
+
+    /**
+     * @brief Applies the provider's scheduling settings.
+     */
+    void configureScheduler(const json& settings) override;
+
+    /**
+     * @brief Returns the length and size of the queue, the estimated
+     * time to drain it, whether a request is being rendered and whether
+     * the memory limit is nearly reached.
+     * Reads atomics only: callable while a request is being handled.
+     */
+    ams::ServerLoad load() const override;
+
+    /**
+     * @brief Keeps a mesh in server memory.
+     */
+    ams::RequestResult<uint64_t> ams_create_mesh(ams::MeshData bp_mesh, size_t mesh_size) override;
+
+    /**
+     * @brief Queues the execution of a set of actions on a resident mesh.
+     */
+    ams::RequestResult<bool> ams_execute_on_mesh(uint64_t mesh_id, std::string open_opts, std::string actions, unsigned int ts, size_t pool_size) override;
+
+    /**
+     * @brief Releases a resident mesh.
+     */
+    ams::RequestResult<bool> ams_release_mesh(uint64_t mesh_id) override;
+
+    /**
+     * @brief Drops the subtrees cached for a client.
+     */
+    void ams_release_subtrees(const std::string& client_id) override;
+
+    /**
+     * @brief Opens a session.
+     */
+    ams::RequestResult<uint64_t> ams_open_session(std::string open_opts) override;
+
+    /**
+     * @brief Registers a named set of actions in a session.
+     */
+    ams::RequestResult<uint64_t> ams_register_pipeline(uint64_t session_id, std::string name, std::string actions) override;
+
+    /**
+     * @brief Queues a mesh to be rendered with the options and actions of a session.
+     */
+    ams::RequestResult<bool> ams_session_publish(uint64_t session_id, uint64_t pipeline_id, ams::MeshData bp_mesh, size_t mesh_size, unsigned int ts, size_t pool_size) override;
+
+    /**
+     * @brief Closes a session.
+     */
+    ams::RequestResult<bool> ams_close_session(uint64_t session_id) override;
 
     /**
      * @brief Compute the sum of two integers.
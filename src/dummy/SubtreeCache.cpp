@@ -0,0 +1,109 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include "SubtreeCache.hpp"
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+
+void SubtreeCache::resolve(conduit::Node& mesh, Held& held) {
+    std::lock_guard<thallium::mutex> lock(m_mtx);
+    visit(mesh, held);
+}
+
+void SubtreeCache::visit(conduit::Node& node, Held& held) {
+    if(not node.dtype().is_object() && not node.dtype().is_list())
+        return;
+    if(node.dtype().is_object() && node.has_child("ams_ref")) {
+        drop(node);
+        fetch(node["ams_ref"].as_string(), node, held);
+        return;
+    }
+    if(node.dtype().is_object() && node.has_child("ams_hash")) {
+        drop(node);
+        std::string key = node["ams_hash"].as_string();
+        node.remove("ams_hash");
+        store(key, node);
+        return;
+    }
+    for(conduit::index_t i = 0; i < node.number_of_children(); i++)
+        visit(node.child(i), held);
+}
+
+void SubtreeCache::release(const std::string& client_id) {
+    std::lock_guard<thallium::mutex> lock(m_mtx);
+    auto it = m_clients.find(client_id);
+    if(it != m_clients.end())
+        erase_client(it);
+}
+
+void SubtreeCache::erase_client(std::unordered_map<std::string, ClientCache>::iterator it) {
+    m_bytes -= it->second.m_bytes;
+    m_clients.erase(it);
+}
+
+SubtreeCache::ClientCache* SubtreeCache::find_client(const std::string& key) {
+    auto it = m_clients.find(key.substr(0, key.rfind('/')));
+    if(it == m_clients.end()) return nullptr;
+    it->second.m_last_use = ++m_uses;
+    return &it->second;
+}
+
+/* Adds a client if needed, making room by dropping the subtrees of
+ * the least recently used one */
+SubtreeCache::ClientCache& SubtreeCache::client_of(const std::string& key) {
+    if(ClientCache* client = find_client(key))
+        return *client;
+    while(not m_clients.empty() && m_clients.size() >= std::max(m_max_clients, (size_t)1)) {
+        auto oldest = m_clients.begin();
+        for(auto it = m_clients.begin(); it != m_clients.end(); ++it)
+            if(it->second.m_last_use < oldest->second.m_last_use) oldest = it;
+        erase_client(oldest);
+    }
+    ClientCache& client = m_clients[key.substr(0, key.rfind('/'))];
+    client.m_last_use = ++m_uses;
+    return client;
+}
+
+/* Requests already holding a dropped subtree keep it until they are done */
+void SubtreeCache::drop(conduit::Node& node) {
+    if(not node.has_child("ams_drop"))
+        return;
+    conduit::Node& keys = node["ams_drop"];
+    for(conduit::index_t i = 0; i < keys.number_of_children(); i++) {
+        std::string key = keys.child(i).as_string();
+        ClientCache* client = find_client(key);
+        if(not client) continue;
+        auto it = client->m_entries.find(key);
+        if(it == client->m_entries.end()) continue;
+        size_t size = it->second->total_bytes_compact();
+        client->m_bytes -= size;
+        m_bytes -= size;
+        client->m_entries.erase(it);
+    }
+    node.remove("ams_drop");
+}
+
+void SubtreeCache::store(const std::string& key, conduit::Node& subtree) {
+    ClientCache& client = client_of(key);
+    if(client.m_entries.count(key)) return;
+    size_t size = subtree.total_bytes_compact();
+    if(client.m_bytes + size > m_capacity) return;
+    auto copy = std::make_shared<conduit::Node>();
+    subtree.compact_to(*copy);
+    client.m_entries[key] = copy;
+    client.m_bytes += size;
+    m_bytes += size;
+}
+
+void SubtreeCache::fetch(const std::string& key, conduit::Node& subtree, Held& held) {
+    ClientCache* client = find_client(key);
+    if(not client || client->m_entries.count(key) == 0)
+        throw std::runtime_error("Unknown subtree reference " + key);
+    /* Stored copies are only read, by every request referring to them */
+    const auto& stored = client->m_entries.at(key);
+    held.push_back(stored);
+    subtree.set_external(const_cast<conduit::Node&>(*stored));
+}
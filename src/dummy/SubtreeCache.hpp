@@ -0,0 +1,113 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __DUMMY_SUBTREE_CACHE_HPP
+#define __DUMMY_SUBTREE_CACHE_HPP
+
+#include <conduit/conduit.hpp>
+#include <thallium.hpp>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Server side of the coordset/topology cache (see SubtreeRefs on the
+ * client side). Subtrees of an incoming mesh carrying an "ams_hash"
+ * marker are stored, subtrees reduced to an "ams_ref" marker are
+ * replaced by the stored copy. The first marker of a mesh may carry an
+ * "ams_drop" list of subtrees to forget.
+ *
+ * Eviction is driven by the client, which only asks for a subtree to
+ * be dropped once none of its requests in flight refers to it, so the
+ * cache never drops a subtree on its own. Each client may store up to
+ * a number of bytes; subtrees beyond it are not stored. A client's
+ * subtrees are all dropped when it releases them (its NodeHandle is
+ * destroyed), or when a new client would exceed the number of clients
+ * kept, in which case the least recently used client loses them and
+ * sends them again after an "Unknown subtree reference" error.
+ */
+class SubtreeCache {
+
+    public:
+
+    using Held = std::vector<std::shared_ptr<const conduit::Node>>;
+
+    /**
+     * @brief Sets the number of bytes kept per client.
+     */
+    void setCapacity(size_t capacity) {
+        m_capacity = capacity;
+    }
+
+    size_t capacity() const {
+        return m_capacity;
+    }
+
+    /**
+     * @brief Sets the number of clients whose subtrees are kept.
+     */
+    void setMaxClients(size_t max_clients) {
+        m_max_clients = max_clients;
+    }
+
+    size_t maxClients() const {
+        return m_max_clients;
+    }
+
+    /**
+     * @brief Number of clients having subtrees stored.
+     */
+    size_t clients() const {
+        return m_clients.size();
+    }
+
+    /**
+     * @brief Total size of the stored subtrees.
+     */
+    size_t bytes() const {
+        return m_bytes;
+    }
+
+    /**
+     * @brief Drops the subtrees listed by a mesh, stores its marked
+     * subtrees and resolves its references. Resolved references point
+     * to the stored copies, which are added to held: the mesh must keep
+     * them until it is freed. Throws std::runtime_error if a reference
+     * is not in the cache.
+     */
+    void resolve(conduit::Node& mesh, Held& held);
+
+    /**
+     * @brief Drops every subtree of a client. The requests holding
+     * them keep them until they are done.
+     */
+    void release(const std::string& client_id);
+
+    private:
+
+    struct ClientCache {
+        std::unordered_map<std::string, std::shared_ptr<const conduit::Node>> m_entries;
+        size_t   m_bytes    = 0;
+        uint64_t m_last_use = 0;
+    };
+
+    void visit(conduit::Node& node, Held& held);
+    void drop(conduit::Node& node);
+    void store(const std::string& key, conduit::Node& subtree);
+    void fetch(const std::string& key, conduit::Node& subtree, Held& held);
+    ClientCache* find_client(const std::string& key);
+    ClientCache& client_of(const std::string& key);
+    void erase_client(std::unordered_map<std::string, ClientCache>::iterator it);
+
+    thallium::mutex m_mtx;
+    size_t    m_capacity    = 64 * 1024 * 1024;
+    size_t    m_max_clients = 64;
+    size_t    m_bytes       = 0;
+    uint64_t  m_uses        = 0;
+    std::unordered_map<std::string, ClientCache> m_clients;
+};
+
+#endif
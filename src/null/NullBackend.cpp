@@ -0,0 +1,64 @@
+/*
+ * (C) 2020 The University of Chicago
+ * 
+ * See COPYRIGHT in top-level directory.
+ */
+#include "NullBackend.hpp"
+
+AMS_REGISTER_BACKEND(null, NullNode);
+
+ams::RequestResult<bool> NullNode::ams_open(std::string opts) {
+    (void)opts;
+    ams::RequestResult<bool> result;
+    result.value() = true;
+    return result;
+}
+
+ams::RequestResult<bool> NullNode::ams_close() {
+    ams::RequestResult<bool> result;
+    result.value() = true;
+    return result;
+}
+
+ams::RequestResult<bool> NullNode::ams_publish(std::string bp_mesh) {
+    conduit::Node n;
+    n.parse(bp_mesh,"conduit_json");
+
+    ams::RequestResult<bool> result;
+    result.value() = true;
+    return result;
+}
+
+ams::RequestResult<bool> NullNode::ams_execute(std::string actions) {
+    conduit::Node n;
+    n.parse(actions,"conduit_json");
+
+    ams::RequestResult<bool> result;
+    result.value() = true;
+    return result;
+}
+
+ams::RequestResult<bool> NullNode::ams_publish_and_execute(std::string bp_mesh, std::string actions) {
+    conduit::Node n, n_mesh;
+
+    n.parse(actions,"conduit_json");
+    n_mesh.parse(bp_mesh,"conduit_json");
+
+    ams::RequestResult<bool> result;
+    result.value() = true;
+    return result;
+}
+
+void NullNode::render(ascent::Ascent& a_lib, const ConduitNodeData& request) {
+    (void)a_lib;
+    (void)request;
+}
+
+std::unique_ptr<ams::Backend> NullNode::create(const thallium::engine& engine, const json& config) {
+    return std::unique_ptr<ams::Backend>(new NullNode(config, engine));
+}
+
+std::unique_ptr<ams::Backend> NullNode::open(const thallium::engine& engine, const json& config) {
+    (void)engine;
+    return std::unique_ptr<ams::Backend>(new NullNode(config));
+}
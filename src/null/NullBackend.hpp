@@ -0,0 +1,91 @@
+/*
+ * (C) 2020 The University of Chicago
+ * 
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __NULL_BACKEND_HPP
+#define __NULL_BACKEND_HPP
+
+#include "../dummy/DummyBackend.hpp"
+
+/**
+ * Null implementation of an ams Backend. Requests go through the
+ * same parsing, queueing and scheduling path as DummyNode, but the
+ * Ascent calls are skipped entirely. Useful to measure the overheads
+ * of the service itself.
+ */
+class NullNode : public DummyNode {
+
+    public:
+
+    /**
+     * @brief Constructor.
+     */
+    NullNode(const json& config, const thallium::engine& engine)
+    : DummyNode(config, engine) {}
+
+    /**
+     * @brief Constructor.
+     */
+    NullNode(const json& config)
+    : DummyNode(config) {}
+
+    /**
+     * @brief Destructor.
+     */
+    virtual ~NullNode() = default;
+
+    /**
+     * @brief Does nothing.
+     */
+    ams::RequestResult<bool> ams_open(std::string opts) override;
+
+    /**
+     * @brief Does nothing.
+     */
+    ams::RequestResult<bool> ams_close() override;
+
+    /**
+     * @brief Parses the mesh but does not publish it.
+     */
+    ams::RequestResult<bool> ams_publish(std::string bp_mesh) override;
+
+    /**
+     * @brief Parses the actions but does not execute them.
+     */
+    ams::RequestResult<bool> ams_execute(std::string actions) override;
+
+    /**
+     * @brief Parses the mesh and the actions but does not execute them.
+     */
+    ams::RequestResult<bool> ams_publish_and_execute(std::string bp_mesh, std::string actions) override;
+
+    /**
+     * @brief Skips the Ascent calls for a dequeued request.
+     */
+    void render(ascent::Ascent& a_lib, const ConduitNodeData& request) override;
+
+    /**
+     * @brief Static factory function used by the NodeFactory to
+     * create a NullNode.
+     *
+     * @param engine Thallium engine
+     * @param config JSON configuration for the node
+     *
+     * @return a unique_ptr to a node
+     */
+    static std::unique_ptr<ams::Backend> create(const thallium::engine& engine, const json& config);
+
+    /**
+     * @brief Static factory function used by the NodeFactory to
+     * open a NullNode.
+     *
+     * @param engine Thallium engine
+     * @param config JSON configuration for the node
+     *
+     * @return a unique_ptr to a node
+     */
+    static std::unique_ptr<ams::Backend> open(const thallium::engine& engine, const json& config);
+};
+
+#endif
@@ -0,0 +1,73 @@
+/*
+ * (C) 2020 The University of Chicago
+ * 
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <ams/ActionAnalysis.hpp>
+#include <conduit_blueprint.hpp>
+
+class ActionAnalysisTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( ActionAnalysisTest );
+    CPPUNIT_TEST( testQueries );
+    CPPUNIT_TEST( testPruning );
+    CPPUNIT_TEST( testFallback );
+    CPPUNIT_TEST_SUITE_END();
+
+    public:
+
+    void setUp() {}
+    void tearDown() {}
+
+    void testQueries() {
+        conduit::Node actions;
+        conduit::Node& add_act = actions.append();
+        add_act["action"] = "add_queries";
+        add_act["queries/q1/params/expression"] = "binning('radial','max', [axis('x',num_bins=20)])";
+        add_act["queries/q1/params/name"] = "1d_binning";
+
+        ams::FieldSelection selection = ams::analyze_actions(actions);
+        CPPUNIT_ASSERT(!selection.all);
+        CPPUNIT_ASSERT_EQUAL((size_t)1, selection.fields.count("radial"));
+        CPPUNIT_ASSERT_EQUAL((size_t)0, selection.fields.count("braid"));
+    }
+
+    void testPruning() {
+        conduit::Node mesh;
+        conduit::blueprint::mesh::examples::braid("hexs", 5, 5, 5, mesh);
+
+        conduit::Node actions;
+        conduit::Node& add_act = actions.append();
+        add_act["action"] = "add_scenes";
+        add_act["scenes/s1/plots/p1/type"] = "pseudocolor";
+        add_act["scenes/s1/plots/p1/field"] = "braid";
+
+        conduit::Node view;
+        CPPUNIT_ASSERT(ams::select_fields(mesh, ams::analyze_actions(actions), view));
+        CPPUNIT_ASSERT(view.has_path("fields/braid"));
+        CPPUNIT_ASSERT(!view.has_path("fields/radial"));
+        CPPUNIT_ASSERT(view.has_path("topologies/mesh"));
+        CPPUNIT_ASSERT(view.has_path("coordsets/coords"));
+        CPPUNIT_ASSERT_MESSAGE("the view should reference the mesh's data",
+                view["fields/braid/values"].data_ptr() == mesh["fields/braid/values"].data_ptr());
+    }
+
+    void testFallback() {
+        conduit::Node mesh;
+        conduit::blueprint::mesh::examples::braid("hexs", 5, 5, 5, mesh);
+
+        conduit::Node actions;
+        conduit::Node& add_act = actions.append();
+        add_act["action"] = "add_extracts";
+        add_act["extracts/e1/type"] = "relay";
+        add_act["extracts/e1/params/path"] = "out";
+
+        ams::FieldSelection selection = ams::analyze_actions(actions);
+        CPPUNIT_ASSERT_MESSAGE("extracts of whole meshes need every field", selection.all);
+
+        conduit::Node view;
+        CPPUNIT_ASSERT(!ams::select_fields(mesh, selection, view));
+    }
+};
+CPPUNIT_TEST_SUITE_REGISTRATION( ActionAnalysisTest );
@@ -13,6 +13,7 @@ class AdminTest : public CppUnit::TestFixture
 {
     CPPUNIT_TEST_SUITE( AdminTest );
     CPPUNIT_TEST( testAdminCreateNode );
+    CPPUNIT_TEST( testAdminUpdateConfig );
     CPPUNIT_TEST_SUITE_END();
 
     static constexpr const char* node_config = "{ \"path\" : \"mydb\" }";
@@ -46,5 +47,35 @@ class AdminTest : public CppUnit::TestFixture
             admin.destroyNode(addr, 0, bad_id),
             ams::Exception);
     }
+
+    void testAdminUpdateConfig() {
+        ams::Admin admin(engine);
+        std::string addr = engine.self();
+
+        std::string config;
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE("admin.updateConfig should accept a new server mode",
+                config = admin.updateConfig(addr, 0, "{ \"scheduler\" : { \"mode\" : \"lazy\" } }"));
+        auto json_config = nlohmann::json::parse(config);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("the new configuration should have the new server mode",
+                std::string("lazy"), json_config["scheduler"]["mode"].get<std::string>());
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("the new configuration should keep the default queue policy",
+                std::string("timestep"), json_config["scheduler"]["policy"].get<std::string>());
+
+        CPPUNIT_ASSERT_THROW_MESSAGE("admin.updateConfig should throw on an unknown server mode",
+                admin.updateConfig(addr, 0, "{ \"scheduler\" : { \"mode\" : \"blabla\" } }"),
+                ams::Exception);
+
+        CPPUNIT_ASSERT_THROW_MESSAGE("admin.updateConfig should throw when changing the pools",
+                admin.updateConfig(addr, 0, "{ \"pools\" : { \"ingest\" : \"blabla\" } }"),
+                ams::Exception);
+
+        CPPUNIT_ASSERT_THROW_MESSAGE("admin.updateConfig should throw on a negative threshold",
+                admin.updateConfig(addr, 0, "{ \"receive_buffers\" : { \"max_cached_bytes\" : 12345 },"
+                                            "  \"scheduler\" : { \"lazyish_threshold\" : -1 } }"),
+                ams::Exception);
+
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE("admin.updateConfig should restore the server mode",
+                admin.updateConfig(addr, 0, "{ \"scheduler\" : { \"mode\" : \"eager\" } }"));
+    }
 };
 CPPUNIT_TEST_SUITE_REGISTRATION( AdminTest );
@@ -0,0 +1,99 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include "BufferPool.hpp"
+
+extern thallium::engine engine;
+
+static const size_t KiB = 1024;
+static const size_t MiB = 1024 * 1024;
+
+class BufferPoolTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( BufferPoolTest );
+    CPPUNIT_TEST( testSizeClasses );
+    CPPUNIT_TEST( testReuse );
+    CPPUNIT_TEST( testMaxCachedBytes );
+    CPPUNIT_TEST_SUITE_END();
+
+    public:
+
+    void setUp() {}
+    void tearDown() {}
+
+    void testSizeClasses() {
+        auto pool = std::make_shared<ams::BufferPool>(engine);
+        pool->configure(0, false);
+
+        CPPUNIT_ASSERT_EQUAL(64 * KiB, pool->acquire(1)->m_capacity);
+        CPPUNIT_ASSERT_EQUAL(64 * KiB, pool->acquire(64 * KiB)->m_capacity);
+        CPPUNIT_ASSERT_EQUAL(80 * KiB, pool->acquire(64 * KiB + 1)->m_capacity);
+        CPPUNIT_ASSERT_EQUAL(7 * MiB, pool->acquire(7 * MiB)->m_capacity);
+        CPPUNIT_ASSERT_EQUAL(8 * MiB, pool->acquire(7 * MiB + 1)->m_capacity);
+
+        for(size_t size = 64 * KiB + 1; size < 64 * MiB; size = size * 9 / 8 + 1) {
+            size_t capacity = pool->acquire(size)->m_capacity;
+            CPPUNIT_ASSERT(capacity >= size);
+            CPPUNIT_ASSERT_MESSAGE("at most a quarter of a buffer should be wasted",
+                    (capacity - size) * 4 < capacity);
+        }
+    }
+
+    void testReuse() {
+        auto pool = std::make_shared<ams::BufferPool>(engine);
+
+        auto buffer = pool->acquire(8 * MiB);
+        char* data = buffer->m_data;
+        CPPUNIT_ASSERT_EQUAL((size_t)1, pool->allocations());
+        buffer.reset();
+        CPPUNIT_ASSERT_EQUAL(8 * MiB, pool->cachedBytes());
+
+        buffer = pool->acquire(8 * MiB);
+        CPPUNIT_ASSERT(data == buffer->m_data);
+        CPPUNIT_ASSERT_EQUAL((size_t)1, pool->allocations());
+        CPPUNIT_ASSERT_EQUAL((size_t)1, pool->reuses());
+        CPPUNIT_ASSERT_EQUAL((size_t)0, pool->cachedBytes());
+        buffer.reset();
+
+        buffer = pool->acquire(7 * MiB);
+        CPPUNIT_ASSERT_MESSAGE("a buffer of the next size class should be reused",
+                data == buffer->m_data);
+        CPPUNIT_ASSERT_EQUAL((size_t)2, pool->reuses());
+        buffer.reset();
+
+        buffer = pool->acquire(5 * MiB);
+        CPPUNIT_ASSERT_MESSAGE("buffers two size classes larger should not be reused",
+                data != buffer->m_data);
+        CPPUNIT_ASSERT_EQUAL((size_t)2, pool->allocations());
+        CPPUNIT_ASSERT_EQUAL((size_t)2, pool->reuses());
+        CPPUNIT_ASSERT_EQUAL(8 * MiB, pool->cachedBytes());
+        buffer.reset();
+        CPPUNIT_ASSERT_EQUAL(13 * MiB, pool->cachedBytes());
+    }
+
+    void testMaxCachedBytes() {
+        auto pool = std::make_shared<ams::BufferPool>(engine);
+        pool->configure(8 * MiB, false);
+
+        auto first  = pool->acquire(8 * MiB);
+        auto second = pool->acquire(8 * MiB);
+        first.reset();
+        second.reset();
+        CPPUNIT_ASSERT_MESSAGE("buffers beyond the limit should be freed",
+                pool->cachedBytes() == 8 * MiB);
+
+        first  = pool->acquire(8 * MiB);
+        second = pool->acquire(8 * MiB);
+        CPPUNIT_ASSERT_EQUAL((size_t)3, pool->allocations());
+        CPPUNIT_ASSERT_EQUAL((size_t)1, pool->reuses());
+
+        /* Buffers outliving the pool are freed by their last reference */
+        pool.reset();
+        first.reset();
+        second.reset();
+    }
+};
+CPPUNIT_TEST_SUITE_REGISTRATION( BufferPoolTest );
@@ -0,0 +1,66 @@
+/*
+ * (C) 2020 The University of Chicago
+ * 
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <ams/FieldCodec.hpp>
+#include <cmath>
+
+class FieldCodecTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( FieldCodecTest );
+    CPPUNIT_TEST( testRoundTrip );
+    CPPUNIT_TEST( testSmoothFieldCompresses );
+    CPPUNIT_TEST( testCorruptedInput );
+    CPPUNIT_TEST_SUITE_END();
+
+    public:
+
+    void setUp() {}
+    void tearDown() {}
+
+    void testRoundTrip() {
+        std::vector<double> values = { 0.0, -1.5, 3.25, 3.25, 3.25, 1e300, -0.0, 42.0 };
+        auto encoded = ams::compress_words(values.data(), values.size(), sizeof(double));
+        std::vector<double> decoded(values.size());
+        ams::decompress_words(encoded.data(), encoded.size(), decoded.data(), decoded.size(), sizeof(double));
+        for(size_t i = 0; i < values.size(); i++)
+            CPPUNIT_ASSERT_EQUAL_MESSAGE("values should be restored exactly",
+                    std::signbit(values[i]), std::signbit(decoded[i]));
+        CPPUNIT_ASSERT(values == decoded);
+
+        std::vector<int32_t> ints(1000);
+        for(size_t i = 0; i < ints.size(); i++) ints[i] = (int32_t)(i * 7919 % 1013);
+        auto encoded_ints = ams::compress_words(ints.data(), ints.size(), sizeof(int32_t));
+        std::vector<int32_t> decoded_ints(ints.size());
+        ams::decompress_words(encoded_ints.data(), encoded_ints.size(), decoded_ints.data(), decoded_ints.size(), sizeof(int32_t));
+        CPPUNIT_ASSERT(ints == decoded_ints);
+
+        auto empty = ams::compress_words(nullptr, 0, sizeof(float));
+        CPPUNIT_ASSERT(empty.empty());
+        CPPUNIT_ASSERT_NO_THROW(ams::decompress_words(empty.data(), 0, nullptr, 0, sizeof(float)));
+    }
+
+    void testSmoothFieldCompresses() {
+        std::vector<float> values(100000, 1.0f);
+        for(size_t i = 0; i < values.size(); i += 100) values[i] = 2.0f;
+        auto encoded = ams::compress_words(values.data(), values.size(), sizeof(float));
+        CPPUNIT_ASSERT_MESSAGE("a mostly constant field should compress well",
+                encoded.size() < values.size() * sizeof(float) / 10);
+    }
+
+    void testCorruptedInput() {
+        std::vector<double> values(64, 1.0);
+        auto encoded = ams::compress_words(values.data(), values.size(), sizeof(double));
+        std::vector<double> decoded(values.size() + 1);
+        CPPUNIT_ASSERT_THROW_MESSAGE("decoding to the wrong size should throw",
+                ams::decompress_words(encoded.data(), encoded.size(), decoded.data(), decoded.size(), sizeof(double)),
+                std::runtime_error);
+        encoded.resize(encoded.size() / 2);
+        CPPUNIT_ASSERT_THROW_MESSAGE("truncated input should throw",
+                ams::decompress_words(encoded.data(), encoded.size(), decoded.data(), values.size(), sizeof(double)),
+                std::runtime_error);
+    }
+};
+CPPUNIT_TEST_SUITE_REGISTRATION( FieldCodecTest );
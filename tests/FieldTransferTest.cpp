@@ -0,0 +1,82 @@
+/*
+ * (C) 2020 The University of Chicago
+ * 
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include "FieldTransfer.hpp"
+#include <conduit_blueprint.hpp>
+#include <cmath>
+
+class FieldTransferTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( FieldTransferTest );
+    CPPUNIT_TEST( testRoundTrip );
+    CPPUNIT_TEST( testNoOptions );
+    CPPUNIT_TEST_SUITE_END();
+
+    public:
+
+    void setUp() {}
+    void tearDown() {}
+
+    /* Sends the view the way small meshes are sent, and decodes it
+     * the way the server ingests it */
+    static conduit::Node transfer(const conduit::Node& view) {
+        conduit::Node received;
+        received.parse(view.to_string("conduit_base64_json"), "conduit_base64_json");
+        ams::decode_fields(received);
+        return received;
+    }
+
+    void testRoundTrip() {
+        conduit::Node mesh;
+        conduit::blueprint::mesh::examples::braid("hexs", 10, 10, 10, mesh);
+
+        ams::FieldTransfer transfer_options;
+        ams::FieldTransferOptions compress;
+        compress.compress = true;
+        compress.adaptive = false;
+        ams::FieldTransferOptions narrow = compress;
+        narrow.to_float32 = true;
+        transfer_options.m_options["braid"]  = compress;
+        transfer_options.m_options["radial"] = narrow;
+
+        conduit::Node view;
+        CPPUNIT_ASSERT(transfer_options.encode(mesh, view));
+        conduit::Node received = transfer(view);
+
+        conduit::Node info;
+        CPPUNIT_ASSERT_MESSAGE("the decoded mesh should be valid",
+                conduit::blueprint::mesh::verify(received, info));
+        CPPUNIT_ASSERT_MESSAGE("compressed values should be restored exactly",
+                !mesh["fields/braid/values"].diff(received["fields/braid/values"], info));
+        CPPUNIT_ASSERT_MESSAGE("fields without options should be sent as is",
+                !mesh["fields/vel"].diff(received["fields/vel"], info));
+        CPPUNIT_ASSERT_MESSAGE("coordsets should be sent as is",
+                !mesh["coordsets"].diff(received["coordsets"], info));
+
+        const conduit::Node& radial = received["fields/radial/values"];
+        CPPUNIT_ASSERT(radial.dtype().is_float32());
+        conduit::float64_array expected = mesh["fields/radial/values"].value();
+        conduit::float32_array decoded = radial.value();
+        CPPUNIT_ASSERT_EQUAL(expected.number_of_elements(), decoded.number_of_elements());
+        for(conduit::index_t i = 0; i < expected.number_of_elements(); i++)
+            CPPUNIT_ASSERT_EQUAL((float)expected[i], decoded[i]);
+    }
+
+    void testNoOptions() {
+        conduit::Node mesh;
+        conduit::blueprint::mesh::examples::braid("hexs", 5, 5, 5, mesh);
+
+        ams::FieldTransfer transfer_options;
+        conduit::Node view;
+        CPPUNIT_ASSERT(!transfer_options.encode(mesh, view));
+
+        conduit::Node received = transfer(mesh);
+        conduit::Node info;
+        CPPUNIT_ASSERT_MESSAGE("meshes without encoded fields should be left as is",
+                !mesh.diff(received, info));
+    }
+};
+CPPUNIT_TEST_SUITE_REGISTRATION( FieldTransferTest );
@@ -12,6 +12,7 @@
 #include <ams/Client.hpp>
 #include <ams/Admin.hpp>
 #include <ams/Provider.hpp>
+#include <mpi.h>
 
 namespace tl = thallium;
 
@@ -20,6 +21,10 @@ std::string node_type = "dummy";
 
 int main(int argc, char** argv) {
 
+    // The in-process provider renders on MPI_COMM_WORLD
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+
     // Get the top level suite from the registry    
     CppUnit::Test *suite = CppUnit::TestFactoryRegistry::getRegistry().makeTest();
 
@@ -56,6 +61,8 @@ int main(int argc, char** argv) {
     if(argc >= 2)
        xmlOutFile.close();
 
+    MPI_Finalize();
+
     // Return error code 1 if the one of test failed.
     return wasSucessful ? 0 : 1;
 }
@@ -6,6 +6,7 @@
 #include <cppunit/extensions/HelperMacros.h>
 #include <ams/Client.hpp>
 #include <ams/Admin.hpp>
+#include <conduit_blueprint.hpp>
 
 extern thallium::engine engine;
 extern std::string node_type;
@@ -16,9 +17,19 @@ class NodeTest : public CppUnit::TestFixture
     CPPUNIT_TEST( testMakeNodeHandle );
     CPPUNIT_TEST( testSayHello );
     CPPUNIT_TEST( testComputeSum );
+    CPPUNIT_TEST( testAsyncRequests );
+    CPPUNIT_TEST( testInFlightWindow );
+    CPPUNIT_TEST( testSubmitBlock );
+    CPPUNIT_TEST( testSubmitDrop );
+    CPPUNIT_TEST( testSubmitFallback );
+    CPPUNIT_TEST( testGetLoad );
+    CPPUNIT_TEST( testLoadHint );
+    CPPUNIT_TEST( testSessions );
     CPPUNIT_TEST_SUITE_END();
 
     static constexpr const char* node_config = "{ \"path\" : \"mydb\" }";
+    static constexpr const char* costmodel_config =
+        "{ \"path\" : \"mydb\", \"cost_model\" : { \"base_ms\" : 1.0 } }";
     ams::UUID node_id;
 
     public:
@@ -103,5 +114,227 @@ class NodeTest : public CppUnit::TestFixture
                 request.wait());
     }
 
+    void testAsyncRequests() {
+        ams::Client client(engine);
+        std::string addr = engine.self();
+
+        ams::NodeHandle my_node = client.makeNodeHandle(addr, 0, node_id);
+
+        std::vector<int32_t> results(4, 0);
+        std::vector<ams::AsyncRequest> requests(4);
+        for(int32_t i = 0; i < 4; i++) {
+            my_node.computeSum(i, 10, &results[i], &requests[i]);
+        }
+
+        size_t index = ams::AsyncRequest::wait_any(requests);
+        CPPUNIT_ASSERT_MESSAGE("wait_any should return a valid index", index < requests.size());
+        CPPUNIT_ASSERT_MESSAGE("the request returned by wait_any should have completed",
+                requests[index].test());
+        CPPUNIT_ASSERT_EQUAL((int32_t)index + 10, results[index]);
+
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "AsyncRequest::wait_all should not throw.",
+                ams::AsyncRequest::wait_all(requests));
+        for(int32_t i = 0; i < 4; i++) {
+            CPPUNIT_ASSERT_EQUAL(i + 10, results[i]);
+        }
+
+        CPPUNIT_ASSERT_EQUAL_MESSAGE(
+                "wait_any should return requests.size() when all requests are done",
+                requests.size(), ams::AsyncRequest::wait_any(requests));
+
+        ams::AsyncRequest hello;
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_node.sayHello() should not throw when called asynchronously.",
+                my_node.sayHello(&hello));
+        CPPUNIT_ASSERT_NO_THROW(hello.wait());
+    }
+
+    void testInFlightWindow() {
+        ams::Client client(engine);
+        std::string addr = engine.self();
+
+        ams::NodeHandle my_node = client.makeNodeHandle(addr, 0, node_id);
+
+        CPPUNIT_ASSERT_EQUAL((size_t)0, my_node.inFlight());
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "setInFlightWindow should throw for an empty window.",
+                my_node.setInFlightWindow(0),
+                ams::Exception);
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "setInFlightWindow should throw for FALLBACK without a function.",
+                my_node.setInFlightWindow(2, ams::WindowPolicy::FALLBACK),
+                ams::Exception);
+        CPPUNIT_ASSERT_NO_THROW(my_node.setInFlightWindow(3, ams::WindowPolicy::DROP));
+        CPPUNIT_ASSERT_NO_THROW(my_node.ams_flush());
+        CPPUNIT_ASSERT_EQUAL((size_t)0, my_node.inFlight());
+    }
+
+    /* Submits two timesteps through a window of one request and
+     * returns the status of the second submission. The handlers of
+     * the in-process server cannot run before this thread blocks, so
+     * the first request is still in flight at the second submission. */
+    ams::SubmitStatus submitPastWindow(ams::WindowPolicy policy, unsigned* fallbacks) {
+        ams::Admin admin(engine);
+        std::string addr = engine.self();
+        auto costmodel_id = admin.createNode(addr, 0, "costmodel", costmodel_config);
+
+        ams::SubmitStatus status;
+        {
+            ams::Client client(engine);
+            ams::NodeHandle my_node = client.makeNodeHandle(addr, 0, costmodel_id);
+            my_node.setInFlightWindow(1, policy,
+                [fallbacks](const conduit::Node&, const conduit::Node&, const conduit::Node&) {
+                    *fallbacks += 1;
+                });
+
+            conduit::Node open_opts, mesh, actions;
+            conduit::blueprint::mesh::examples::braid("uniform", 10, 10, 10, mesh);
+            actions.append()["action"] = "add_scenes";
+
+            CPPUNIT_ASSERT(my_node.ams_submit(open_opts, mesh, actions, 0) == ams::SubmitStatus::SENT);
+            CPPUNIT_ASSERT_EQUAL((size_t)1, my_node.inFlight());
+            status = my_node.ams_submit(open_opts, mesh, actions, 1);
+            CPPUNIT_ASSERT_MESSAGE(
+                    "the window should never hold more than one request.",
+                    my_node.inFlight() <= 1);
+            CPPUNIT_ASSERT_NO_THROW(my_node.ams_flush());
+            CPPUNIT_ASSERT_EQUAL((size_t)0, my_node.inFlight());
+        }
+
+        admin.destroyNode(addr, 0, costmodel_id);
+        return status;
+    }
+
+    void testSubmitBlock() {
+        unsigned fallbacks = 0;
+        CPPUNIT_ASSERT_MESSAGE(
+                "BLOCK should wait for the window and send the timestep.",
+                submitPastWindow(ams::WindowPolicy::BLOCK, &fallbacks) == ams::SubmitStatus::SENT);
+        CPPUNIT_ASSERT_EQUAL(0u, fallbacks);
+    }
+
+    void testSubmitDrop() {
+        unsigned fallbacks = 0;
+        CPPUNIT_ASSERT_MESSAGE(
+                "DROP should skip the timestep when the window is full.",
+                submitPastWindow(ams::WindowPolicy::DROP, &fallbacks) == ams::SubmitStatus::DROPPED);
+        CPPUNIT_ASSERT_EQUAL(0u, fallbacks);
+    }
+
+    void testSubmitFallback() {
+        unsigned fallbacks = 0;
+        CPPUNIT_ASSERT_MESSAGE(
+                "FALLBACK should hand the timestep to the fallback function.",
+                submitPastWindow(ams::WindowPolicy::FALLBACK, &fallbacks) == ams::SubmitStatus::FALLBACK);
+        CPPUNIT_ASSERT_EQUAL(1u, fallbacks);
+    }
+
+    void testGetLoad() {
+        ams::Client client(engine);
+        std::string addr = engine.self();
+
+        ams::NodeHandle my_node = client.makeNodeHandle(addr, 0, node_id);
+
+        ams::ServerLoad load;
+        load.queued_requests = 42;
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_node.ams_get_load() should not throw.",
+                my_node.ams_get_load(&load));
+        CPPUNIT_ASSERT_EQUAL((uint64_t)0, load.queued_requests);
+        CPPUNIT_ASSERT_EQUAL((uint64_t)0, load.queued_bytes);
+        CPPUNIT_ASSERT(not load.executing);
+
+        ams::AsyncRequest request;
+        CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                "my_node.ams_get_load() should not throw when called asynchronously.",
+                my_node.ams_get_load(&load, &request));
+        CPPUNIT_ASSERT_NO_THROW(request.wait());
+
+        auto bad_node = client.makeNodeHandle(addr, 0, ams::UUID::generate(), false);
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "ams_get_load should throw for an unknown node.",
+                bad_node.ams_get_load(&load),
+                ams::Exception);
+    }
+
+    void testLoadHint() {
+        ams::Client client(engine);
+        std::string addr = engine.self();
+
+        ams::NodeHandle my_node = client.makeNodeHandle(addr, 0, node_id);
+        ams::NodeHandle other_node = client.makeNodeHandle(addr, 0, node_id);
+
+        ams::LoadHint hint;
+        CPPUNIT_ASSERT_MESSAGE(
+                "no hint should be known before a request is answered.",
+                not my_node.loadHint(hint));
+
+        ams::ServerLoad load;
+        my_node.ams_get_load(&load);
+        double age = -1.0;
+        CPPUNIT_ASSERT(my_node.loadHint(hint, &age));
+        CPPUNIT_ASSERT(age >= 0.0);
+        CPPUNIT_ASSERT_EQUAL((uint32_t)0, hint.queue_depth);
+        CPPUNIT_ASSERT(not hint.memory_pressure);
+        CPPUNIT_ASSERT_MESSAGE(
+                "hints should be shared by the handles of a server.",
+                other_node.loadHint(hint));
+    }
+
+    void testSessions() {
+        ams::Admin admin(engine);
+        std::string addr = engine.self();
+        auto costmodel_id = admin.createNode(addr, 0, "costmodel", costmodel_config);
+        {
+            ams::Client client(engine);
+            ams::NodeHandle my_node = client.makeNodeHandle(addr, 0, costmodel_id);
+
+            conduit::Node open_opts, mesh, actions;
+            open_opts["task_id"] = 0;
+            conduit::blueprint::mesh::examples::braid("uniform", 10, 10, 10, mesh);
+            actions.append()["action"] = "add_scenes";
+
+            uint64_t session_id = 0;
+            CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                    "my_node.ams_open_session() should not throw.",
+                    my_node.ams_open_session(open_opts, &session_id));
+
+            uint64_t pipeline_id = 42, again = 43;
+            CPPUNIT_ASSERT_NO_THROW(
+                    my_node.ams_register_pipeline(session_id, "scenes", actions, &pipeline_id));
+            CPPUNIT_ASSERT_NO_THROW(
+                    my_node.ams_register_pipeline(session_id, "scenes", actions, &again));
+            CPPUNIT_ASSERT_EQUAL_MESSAGE(
+                    "registering a name again should keep its id.",
+                    pipeline_id, again);
+
+            CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                    "my_node.ams_session_publish() should not throw.",
+                    my_node.ams_session_publish(session_id, pipeline_id, mesh, 0));
+            CPPUNIT_ASSERT_THROW_MESSAGE(
+                    "ams_session_publish should throw for an unknown pipeline.",
+                    my_node.ams_session_publish(session_id, pipeline_id + 1, mesh, 1),
+                    ams::Exception);
+            CPPUNIT_ASSERT_THROW_MESSAGE(
+                    "ams_register_pipeline should throw for an unknown session.",
+                    my_node.ams_register_pipeline(session_id + 1, "scenes", actions, &again),
+                    ams::Exception);
+
+            CPPUNIT_ASSERT_NO_THROW_MESSAGE(
+                    "my_node.ams_close_session() should not throw.",
+                    my_node.ams_close_session(session_id));
+            CPPUNIT_ASSERT_THROW_MESSAGE(
+                    "ams_session_publish should throw for a closed session.",
+                    my_node.ams_session_publish(session_id, pipeline_id, mesh, 2),
+                    ams::Exception);
+            CPPUNIT_ASSERT_THROW_MESSAGE(
+                    "ams_close_session should throw for an unknown session.",
+                    my_node.ams_close_session(session_id),
+                    ams::Exception);
+        }
+        admin.destroyNode(addr, 0, costmodel_id);
+    }
+
 };
 CPPUNIT_TEST_SUITE_REGISTRATION( NodeTest );
@@ -0,0 +1,107 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include "RegistrationCache.hpp"
+#include <vector>
+
+extern thallium::engine engine;
+
+static const size_t ARRAY_SIZE = 64 * 1024;
+
+class RegistrationCacheTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( RegistrationCacheTest );
+    CPPUNIT_TEST( testHit );
+    CPPUNIT_TEST( testOverlap );
+    CPPUNIT_TEST( testEviction );
+    CPPUNIT_TEST( testDisabled );
+    CPPUNIT_TEST_SUITE_END();
+
+    public:
+
+    void setUp() {}
+    void tearDown() {}
+
+    void testHit() {
+        ams::RegistrationCache cache(engine);
+        cache.setCapacity(4 * ARRAY_SIZE);
+        std::vector<char> array(2 * ARRAY_SIZE);
+
+        cache.expose(array.data(), ARRAY_SIZE);
+        cache.expose(array.data(), ARRAY_SIZE);
+        CPPUNIT_ASSERT_EQUAL((size_t)1, cache.misses());
+        CPPUNIT_ASSERT_EQUAL((size_t)1, cache.hits());
+
+        cache.expose(array.data(), 2 * ARRAY_SIZE);
+        CPPUNIT_ASSERT_MESSAGE("a different size at the same address should not hit",
+                cache.misses() == 2);
+        cache.expose(array.data(), 2 * ARRAY_SIZE);
+        CPPUNIT_ASSERT_EQUAL((size_t)2, cache.hits());
+    }
+
+    void testOverlap() {
+        ams::RegistrationCache cache(engine);
+        cache.setCapacity(4 * ARRAY_SIZE);
+        std::vector<char> array(2 * ARRAY_SIZE);
+        std::vector<char> other(ARRAY_SIZE);
+
+        cache.expose(array.data(), ARRAY_SIZE);
+        cache.expose(other.data(), ARRAY_SIZE);
+        /* An array reallocated inside the first one */
+        cache.expose(array.data() + 1024, ARRAY_SIZE);
+        cache.expose(array.data(), ARRAY_SIZE);
+        CPPUNIT_ASSERT_MESSAGE("an overlapping array should drop the stale registration",
+                cache.misses() == 4);
+        cache.expose(other.data(), ARRAY_SIZE);
+        CPPUNIT_ASSERT_MESSAGE("arrays that do not overlap should be kept",
+                cache.hits() == 1);
+
+        cache.invalidate(array.data() + ARRAY_SIZE - 1, 1);
+        cache.expose(array.data(), ARRAY_SIZE);
+        CPPUNIT_ASSERT_EQUAL((size_t)5, cache.misses());
+        cache.invalidate(array.data() + ARRAY_SIZE, ARRAY_SIZE);
+        cache.expose(array.data(), ARRAY_SIZE);
+        CPPUNIT_ASSERT_MESSAGE("invalidating an adjacent range should keep the array",
+                cache.hits() == 2);
+    }
+
+    void testEviction() {
+        ams::RegistrationCache cache(engine);
+        cache.setCapacity(2 * ARRAY_SIZE);
+        std::vector<char> a(ARRAY_SIZE), b(ARRAY_SIZE), c(ARRAY_SIZE);
+
+        cache.expose(a.data(), ARRAY_SIZE);
+        cache.expose(b.data(), ARRAY_SIZE);
+        cache.expose(a.data(), ARRAY_SIZE);
+        cache.expose(c.data(), ARRAY_SIZE);
+        CPPUNIT_ASSERT_EQUAL((size_t)1, cache.hits());
+        CPPUNIT_ASSERT_EQUAL((size_t)3, cache.misses());
+
+        cache.expose(a.data(), ARRAY_SIZE);
+        cache.expose(c.data(), ARRAY_SIZE);
+        CPPUNIT_ASSERT_EQUAL((size_t)3, cache.hits());
+        cache.expose(b.data(), ARRAY_SIZE);
+        CPPUNIT_ASSERT_MESSAGE("the least recently used array should be evicted",
+                cache.misses() == 4);
+
+        cache.setCapacity(ARRAY_SIZE);
+        cache.expose(b.data(), ARRAY_SIZE);
+        cache.expose(c.data(), ARRAY_SIZE);
+        CPPUNIT_ASSERT_MESSAGE("lowering the capacity should keep the most recent array",
+                cache.hits() == 4 && cache.misses() == 5);
+    }
+
+    void testDisabled() {
+        ams::RegistrationCache cache(engine);
+        std::vector<char> array(ARRAY_SIZE);
+
+        cache.expose(array.data(), ARRAY_SIZE);
+        cache.expose(array.data(), ARRAY_SIZE);
+        CPPUNIT_ASSERT_EQUAL((size_t)0, cache.hits());
+        CPPUNIT_ASSERT_EQUAL((size_t)2, cache.misses());
+    }
+};
+CPPUNIT_TEST_SUITE_REGISTRATION( RegistrationCacheTest );
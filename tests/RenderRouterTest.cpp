@@ -0,0 +1,106 @@
+/*
+ * (C) 2020 The University of Chicago
+ * 
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <ams/Client.hpp>
+#include <ams/Admin.hpp>
+#include <ams/RenderRouter.hpp>
+#include <conduit_blueprint.hpp>
+#include <chrono>
+#include <thread>
+
+extern thallium::engine engine;
+
+class RenderRouterTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( RenderRouterTest );
+    CPPUNIT_TEST( testRequiresInlineFunction );
+    CPPUNIT_TEST( testSwitchingAndProbing );
+    CPPUNIT_TEST_SUITE_END();
+
+    static constexpr const char* node_config =
+        "{ \"path\" : \"mydb\", \"cost_model\" : { \"base_ms\" : 1.0 } }";
+    ams::UUID node_id;
+
+    conduit::Node open_opts, mesh, actions;
+
+    public:
+
+    void setUp() {
+        ams::Admin admin(engine);
+        std::string addr = engine.self();
+        node_id = admin.createNode(addr, 0, "costmodel", node_config);
+        conduit::blueprint::mesh::examples::braid("uniform", 10, 10, 10, mesh);
+        actions.append()["action"] = "add_scenes";
+    }
+
+    void tearDown() {
+        ams::Admin admin(engine);
+        std::string addr = engine.self();
+        admin.destroyNode(addr, 0, node_id);
+    }
+
+    void testRequiresInlineFunction() {
+        ams::Client client(engine);
+        ams::NodeHandle node = client.makeNodeHandle(engine.self(), 0, node_id);
+        CPPUNIT_ASSERT_THROW_MESSAGE(
+                "RenderRouter should throw without an inline function.",
+                ams::RenderRouter(node, ams::InlineFunction()),
+                ams::Exception);
+    }
+
+    /* The server load is reported by hand: its hints are only taken
+     * into account when they are more recent than the reported load. */
+    void testSwitchingAndProbing() {
+        ams::Client client(engine);
+        ams::NodeHandle node = client.makeNodeHandle(engine.self(), 0, node_id);
+
+        ams::RenderRouterConfig config;
+        config.max_in_flight  = 1;
+        config.min_dwell      = 1;
+        config.probe_interval = 3;
+        config.max_load_age   = 1000.0;
+        unsigned inline_renders = 0;
+        ams::RenderRouter router(node,
+            [&inline_renders](const conduit::Node&, const conduit::Node&, const conduit::Node&) {
+                inline_renders += 1;
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            }, config, MPI_COMM_WORLD);
+
+        CPPUNIT_ASSERT_MESSAGE(
+                "timesteps should go in transit until a request completed.",
+                router.submit(open_opts, mesh, actions, 0) == ams::RenderPath::IN_TRANSIT);
+        router.flush();
+
+        /* A saturated server makes the inline path cheaper */
+        router.reportServerLoad(10, 100.0);
+        CPPUNIT_ASSERT(router.submit(open_opts, mesh, actions, 1) == ams::RenderPath::INLINE);
+        CPPUNIT_ASSERT(router.currentPath() == ams::RenderPath::INLINE);
+        CPPUNIT_ASSERT_EQUAL((size_t)1, router.stats().switches);
+        CPPUNIT_ASSERT(router.submit(open_opts, mesh, actions, 2) == ams::RenderPath::INLINE);
+
+        /* Every probe_interval-th inline timestep probes the server */
+        CPPUNIT_ASSERT_MESSAGE(
+                "the third timestep on the inline path should be a probe.",
+                router.submit(open_opts, mesh, actions, 3) == ams::RenderPath::IN_TRANSIT);
+        CPPUNIT_ASSERT(router.currentPath() == ams::RenderPath::INLINE);
+        CPPUNIT_ASSERT_EQUAL((size_t)1, router.stats().probes);
+        router.flush();
+
+        /* Once the server has drained, in transit is cheaper again */
+        router.reportServerLoad(0, 0.0);
+        CPPUNIT_ASSERT(router.submit(open_opts, mesh, actions, 4) == ams::RenderPath::IN_TRANSIT);
+        CPPUNIT_ASSERT(router.currentPath() == ams::RenderPath::IN_TRANSIT);
+        CPPUNIT_ASSERT_EQUAL((size_t)2, router.stats().switches);
+        router.flush();
+
+        const ams::RenderRouterStats& stats = router.stats();
+        CPPUNIT_ASSERT_EQUAL((size_t)2, stats.inline_renders);
+        CPPUNIT_ASSERT_EQUAL((size_t)3, stats.in_transit);
+        CPPUNIT_ASSERT_EQUAL(2u, inline_renders);
+    }
+
+};
+CPPUNIT_TEST_SUITE_REGISTRATION( RenderRouterTest );
@@ -0,0 +1,113 @@
+/*
+ * (C) 2020 The University of Chicago
+ * 
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <ams/Scheduler.hpp>
+
+class SchedulerTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( SchedulerTest );
+    CPPUNIT_TEST( testTimestepOrder );
+    CPPUNIT_TEST( testPolicyChange );
+    CPPUNIT_TEST( testServerModes );
+    CPPUNIT_TEST( testMemoryAccounting );
+    CPPUNIT_TEST( testDataNotHeld );
+    CPPUNIT_TEST_SUITE_END();
+
+    public:
+
+    void setUp() {}
+    void tearDown() {}
+
+    void testTimestepOrder() {
+        ams::Scheduler<int> scheduler;
+        scheduler.push(1, 5, 100);
+        scheduler.push(2, 3, 200);
+        scheduler.push(3, 3, 50);
+
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("bytes() should sum queued bytes",
+                (size_t)350, scheduler.bytes());
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("lowest timestep first, ties in arrival order",
+                2, scheduler.pop());
+        CPPUNIT_ASSERT_EQUAL(3, scheduler.pop());
+        CPPUNIT_ASSERT_EQUAL(1, scheduler.pop());
+        CPPUNIT_ASSERT(scheduler.empty());
+        CPPUNIT_ASSERT_EQUAL((size_t)0, scheduler.bytes());
+    }
+
+    void testPolicyChange() {
+        ams::Scheduler<int> scheduler;
+        scheduler.push(1, 5, 100);
+        scheduler.push(2, 3, 200);
+        scheduler.push(3, 4, 50);
+
+        ams::SchedulerConfig config;
+        config.policy = ams::QueuePolicy::SMALLEST;
+        scheduler.setConfig(config);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("smallest mesh first after policy change",
+                3, scheduler.top());
+
+        config.policy = ams::QueuePolicy::FIFO;
+        scheduler.setConfig(config);
+        CPPUNIT_ASSERT_EQUAL(1, scheduler.pop());
+        CPPUNIT_ASSERT_EQUAL(2, scheduler.pop());
+        CPPUNIT_ASSERT_EQUAL(3, scheduler.pop());
+    }
+
+    void testServerModes() {
+        ams::SchedulerConfig config;
+        config.lazyish_threshold = 5;
+
+        config.mode = ams::parse_server_mode("eager");
+        CPPUNIT_ASSERT(ams::Scheduler<int>(config).shouldExecute(100));
+
+        config.mode = ams::parse_server_mode("1");
+        CPPUNIT_ASSERT(!ams::Scheduler<int>(config).shouldExecute(0));
+
+        config.mode = ams::parse_server_mode("lazyish");
+        CPPUNIT_ASSERT(ams::Scheduler<int>(config).shouldExecute(4));
+        CPPUNIT_ASSERT(!ams::Scheduler<int>(config).shouldExecute(5));
+
+        CPPUNIT_ASSERT_THROW(ams::parse_server_mode("sometimes"), std::invalid_argument);
+    }
+
+    void testMemoryAccounting() {
+        ams::SchedulerConfig config;
+        config.memory_limit = 1000;
+        ams::Scheduler<int> scheduler(config);
+
+        scheduler.push(1, 0, 300);
+        scheduler.retain(500);
+        CPPUNIT_ASSERT_EQUAL((size_t)300, scheduler.bytes());
+        CPPUNIT_ASSERT_EQUAL((size_t)500, scheduler.residentBytes());
+        CPPUNIT_ASSERT_EQUAL((size_t)800, scheduler.totalBytes());
+        CPPUNIT_ASSERT(scheduler.admits(200));
+        CPPUNIT_ASSERT_MESSAGE("queued and resident data share the limit",
+                !scheduler.admits(201));
+
+        scheduler.pop();
+        scheduler.release(500);
+        CPPUNIT_ASSERT_EQUAL((size_t)0, scheduler.totalBytes());
+        CPPUNIT_ASSERT(scheduler.admits(1000));
+    }
+
+    void testDataNotHeld() {
+        ams::SchedulerConfig config;
+        config.policy = ams::QueuePolicy::SMALLEST;
+        config.memory_limit = 1000;
+        ams::Scheduler<int> scheduler(config);
+
+        scheduler.push(1, 0, 900, false);
+        scheduler.push(2, 0, 100);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("data left on the client is not held",
+                (size_t)100, scheduler.bytes());
+        CPPUNIT_ASSERT(scheduler.admits(900));
+        CPPUNIT_ASSERT_EQUAL(2, scheduler.pop());
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("its size still orders the queue",
+                1, scheduler.pop());
+        CPPUNIT_ASSERT_EQUAL((size_t)0, scheduler.bytes());
+    }
+};
+CPPUNIT_TEST_SUITE_REGISTRATION( SchedulerTest );
@@ -0,0 +1,53 @@
+/*
+ * (C) 2020 The University of Chicago
+ * 
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <ams/ServiceDirectory.hpp>
+#include <ams/Exception.hpp>
+
+class ServiceDirectoryTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( ServiceDirectoryTest );
+    CPPUNIT_TEST( testParse );
+    CPPUNIT_TEST( testMalformed );
+    CPPUNIT_TEST_SUITE_END();
+
+    public:
+
+    void setUp() {}
+    void tearDown() {}
+
+    void testParse() {
+        ams::UUID id0 = ams::UUID::generate();
+        ams::UUID id1 = ams::UUID::generate();
+        auto directory = ams::ServiceDirectory::parse(
+                "2\n0 na+sm://1-0\n0 na+sm://2-0\n",
+                id0.to_string() + "\n" + id1.to_string() + "\n");
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("the directory should list 2 ranks",
+                (size_t)2, directory.size());
+        CPPUNIT_ASSERT_EQUAL(std::string("na+sm://2-0"), directory[1].address);
+        CPPUNIT_ASSERT_EQUAL(0, directory[1].instance_rank);
+        CPPUNIT_ASSERT_EQUAL(id1.to_string(), directory[1].node_id.to_string());
+
+        auto addresses_only = ams::ServiceDirectory::parse("1\n0 ofi+tcp://10.0.0.1:1234\n");
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("the whole address should be kept",
+                std::string("ofi+tcp://10.0.0.1:1234"), addresses_only[0].address);
+    }
+
+    void testMalformed() {
+        CPPUNIT_ASSERT_THROW_MESSAGE("a missing rank count should be rejected",
+                ams::ServiceDirectory::parse("0 na+sm://1-0\n"), ams::Exception);
+        CPPUNIT_ASSERT_THROW_MESSAGE("missing ranks should be rejected",
+                ams::ServiceDirectory::parse("2\n0 na+sm://1-0\n"), ams::Exception);
+        CPPUNIT_ASSERT_THROW_MESSAGE("missing nodes should be rejected",
+                ams::ServiceDirectory::parse("2\n0 na+sm://1-0\n1 na+sm://2-0\n",
+                                             ams::UUID::generate().to_string() + "\n"),
+                ams::Exception);
+        CPPUNIT_ASSERT_THROW_MESSAGE("malformed node ids should be rejected",
+                ams::ServiceDirectory::parse("1\n0 na+sm://1-0\n", "blabla\n"),
+                ams::Exception);
+    }
+};
+CPPUNIT_TEST_SUITE_REGISTRATION( ServiceDirectoryTest );
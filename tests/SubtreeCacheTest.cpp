@@ -0,0 +1,216 @@
+/*
+ * (C) 2020 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include "SubtreeRefs.hpp"
+#include "dummy/SubtreeCache.hpp"
+#include <stdexcept>
+#include <vector>
+
+class SubtreeCacheTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( SubtreeCacheTest );
+    CPPUNIT_TEST( testHashThenRef );
+    CPPUNIT_TEST( testDropAfterInFlight );
+    CPPUNIT_TEST( testForget );
+    CPPUNIT_TEST( testClients );
+    CPPUNIT_TEST_SUITE_END();
+
+    public:
+
+    void setUp() {}
+    void tearDown() {}
+
+    /* A coordset above the default 4 KiB threshold and a topology below it */
+    static conduit::Node make_mesh(double offset) {
+        std::vector<double> x(1024), y(1024);
+        for(size_t i = 0; i < x.size(); i++) {
+            x[i] = offset + i;
+            y[i] = offset - i;
+        }
+        conduit::Node mesh;
+        mesh["coordsets/coords/type"] = "explicit";
+        mesh["coordsets/coords/values/x"].set(x);
+        mesh["coordsets/coords/values/y"].set(y);
+        mesh["topologies/topo/type"] = "points";
+        mesh["topologies/topo/coordset"] = "coords";
+        return mesh;
+    }
+
+    /* Sends the view the way meshes are sent, and resolves it the way
+     * the dummy backend does */
+    static conduit::Node transfer(const conduit::Node& view, SubtreeCache& cache,
+                                  SubtreeCache::Held& held) {
+        conduit::Node received;
+        received.parse(view.to_string("conduit_base64_json"), "conduit_base64_json");
+        cache.resolve(received, held);
+        return received;
+    }
+
+    static bool same_coords(const conduit::Node& a, const conduit::Node& b) {
+        conduit::Node info;
+        return !a["coordsets/coords"].diff(b["coordsets/coords"], info);
+    }
+
+    void testHashThenRef() {
+        SubtreeCache cache;
+        SubtreeCache::Held held;
+        ams::SubtreeRefs refs;
+        refs.m_client_id = "client";
+        conduit::Node mesh = make_mesh(0.0);
+        conduit::Node view;
+        ams::SubtreeRefs::Carried carried;
+
+        CPPUNIT_ASSERT_MESSAGE("a coordset seen for the first time should be sent as is",
+                !refs.encode(mesh, view, carried));
+        CPPUNIT_ASSERT(!refs.used());
+
+        CPPUNIT_ASSERT(refs.encode(mesh, view, carried));
+        CPPUNIT_ASSERT(view["coordsets/coords"].has_child("ams_hash"));
+        CPPUNIT_ASSERT(view["coordsets/coords"].has_child("values"));
+        CPPUNIT_ASSERT_MESSAGE("small topologies should never be marked",
+                !view["topologies/topo"].has_child("ams_hash"));
+        CPPUNIT_ASSERT_EQUAL((size_t)1, carried.m_stored.size());
+        CPPUNIT_ASSERT(refs.used());
+
+        conduit::Node received = transfer(view, cache, held);
+        CPPUNIT_ASSERT(!received["coordsets/coords"].has_child("ams_hash"));
+        CPPUNIT_ASSERT(same_coords(mesh, received));
+        CPPUNIT_ASSERT_EQUAL(mesh["coordsets/coords"].total_bytes_compact(), cache.bytes());
+        refs.complete(carried, true);
+
+        CPPUNIT_ASSERT(refs.encode(mesh, view, carried));
+        CPPUNIT_ASSERT(view["coordsets/coords"].has_child("ams_ref"));
+        CPPUNIT_ASSERT_MESSAGE("a referenced coordset should not be sent",
+                !view["coordsets/coords"].has_child("values"));
+        received = transfer(view, cache, held);
+        CPPUNIT_ASSERT(same_coords(mesh, received));
+        refs.complete(carried, true);
+    }
+
+    void testDropAfterInFlight() {
+        SubtreeCache cache;
+        SubtreeCache::Held held;
+        ams::SubtreeRefs refs;
+        refs.m_client_id = "client";
+        conduit::Node a = make_mesh(0.0);
+        conduit::Node b = make_mesh(1.0);
+        /* Room for a single coordset on the client side */
+        refs.m_capacity = a["coordsets/coords"].total_bytes_compact();
+        conduit::Node view;
+        ams::SubtreeRefs::Carried carried, in_flight;
+
+        refs.encode(a, view, carried);
+        CPPUNIT_ASSERT(refs.encode(a, view, carried));
+        transfer(view, cache, held);
+        refs.complete(carried, true);
+
+        CPPUNIT_ASSERT(refs.encode(a, view, in_flight));
+        CPPUNIT_ASSERT(view["coordsets/coords"].has_child("ams_ref"));
+        transfer(view, cache, held);
+
+        /* Storing b evicts a, which the request in flight still refers to */
+        CPPUNIT_ASSERT(!refs.encode(b, view, carried));
+        CPPUNIT_ASSERT(refs.encode(b, view, carried));
+        transfer(view, cache, held);
+        refs.complete(carried, true);
+
+        CPPUNIT_ASSERT(refs.encode(b, view, carried));
+        CPPUNIT_ASSERT_MESSAGE("a should not be dropped while a request refers to it",
+                !view["coordsets/coords"].has_child("ams_drop"));
+        CPPUNIT_ASSERT(carried.m_dropped.empty());
+        transfer(view, cache, held);
+        refs.complete(carried, true);
+
+        refs.complete(in_flight, true);
+        CPPUNIT_ASSERT(refs.encode(b, view, carried));
+        CPPUNIT_ASSERT(view["coordsets/coords"].has_child("ams_drop"));
+        CPPUNIT_ASSERT_EQUAL((conduit::index_t)1,
+                view["coordsets/coords/ams_drop"].number_of_children());
+        CPPUNIT_ASSERT_EQUAL((size_t)1, carried.m_dropped.size());
+        CPPUNIT_ASSERT_EQUAL(ams::hash_subtree(a["coordsets/coords"]), carried.m_dropped[0]);
+        conduit::Node received = transfer(view, cache, held);
+        CPPUNIT_ASSERT(same_coords(b, received));
+        CPPUNIT_ASSERT_EQUAL(b["coordsets/coords"].total_bytes_compact(), cache.bytes());
+        refs.complete(carried, true);
+    }
+
+    void testForget() {
+        SubtreeCache cache;
+        SubtreeCache::Held held;
+        ams::SubtreeRefs refs;
+        refs.m_client_id = "client";
+        conduit::Node mesh = make_mesh(0.0);
+        conduit::Node view;
+        ams::SubtreeRefs::Carried carried;
+
+        refs.encode(mesh, view, carried);
+        refs.encode(mesh, view, carried);
+        transfer(view, cache, held);
+        refs.complete(carried, true);
+
+        /* The server lost the client's subtrees (e.g. it restarted) */
+        cache.release("client");
+        CPPUNIT_ASSERT(refs.encode(mesh, view, carried));
+        CPPUNIT_ASSERT(view["coordsets/coords"].has_child("ams_ref"));
+        CPPUNIT_ASSERT_THROW(transfer(view, cache, held), std::runtime_error);
+        refs.complete(carried, false);
+        refs.forget();
+
+        CPPUNIT_ASSERT(refs.encode(mesh, view, carried));
+        CPPUNIT_ASSERT_MESSAGE("a forgotten coordset should be sent again",
+                view["coordsets/coords"].has_child("ams_hash"));
+        CPPUNIT_ASSERT(view["coordsets/coords"].has_child("values"));
+        conduit::Node received = transfer(view, cache, held);
+        CPPUNIT_ASSERT(same_coords(mesh, received));
+        refs.complete(carried, true);
+
+        CPPUNIT_ASSERT(refs.encode(mesh, view, carried));
+        CPPUNIT_ASSERT(view["coordsets/coords"].has_child("ams_ref"));
+        received = transfer(view, cache, held);
+        CPPUNIT_ASSERT(same_coords(mesh, received));
+        refs.complete(carried, true);
+    }
+
+    void testClients() {
+        SubtreeCache cache;
+        cache.setMaxClients(1);
+        SubtreeCache::Held held;
+        ams::SubtreeRefs first, second;
+        first.m_client_id  = "first";
+        second.m_client_id = "second";
+        conduit::Node mesh = make_mesh(0.0);
+        conduit::Node view;
+        ams::SubtreeRefs::Carried carried;
+
+        first.encode(mesh, view, carried);
+        first.encode(mesh, view, carried);
+        transfer(view, cache, held);
+        first.complete(carried, true);
+        CPPUNIT_ASSERT_EQUAL((size_t)1, cache.clients());
+
+        second.encode(mesh, view, carried);
+        second.encode(mesh, view, carried);
+        transfer(view, cache, held);
+        second.complete(carried, true);
+        CPPUNIT_ASSERT_MESSAGE("the least recently used client should be dropped",
+                cache.clients() == 1);
+        CPPUNIT_ASSERT_EQUAL(mesh["coordsets/coords"].total_bytes_compact(), cache.bytes());
+
+        first.encode(mesh, view, carried);
+        CPPUNIT_ASSERT_THROW(transfer(view, cache, held), std::runtime_error);
+        first.complete(carried, false);
+
+        second.encode(mesh, view, carried);
+        conduit::Node received = transfer(view, cache, held);
+        CPPUNIT_ASSERT(same_coords(mesh, received));
+        second.complete(carried, true);
+
+        cache.release("second");
+        CPPUNIT_ASSERT_EQUAL((size_t)0, cache.clients());
+        CPPUNIT_ASSERT_EQUAL((size_t)0, cache.bytes());
+    }
+};
+CPPUNIT_TEST_SUITE_REGISTRATION( SubtreeCacheTest );
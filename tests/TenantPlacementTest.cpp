@@ -0,0 +1,116 @@
+/*
+ * (C) 2020 The University of Chicago
+ * 
+ * See COPYRIGHT in top-level directory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <ams/TenantPlacement.hpp>
+#include <ams/Exception.hpp>
+#include <algorithm>
+
+class TenantPlacementTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( TenantPlacementTest );
+    CPPUNIT_TEST( testStable );
+    CPPUNIT_TEST( testLoadAware );
+    CPPUNIT_TEST( testConsistent );
+    CPPUNIT_TEST( testCollective );
+    CPPUNIT_TEST_SUITE_END();
+
+    static std::vector<ams::InstanceInfo> make_instances(size_t count, size_t ranks) {
+        std::vector<ams::InstanceInfo> instances(count);
+        for(size_t i = 0; i < count; i++) {
+            for(size_t r = 0; r < ranks; r++) {
+                ams::ServiceMember member;
+                member.instance_rank = (int)r;
+                member.address = "na+sm://" + std::to_string(i) + "-" + std::to_string(r);
+                instances[i].members.push_back(member);
+            }
+        }
+        return instances;
+    }
+
+    public:
+
+    void setUp() {}
+    void tearDown() {}
+
+    void testStable() {
+        ams::TenantPlacement placement(make_instances(4, 2));
+        size_t instance = placement.place("sim0");
+        for(int i = 0; i < 10; i++)
+            placement.place("other" + std::to_string(i));
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("a tenant should keep its instance",
+                instance, placement.place("sim0"));
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("a tenant rank should map to the same instance rank",
+                placement.instances()[instance].members[1].address,
+                placement.member("sim0", 1, 2).address);
+        CPPUNIT_ASSERT_THROW_MESSAGE("a tenant should have as many ranks as its instance",
+                placement.member("sim0", 3, 4), ams::Exception);
+        CPPUNIT_ASSERT_THROW_MESSAGE("a tenant rank should be below its number of ranks",
+                placement.member("sim0", 2, 2), ams::Exception);
+        CPPUNIT_ASSERT_THROW_MESSAGE("a placement needs instances",
+                ams::TenantPlacement(std::vector<ams::InstanceInfo>()), ams::Exception);
+    }
+
+    void testLoadAware() {
+        auto instances = make_instances(4, 1);
+        instances[2].load.queued_requests = 100;
+        ams::TenantPlacement placement(instances);
+        std::vector<size_t> count(4, 0);
+        for(int t = 0; t < 40; t++)
+            count[placement.place("sim" + std::to_string(t))] += 1;
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("no tenant should go to the overloaded instance",
+                (size_t)0, count[2]);
+        for(size_t i : { 0, 1, 3 }) {
+            CPPUNIT_ASSERT_MESSAGE("tenants should be spread evenly",
+                    count[i] >= 10 && count[i] <= 17);
+        }
+    }
+
+    void testConsistent() {
+        /* Without load balancing, removing an instance only moves its tenants */
+        ams::PlacementConfig config;
+        config.choices = 1;
+        config.load_bound = 1e9;
+        auto instances = make_instances(4, 1);
+        ams::TenantPlacement before(instances, config);
+        instances.pop_back();
+        ams::TenantPlacement after(instances, config);
+        for(int t = 0; t < 200; t++) {
+            std::string tenant = "sim" + std::to_string(t);
+            size_t instance = before.place(tenant);
+            if(instance != 3)
+                CPPUNIT_ASSERT_EQUAL_MESSAGE("only the tenants of the removed instance should move",
+                        instance, after.place(tenant));
+        }
+    }
+
+    void testCollective() {
+        int rank, size;
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Comm_size(MPI_COMM_WORLD, &size);
+        auto instances = make_instances(4, (size_t)size);
+        ams::TenantPlacement placement(instances);
+        /* Other ranks list the instances in another order */
+        std::reverse(instances.begin(), instances.end());
+        ams::TenantPlacement local(instances);
+        ams::TenantPlacement& mine = rank == 0 ? placement : local;
+        size_t instance = mine.place("sim0", MPI_COMM_WORLD);
+        std::string address = mine.instances()[instance].members[0].address;
+        std::string expected = rank == 0 ? address : "";
+        int length = (int)expected.size();
+        MPI_Bcast(&length, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        expected.resize(length);
+        MPI_Bcast(&expected[0], length, MPI_CHAR, 0, MPI_COMM_WORLD);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("every rank should agree on the instance",
+                expected, address);
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("the collective placement should be remembered",
+                instance, mine.place("sim0"));
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("each rank should map to its instance rank",
+                mine.instances()[instance].members[rank].address,
+                mine.member("sim0", rank, size).address);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TenantPlacementTest );